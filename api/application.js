@@ -103,6 +103,19 @@ export async function getScreenSize () {
   return data
 }
 
+/**
+ * Returns metrics for the queue of callbacks dispatched to the main thread.
+ * Drain times are in microseconds.
+ * @returns {Promise<{ depth: number, maxDepth: number, dispatched: number, drains: number, lastDrainTime: number, maxDrainTime: number }>}
+ */
+export async function getDispatchQueueMetrics () {
+  const { data, err } = await ipc.send('application.getDispatchQueueMetrics', { index: globalThis.__args.index })
+  if (err) {
+    throw err
+  }
+  return data
+}
+
 function throwOnInvalidIndex (index) {
   if (index === undefined || typeof index !== 'number' || !Number.isInteger(index) || index < 0) {
     throw new Error(`Invalid window index: ${index} (must be a positive integer number)`)
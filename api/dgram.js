@@ -16,7 +16,7 @@ import { EventEmitter } from './events.js'
 import diagnostics from './diagnostics.js'
 import { Buffer } from './buffer.js'
 import { rand64 } from './crypto.js'
-import { isIPv4 } from './net.js'
+import { isIP, isIPv4 } from './net.js'
 import process from './process.js'
 import console from './console.js'
 import ipc from './ipc.js'
@@ -73,11 +73,34 @@ function createDataListener (socket) {
       const message = Buffer.from(buffer)
       const info = {
         ...data,
-        family: getAddressFamily(data.address)
+        family: data.family ?? getAddressFamily(data.address)
       }
 
-      socket.emit('message', message, info)
-      dc.channel('message').publish({ socket, buffer: message, info })
+      // coalesced datagrams (GRO) arrive as one buffer of `segmentSize`
+      // sized segments, the last of which may be shorter
+      if (data.segmentSize) {
+        const segmentSize = Number(data.segmentSize)
+        delete info.segmentSize
+
+        for (let offset = 0; offset < message.length; offset += segmentSize) {
+          const segment = message.subarray(offset, offset + segmentSize)
+          const segmentInfo = { ...info, bytes: String(segment.length) }
+          socket.emit('message', segment, segmentInfo)
+          dc.channel('message').publish({ socket, buffer: segment, info: segmentInfo })
+        }
+      } else {
+        socket.emit('message', message, info)
+        dc.channel('message').publish({ socket, buffer: message, info })
+      }
+    }
+
+    if (source === 'udp.keepalive') {
+      socket.emit('keepalive', {
+        address: data.address,
+        port: Number(data.port),
+        reachable: data.reachable === true,
+        idle: data.idle ?? null
+      })
     }
 
     if (data.EOF) {
@@ -86,6 +109,21 @@ function createDataListener (socket) {
   }
 }
 
+// `address:port` entries for the `udp.keepalive*` routes
+function formatEndpoints (targets) {
+  return [].concat(targets).map(({ address, port }) => {
+    if (!isIP(address)) {
+      throw new TypeError(`Keepalive target address must be an IP address, received '${address}'`)
+    }
+
+    if (!Number.isInteger(port) || port <= 0 || port >= MAX_PORT) {
+      throw new ERR_SOCKET_BAD_PORT()
+    }
+
+    return `${isIPv4(address) ? address : `[${address}]`}:${port}`
+  }).join(',')
+}
+
 function destroyDataListener (socket) {
   if (typeof socket?.dataListener === 'function') {
     globalThis.removeEventListener('data', socket.dataListener)
@@ -118,10 +156,20 @@ function getDefaultAddress (socket) {
   return null
 }
 
+function getDefaultBindAddress (socket) {
+  // `::` is dual-stack unless `ipv6Only` is set
+  if (socket.type === 'udp6') return '::'
+  return getDefaultAddress(socket)
+}
+
 function getAddressFamily (address) {
   return isIPv4(address) ? 'IPv4' : 'IPv6'
 }
 
+function getLookupFamily (socket) {
+  return socket.type === 'udp6' ? 6 : 4
+}
+
 function getSocketState (socket) {
   const result = ipc.sendSync('udp.getState', { id: socket.id })
 
@@ -231,14 +279,14 @@ async function bind (socket, options, callback) {
   }
 
   if (typeof options.address !== 'string') {
-    options.address = getDefaultAddress(socket)
+    options.address = getDefaultBindAddress(socket)
   }
 
   socket.state.bindState = BIND_STATE_BINDING
 
-  if (typeof options.address === 'string' && !isIPv4(options.address)) {
+  if (typeof options.address === 'string' && !isIP(options.address)) {
     try {
-      options.address = await dns.lookup(options.address, 4)
+      options.address = await dns.lookup(options.address, getLookupFamily(socket))
     } catch (err) {
       socket.state.bindState = BIND_STATE_UNBOUND
       callback(err)
@@ -252,7 +300,8 @@ async function bind (socket, options, callback) {
       port: options.port || 0,
       address: options.address,
       ipv6Only: !!options.ipv6Only,
-      reuseAddr: !!options.reuseAddr
+      reuseAddr: !!options.reuseAddr,
+      gro: socket.state.gro
     })
 
     socket.state.bindState = BIND_STATE_BOUND
@@ -314,9 +363,9 @@ async function connect (socket, options, callback) {
 
   socket.state.connectState = CONNECT_STATE_CONNECTING
 
-  if (typeof options.address === 'string' && !isIPv4(options.address)) {
+  if (typeof options.address === 'string' && !isIP(options.address)) {
     try {
-      options.address = await dns.lookup(options.address, 4)
+      options.address = await dns.lookup(options.address, getLookupFamily(socket))
     } catch (err) {
       socket.state.connectState = CONNECT_STATE_DISCONNECTED
       callback(err)
@@ -453,12 +502,12 @@ async function send (socket, options, callback) {
   }
 
   if (
-    !isIPv4(options.address) &&
+    !isIP(options.address) &&
     typeof options.address === 'string' &&
     socket.state.connectState !== CONNECT_STATE_CONNECTED
   ) {
     try {
-      options.address = await dns.lookup(options.address, 4)
+      options.address = await dns.lookup(options.address, getLookupFamily(socket))
     } catch (err) {
       callback(err)
       return { err }
@@ -504,7 +553,10 @@ async function send (socket, options, callback) {
     result = await ipc.write('udp.send', {
       id: socket.id,
       port: options.port,
-      address: options.address
+      address: options.address,
+      segmentSize: options.buffer.length > socket.state.segmentSize
+        ? socket.state.segmentSize
+        : 0
     }, options.buffer)
 
     callback(result.err, result.data)
@@ -614,6 +666,8 @@ function getSockName (socket, callback) {
  * @param {string=} options.type - The family of socket. Must be either 'udp4' or 'udp6'. Required.
  * @param {boolean=} [options.reuseAddr=false] - When true socket.bind() will reuse the address, even if another process has already bound a socket on it. Default: false.
  * @param {boolean=} [options.ipv6Only=false] - Default: false.
+ * @param {number=} [options.segmentSize=0] - Sends larger than this are split into datagrams of this size, with UDP segmentation offload where supported. Default: 0 (disabled).
+ * @param {boolean=} [options.gro=false] - Receive coalesced datagrams (UDP GRO) where supported, still emitted as one 'message' per datagram. Default: false.
  * @param {number=} options.recvBufferSize - Sets the SO_RCVBUF socket value.
  * @param {number=} options.sendBufferSize - Sets the SO_SNDBUF socket value.
  * @param {AbortSignal=} options.signal - An AbortSignal that may be used to close a socket.
@@ -651,7 +705,11 @@ export class Socket extends EventEmitter {
       bindState: BIND_STATE_UNBOUND,
       connectState: CONNECT_STATE_DISCONNECTED,
       reuseAddr: options.reuseAddr === true,
-      ipv6Only: options.ipv6Only === true
+      ipv6Only: options.ipv6Only === true,
+      segmentSize: Number.isInteger(options.segmentSize) && options.segmentSize > 0
+        ? options.segmentSize
+        : 0,
+      gro: options.gro === true
     }
 
     if (isFunction(callback)) {
@@ -1087,6 +1145,87 @@ export class Socket extends EventEmitter {
     }
   }
 
+  /**
+   * Sends `options.payload` to each of `targets` from native timers, so NAT
+   * mappings stay open without a round trip through JavaScript, even while
+   * the page is throttled. Targets that have not answered yet are probed
+   * every `options.punchInterval` milliseconds, up to `options.punchAttempts`
+   * times, to open a path through the NAT. A 'keepalive' event is emitted when
+   * a target becomes reachable or stops answering.
+   *
+   * > Note: This is a socket runtime extension.
+   *
+   * @param {Array<{ address: string, port: number }>} targets
+   * @param {Object=} [options]
+   * @param {Buffer|string=} [options.payload] - The keepalive datagram
+   * @param {number=} [options.interval=25000] - Milliseconds between keepalives
+   * @param {number=} [options.timeout] - Milliseconds without a datagram before a target is unreachable, 3 intervals by default
+   * @param {number=} [options.punchAttempts=8]
+   * @param {number=} [options.punchInterval=500]
+   * @return {Promise<number>} The number of scheduled targets
+   */
+  async startKeepalive (targets, options = {}) {
+    if (this.state.bindState !== BIND_STATE_BOUND) {
+      throw new ERR_SOCKET_DGRAM_NOT_RUNNING()
+    }
+
+    const params = { id: this.id, targets: formatEndpoints(targets) }
+
+    for (const key of ['interval', 'timeout', 'punchAttempts', 'punchInterval']) {
+      if (Number.isInteger(options[key])) {
+        params[key] = options[key]
+      }
+    }
+
+    const result = options.payload
+      ? await ipc.write('udp.keepaliveStart', params, Buffer.from(options.payload))
+      : await ipc.send('udp.keepaliveStart', params)
+
+    if (result.err) {
+      throw result.err
+    }
+
+    return result.data.targets
+  }
+
+  /**
+   * Stops native keepalives to `targets`, or to every target when omitted.
+   *
+   * > Note: This is a socket runtime extension.
+   *
+   * @param {Array<{ address: string, port: number }>=} [targets]
+   * @return {Promise<number>} The number of targets left
+   */
+  async stopKeepalive (targets = []) {
+    const result = await ipc.send('udp.keepaliveStop', {
+      id: this.id,
+      targets: formatEndpoints(targets)
+    })
+
+    if (result.err) {
+      throw result.err
+    }
+
+    return result.data.targets
+  }
+
+  /**
+   * Returns the native keepalive targets and their reachability.
+   *
+   * > Note: This is a socket runtime extension.
+   *
+   * @return {Promise<Array<Object>>}
+   */
+  async getKeepaliveState () {
+    const result = await ipc.send('udp.keepaliveGetState', { id: this.id })
+
+    if (result.err) {
+      throw result.err
+    }
+
+    return result.data.targets
+  }
+
   /**
    * @see {@link https://nodejs.org/api/dgram.html#socketgetrecvbuffersize}
    */
@@ -54,6 +54,7 @@ const dc = diagnostics.channels.group('dns', [
  * @param {string} hostname - The host name to resolve.
  * @param {Object=} opts - An options object.
  * @param {number|string} [opts.family=0] - The record family. Must be 4, 6, or 0. For backward compatibility reasons,'IPv4' and 'IPv6' are interpreted as 4 and 6 respectively. The value 0 indicates that IPv4 and IPv6 addresses are both returned. Default: 0.
+ * @param {boolean} [opts.all=false] - When true, resolves with an array of `{ address, family }` objects for every address. Default: false.
  * @param {function} cb - The function to call after the method is complete.
  * @returns {void}
  */
@@ -98,6 +99,11 @@ export function lookup (hostname, opts, cb) {
 
   dc.channel('lookup.end').publish({ hostname, family: opts.family, sync: true })
   dc.channel('lookup').publish({ hostname, family: opts.family, sync: true })
+  if (opts.all) {
+    cb(null, data?.addresses ?? [])
+    return
+  }
+
   cb(null, data?.address ?? null, data?.family ?? null)
 }
 
@@ -32,6 +32,7 @@ const dc = diagnostics.channels.group('dns', [
  * @param {string} hostname - The host name to resolve.
  * @param {Object=} opts - An options object.
  * @param {number|string} [opts.family=0] - The record family. Must be 4, 6, or 0. For backward compatibility reasons,'IPv4' and 'IPv6' are interpreted as 4 and 6 respectively. The value 0 indicates that IPv4 and IPv6 addresses are both returned. Default: 0.
+ * @param {boolean} [opts.all=false] - When true, resolves with an array of `{ address, family }` objects for every address. Default: false.
  * @returns {Promise}
  */
 export async function lookup (hostname, opts) {
@@ -69,6 +70,10 @@ export async function lookup (hostname, opts) {
   dc.channel('lookup.end').publish({ hostname, family: opts.family })
   dc.channel('lookup').publish({ hostname, family: opts.family })
 
+  if (opts.all) {
+    return data?.addresses ?? []
+  }
+
   return data
 }
 
@@ -287,6 +287,18 @@ hooks.onLoad(() => {
   }
 })
 
+// acknowledge a reload requested by `ssc build --watch` once it is on screen
+hooks.onLoad(() => {
+  const id = !isWorkerLike && globalThis.sessionStorage?.getItem('__ssc_dev_reload')
+
+  if (id) {
+    globalThis.sessionStorage.removeItem('__ssc_dev_reload')
+    globalThis.requestAnimationFrame(() => {
+      ipc.send('application.reloaded', { id })
+    })
+  }
+})
+
 // async preload modules
 hooks.onReady(async () => {
   try {
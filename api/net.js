@@ -1,18 +1,21 @@
 /**
  * @module Net
  *
- * THIS MODULE HAS BEEN DISABLED!
- *
  * This module provides an asynchronous network API for creating
- * stream-based TCP or IPC servers (net.createServer()) and clients
- * (net.createConnection()).
+ * stream-based TCP servers (net.createServer()) and clients
+ * (net.createConnection()) backed by the native `tcp.*` IPC routes.
  *
+ * Example usage:
+ * ```js
+ * import { createServer, connect } from 'socket:net'
+ * ```
  */
 
 import { EventEmitter } from './events.js'
 import { Duplex } from './stream.js'
+import { Buffer } from './buffer.js'
 import { rand64 } from './crypto.js'
-import console from './console.js'
+import ipc from './ipc.js'
 import * as exports from './net.js'
 
 export default exports
@@ -26,7 +29,6 @@ const assertType = (name, expected, actual, code) => {
 
 // lifted from nodejs/node/
 const normalizedArgsSymbol = Symbol('normalizedArgsSymbol')
-const kLastWriteQueueSize = Symbol('lastWriteQueueSize')
 
 const normalizeArgs = (args) => {
   let arr
@@ -68,49 +70,116 @@ const normalizeArgs = (args) => {
   return arr
 }
 
+// `tcp.write` takes a batch as records of a little endian uint32 length
+// followed by the record bytes, written natively with a single writev
+function encodeBatch (chunks) {
+  const size = chunks.reduce((size, chunk) => size + 4 + chunk.length, 0)
+  const buffer = Buffer.alloc(size)
+  let offset = 0
+
+  for (const chunk of chunks) {
+    offset = buffer.writeUInt32LE(chunk.length, offset)
+    offset += chunk.copy(buffer, offset)
+  }
+
+  return buffer
+}
+
+// subscribes `target` to the `tcp.*` events for its handle ID
+function createDataListener (target, ondata) {
+  globalThis.addEventListener('data', listener)
+  return listener
+
+  function listener ({ detail }) {
+    const { err, data, source } = detail.params
+
+    if (err && BigInt(err.id) === target.id) {
+      if (typeof target.destroy === 'function') {
+        return target.destroy(err)
+      }
+
+      return target.emit('error', err)
+    }
+
+    if (!data || BigInt(data.id) !== target.id) return
+
+    ondata(source, data, detail.data)
+  }
+}
+
 export class Server extends EventEmitter {
   constructor (options, handler) {
     super()
 
-    if (typeof options === 'undefined') {
-      options = handler
+    if (typeof options === 'function') {
+      handler = options
+      options = {}
+    }
+
+    if (typeof handler === 'function') {
+      this.on('connection', handler)
     }
 
-    this._connections = 0
     this.id = rand64()
+    this.options = { ...options }
+    this.listening = false
+    this.maxConnections = 0
+    this._address = null
+    this._connections = 0
+    this._listener = null
   }
 
   onconnection (data) {
-    const socket = new Socket(data)
+    const socket = new Socket({
+      id: BigInt(data.connection),
+      remoteAddress: data.address,
+      remotePort: data.port,
+      remoteFamily: data.family
+    })
 
     if (this.maxConnections && this._connections >= this.maxConnections) {
-      socket.close(data)
+      socket.destroy()
       return
     }
 
     this._connections++
     socket._server = this
 
+    if (this.options.noDelay) socket.setNoDelay(true)
+    if (this.options.keepAlive) socket.setKeepAlive(true, this.options.keepAliveInitialDelay)
+
     this.emit('connection', socket)
   }
 
-  listen (port, address, cb) {
-    ;(async opts => {
-      const { err, data } = await window._ipc.send('tcpCreateServer', opts)
+  listen (...args) {
+    const [options, cb] = normalizeArgs(args)
+
+    if (cb) this.once('listening', cb)
 
-      if (err && !cb) {
+    this._listener = createDataListener(this, (source, data) => {
+      if (source === 'tcp.listen' && data.connection) {
+        this.onconnection(data)
+      }
+    })
+
+    ;(async () => {
+      const { err, data } = await ipc.send('tcp.listen', {
+        id: this.id,
+        port: options.port ?? 0,
+        address: options.host ?? '0.0.0.0',
+        backlog: options.backlog ?? 511,
+        ipv6Only: options.ipv6Only === true
+      })
+
+      if (err) {
         this.emit('error', err)
         return
       }
 
+      this.listening = true
       this._address = { port: data.port, address: data.address, family: data.family }
-      this.connections = {}
-
-      window._ipc.streams[opts.id] = this
-
-      if (cb) return cb(null, data)
-      this.emit('listening', data)
-    })({ port, address, id: this.id })
+      this.emit('listening')
+    })()
 
     return this
   }
@@ -120,32 +189,22 @@ export class Server extends EventEmitter {
   }
 
   close (cb) {
-    const params = {
-      id: this.id
-    }
+    globalThis.removeEventListener('data', this._listener)
 
     ;(async () => {
-      const { err } = await window._ipc.send('tcpClose', params)
-      delete window._ipc.streams[this.id]
+      const { err } = await ipc.send('tcp.close', { id: this.id })
+      this.listening = false
       if (err && !cb) this.emit('error', err)
       else if (cb) cb(err)
+      this.emit('close')
     })()
+
+    return this
   }
 
   getConnections (cb) {
     assertType('Callback', 'function', typeof cb, 'ERR_INVALID_CALLBACK')
-    const params = {
-      id: this.id
-    }
-
-    ;(async () => {
-      const {
-        err,
-        data
-      } = await window._ipc.send('tcpServerGetConnections', params)
-
-      if (cb) cb(err, data)
-    })()
+    queueMicrotask(() => cb(null, this._connections))
   }
 
   unref () {
@@ -154,62 +213,88 @@ export class Server extends EventEmitter {
 }
 
 export class Socket extends Duplex {
-  constructor (options) {
-    super()
+  constructor (options = {}) {
+    super({ highWaterMark: options.highWaterMark })
 
+    this.id = options.id ?? null
+    this.allowHalfOpen = options.allowHalfOpen === true
+    this.remoteAddress = options.remoteAddress ?? null
+    this.remotePort = options.remotePort ?? null
+    this.remoteFamily = options.remoteFamily ?? null
+    this.connecting = false
     this._server = null
-
     this._address = null
-    this.allowHalfOpen = options.allowHalfOpen === true
-    this._flowing = false
-    /*
-    this.on('end', () => {
-      if (!this.allowHalfOpen)
-        this.writable = false
-        //this.write = this._writeAfterFIN;
+    this._reading = false
+    this._drain = null
+    this._listener = null
+
+    // accepted connections are already connected
+    if (this.id !== null) {
+      this._listen()
+    }
+  }
+
+  _listen () {
+    this._listener = createDataListener(this, (source, data, buffer) => {
+      if (source === 'tcp.drain' && this._drain) {
+        const drain = this._drain
+        this._drain = null
+        drain()
+      }
+
+      if (source !== 'tcp.readStart') return
+
+      if (data.EOF) {
+        this._reading = false
+        this.push(null)
+        if (!this.allowHalfOpen) this.end()
+        return
+      }
+
+      if (buffer && !this.push(Buffer.from(buffer)) && this._reading) {
+        // resumed by `_read()`, native reads stop while the queue is full
+        this._reading = false
+        ipc.send('tcp.readStop', { id: this.id })
+      }
     })
-    */
+  }
+
+  _open (cb) {
+    if (this.id !== null && !this.connecting) return cb(null)
+
+    const onconnect = () => {
+      this.removeListener('error', onerror)
+      cb(null)
+    }
+
+    const onerror = (err) => {
+      this.removeListener('connect', onconnect)
+      cb(err)
+    }
+
+    this.once('connect', onconnect)
+    this.once('error', onerror)
   }
 
   // note: this is not an async method on node, so it's not here
-  // thus the ipc response is not awaited. since _ipc.send is async
+  // thus the ipc response is not awaited. since `ipc.send` is async
   // but the messages are handled in order, you do not need to wait
   // for it before sending data, noDelay will be set correctly before the
   // next data is sent.
-  setNoDelay (enable) {
-    const params = {
-      id: this.id, enable
-    }
-    window._ipc.send('tcpSetNoDelay', params)
+  setNoDelay (enable = true) {
+    ipc.send('tcp.setNoDelay', { id: this.id, enable })
+    return this
   }
 
   // note: see note for setNoDelay
-  setKeepAlive (enabled) {
-    const params = {
+  setKeepAlive (enable = false, initialDelay = 0) {
+    ipc.send('tcp.setKeepAlive', {
       id: this.id,
-      enabled
-    }
-
-    window._ipc.send('tcpSetKeepAlive', params)
-  }
-
-  _onTimeout () {
-    const handle = this._handle
-    const lastWriteQueueSize = this[kLastWriteQueueSize]
-
-    if (lastWriteQueueSize > 0 && handle) {
-      // `lastWriteQueueSize !== writeQueueSize` means there is
-      // an active write in progress, so we suppress the timeout.
-      const { writeQueueSize } = handle
-
-      if (lastWriteQueueSize !== writeQueueSize) {
-        this[kLastWriteQueueSize] = writeQueueSize
-        this._unrefTimer()
-        return
-      }
-    }
+      enable,
+      delay: Math.floor(initialDelay / 1000)
+    })
 
-    this.emit('timeout')
+    return this
   }
 
   address () {
@@ -217,193 +302,98 @@ export class Socket extends Duplex {
   }
 
   _final (cb) {
-    if (this.pending) {
-      return this.once('connect', () => this._final(cb))
-    }
-
-    const params = {
-      id: this.id
-    }
     ;(async () => {
-      const { err, data } = await window._ipc.send('tcpShutdown', params)
-      if (cb) cb(err, data)
+      const { err } = await ipc.send('tcp.shutdown', { id: this.id })
+      cb(err || null)
     })()
   }
 
   _destroy (cb) {
-    if (this.destroyed) return
-    ;(async () => {
-      await window._ipc.send('tcpClose', { id: this.id })
-      if (this._server) {
-        this._server._connections--
-
-        if (this._server._connections === 0) {
-          this._server.emit('close')
-        }
-      }
-      cb()
-    })()
-  }
+    globalThis.removeEventListener('data', this._listener)
 
-  destroySoon () {
-    if (this.writable) this.end()
-
-    if (this.writableFinished) {
-      this.destroy()
-    } else {
-      this.once('finish', this.destroy)
-    }
-  }
-
-  _writev (data, cb) {
     ;(async () => {
-      const allBuffers = data.allBuffers
-      let chunks
-
-      if (allBuffers) {
-        chunks = data
-        for (let i = 0; i < data.length; i++) {
-          data[i] = data[i].chunk
-        }
-      } else {
-        chunks = new Array(data.length << 1)
-
-        for (let i = 0; i < data.length; i++) {
-          const entry = data[i]
-          chunks[i * 2] = entry.chunk
-          chunks[i * 2 + 1] = entry.encoding
-        }
-      }
-
-      const requests = []
-
-      for (const chunk of chunks) {
-        const params = {
-          id: this.id,
-          data: chunk
-        }
-        // sent in order so could just await the last one?
-        requests.push(window._ipc.send('tcpSend', params))
+      if (this.id !== null) {
+        await ipc.send('tcp.close', { id: this.id })
       }
 
-      try {
-        await Promise.all(requests)
-      } catch (err) {
-        this.destroy(err)
-        cb(err)
-        return
+      if (this._server) {
+        this._server._connections--
       }
 
-      cb()
+      cb(null)
     })()
   }
 
   _write (data, cb) {
-    const params = {
-      id: this.id,
-      data
-    }
-    ;(async () => {
-      const { err, data } = await window._ipc.send('tcpSend', params)
-      console.log('_write', err, data)
-      cb(err)
-    })()
+    this._writev([data], cb)
   }
 
-  //
-  // This is called internally by incoming _ipc message when there is data to insert to the stream.
-  //
-  __write (data) {
-    if (data.length && !this.destroyed) {
-      if (!this.push(data)) {
-        const params = {
-          id: this.id
-        }
-        this._flowing = false
-        window._ipc.send('tcpReadStop', params)
-      }
-    } else {
-      // if this stream is not full duplex,
-      // then mark as not writable.
-      if (!this.allowHalfOpen) {
-        this.destroySoon()
-      }
-      this.push(null)
-      this.read(0)
-    }
-  }
-
-  _read (cb) {
-    if (this._flowing) return cb()
-    this._flowing = true
-
-    const params = {
-      id: this.id
-    }
-
+  _writev (chunks, cb) {
     ;(async () => {
-      const { err } = await window._ipc.send('tcpReadStart', params)
-
-      if (err) {
-        this._destroy()
+      const buffers = chunks.map((chunk) => Buffer.from(chunk))
+      const { err, data } = await ipc.write('tcp.write', {
+        id: this.id,
+        batch: true,
+        highWaterMark: this._writableState.highWaterMark
+      }, encodeBatch(buffers))
+
+      if (err) return cb(err)
+
+      // wait for the native write queue to flush before accepting more
+      if (data?.backpressure) {
+        this._drain = () => cb(null)
       } else {
-        cb()
+        cb(null)
       }
     })()
   }
 
-  pause () {
-    Duplex.prototype.pause.call(this)
-    // send a ReadStop but do not wait for a confirmation.
-    // ipc is async, but it's ordered,
-    if (this._flowing) {
-      this._flowing = false
-      window._ipc.send('tcpReadStop', { id: this.id })
-    }
-    return this
-  }
+  _read (cb) {
+    if (this._reading) return cb(null)
+    this._reading = true
 
-  resume () {
-    Duplex.prototype.resume.call(this)
-    // send a ReadStop but do not wait for a confirmation.
-    // ipc is async, but it's ordered,
-    if (!this._flowing) {
-      this._flowing = true
-      window._ipc.send('tcpReadStart', { id: this.id })
-    }
-    return this
+    ;(async () => {
+      const { err } = await ipc.send('tcp.readStart', { id: this.id })
+      cb(err || null)
+    })()
   }
 
   connect (...args) {
     const [options, cb] = normalizeArgs(args)
 
+    if (cb) this.once('connect', cb)
+
+    this.id = rand64()
+    this.connecting = true
+    this._listen()
+
     ;(async () => {
-      this.id = rand64()
-      const params = {
-        port: options.port,
-        address: options.host,
-        id: this.id
-      }
+      if (options.noDelay) this.setNoDelay(true)
+      if (options.keepAlive) this.setKeepAlive(true, options.keepAliveInitialDelay)
 
       // TODO: if host is a ip address
       //      connect, if it is a dns name, lookup
+      const { err, data } = await ipc.send('tcp.connect', {
+        id: this.id,
+        port: options.port,
+        address: options.host ?? '127.0.0.1'
+      })
 
-      const { err, data } = await window._ipc.send('tcpConnect', params)
+      this.connecting = false
 
       if (err) {
-        if (cb) cb(err)
-        else this.emit('error', err)
+        this.destroy(err)
         return
       }
+
       this.remotePort = data.port
       this.remoteAddress = data.address
-      // this.port = port
-      // this.address = address
-
-      window._ipc.streams[this.id] = this
+      this.remoteFamily = data.family
+      this._address = { port: data.localPort, address: data.localAddress, family: data.family }
 
-      if (cb) cb(null, this)
+      this.emit('connect')
     })()
+
     return this
   }
 
@@ -423,11 +413,13 @@ export const connect = (...args) => {
   return socket
 }
 
+export const createConnection = connect
+
 export const createServer = (...args) => {
   return new Server(...args)
 }
 
-export const getNetworkInterfaces = o => window._ipc.send('os.networkInterfaces', o)
+export const getNetworkInterfaces = o => ipc.send('os.networkInterfaces', o)
 
 const v4Seg = '(?:[0-9]|[1-9][0-9]|1[0-9][0-9]|2[0-4][0-9]|25[0-5])'
 const v4Str = `(${v4Seg}[.]){3}${v4Seg}`
@@ -436,3 +428,26 @@ const IPv4Reg = new RegExp(`^${v4Str}$`)
 export const isIPv4 = s => {
   return IPv4Reg.test(s)
 }
+
+// lifted from nodejs/node/lib/internal/net.js
+const v6Seg = '(?:[0-9a-fA-F]{1,4})'
+const IPv6Reg = new RegExp('^(?:' +
+  `(?:${v6Seg}:){7}(?:${v6Seg}|:)|` +
+  `(?:${v6Seg}:){6}(?:${v4Str}|:${v6Seg}|:)|` +
+  `(?:${v6Seg}:){5}(?::${v4Str}|(?::${v6Seg}){1,2}|:)|` +
+  `(?:${v6Seg}:){4}(?:(?::${v6Seg}){0,1}:${v4Str}|(?::${v6Seg}){1,3}|:)|` +
+  `(?:${v6Seg}:){3}(?:(?::${v6Seg}){0,2}:${v4Str}|(?::${v6Seg}){1,4}|:)|` +
+  `(?:${v6Seg}:){2}(?:(?::${v6Seg}){0,3}:${v4Str}|(?::${v6Seg}){1,5}|:)|` +
+  `(?:${v6Seg}:){1}(?:(?::${v6Seg}){0,4}:${v4Str}|(?::${v6Seg}){1,6}|:)|` +
+  `(?::(?:(?::${v6Seg}){0,5}:${v4Str}|(?::${v6Seg}){1,7}|:))` +
+')(?:%[0-9a-zA-Z-.:]{1,})?$')
+
+export const isIPv6 = s => {
+  return IPv6Reg.test(s)
+}
+
+export const isIP = s => {
+  if (isIPv4(s)) return 4
+  if (isIPv6(s)) return 6
+  return 0
+}
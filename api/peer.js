@@ -12,10 +12,12 @@
  *
  */
 import { createPeer, Encryption, sha256 } from './stream-relay/index.js'
+import { Packet, PacketPing } from './stream-relay/packets.js'
 import { sodium, randomBytes } from 'socket:crypto'
 import { EventEmitter } from 'socket:events'
 
 import dgram from './dgram.js'
+import ipc from './ipc.js'
 
 const PeerFactory = createPeer(dgram)
 
@@ -144,8 +146,118 @@ export class Peer extends EventEmitter {
     this.peer.encryption.add(this.opts.publicKey, this.opts.privateKey)
 
     await this.peer.init()
+
+    this.startNativeKeepalive()
+
+    // relay publish packets for other clusters natively, only packets for
+    // this cluster are delivered to the socket's 'message' listeners
+    const result = await ipc.send('relay.start', {
+      id: this.peer.socket.id,
+      clusters: this.opts.clusterId,
+      maxHops: this.peer.maxHops
+    })
+
+    if (result.err) {
+      this.peer.onError(result.err)
+    }
+
     return this.peer
   }
+
+  /**
+   * Sends the heartbeats of the underlying network peer from the runtime's
+   * keepalive timers, so NAT mappings stay open while page timers are
+   * throttled. The relay's other pings still go through JS. The vendored
+   * stream-relay sources are not changed, the peer's `ping()` and
+   * `onInterval` are wrapped instead.
+   * @ignore
+   */
+  startNativeKeepalive () {
+    const peer = this.peer
+
+    if (typeof peer.socket?.startKeepalive !== 'function') {
+      return
+    }
+
+    // the first heartbeats may go out before the socket is bound
+    const isNative = () => peer.listening === true && !peer.closing
+    const ping = peer.ping.bind(peer)
+    let onInterval = peer.onInterval
+    let targets = new Map()
+    let natType = null
+
+    // heartbeats to targets of the native timers are dropped, ones that
+    // announce a new NAT type still go out right away
+    peer.ping = (remote, props = {}) => {
+      if (
+        props.isHeartbeat &&
+        isNative() &&
+        props.natType === natType &&
+        targets.has(`${remote?.address}:${remote?.port}`)
+      ) {
+        return
+      }
+
+      return ping(remote, props)
+    }
+
+    const keepalive = async () => {
+      if (!isNative()) return
+
+      const next = new Map()
+
+      for (const { address, port } of peer.peers) {
+        if (address && port) next.set(`${address}:${port}`, { address, port })
+      }
+
+      const stale = [...targets]
+        .filter(([key]) => !next.has(key))
+        .map(([, target]) => target)
+
+      targets = next
+      natType = peer.natType
+
+      try {
+        if (stale.length) await peer.socket.stopKeepalive(stale)
+        if (!targets.size) return
+
+        const payload = await Packet.encode(new PacketPing({
+          message: {
+            clusterId: peer.clusterId,
+            peerId: peer.peerId,
+            natType,
+            cacheSize: peer.cache.size,
+            isHeartbeat: true
+          }
+        }))
+
+        await peer.socket.startKeepalive([...targets.values()], {
+          payload,
+          interval: peer.config.keepalive,
+          // heartbeats are answered by heartbeats, so they are not punched
+          punchAttempts: 1
+        })
+      } catch (err) {
+        // fall back to JS heartbeats until the next round
+        targets = new Map()
+        peer.onError(err)
+      }
+    }
+
+    // `onInterval` runs at the start of every heartbeat round, schemes
+    // such as PTP assign their own handler, which still runs after ours
+    Object.defineProperty(peer, 'onInterval', {
+      configurable: true,
+      enumerable: true,
+      get: () => async (...args) => {
+        await keepalive()
+        if (onInterval) return await onInterval(...args)
+      },
+      set: (value) => {
+        onInterval = value
+      }
+    })
+  }
 }
 
 export default Peer
@@ -0,0 +1,73 @@
+#!/usr/bin/env bash
+
+# Builds the ThinLTO runtime library with profile guided optimization:
+#
+#   1. build an instrumented `libsocket-runtime-lto.a` and install it
+#   2. run the headless desktop tests with an instrumented app to collect
+#      a profile of IPC dispatch and UDP traffic
+#   3. merge the raw profiles with `llvm-profdata`
+#   4. rebuild and install `libsocket-runtime-lto.a` with the profile
+#
+# Apps built with `ssc build --prod` link the optimized library when
+# `SSC_PGO` is set to the printed `.profdata` file.
+
+declare root="$(cd "$(dirname "$(dirname "${BASH_SOURCE[0]}")")" && pwd)"
+
+source "$root/bin/functions.sh"
+
+declare arch="$(host_arch)"
+declare profile_directory="$root/build/pgo"
+declare profile="$profile_directory/socket-runtime.profdata"
+declare profdata="${LLVM_PROFDATA:-llvm-profdata}"
+
+if [ -n "$LOCALAPPDATA" ] && [ -z "$SOCKET_HOME" ]; then
+  SOCKET_HOME="$LOCALAPPDATA/Programs/socketsupply"
+else
+  SOCKET_HOME="${SOCKET_HOME:-"${XDG_DATA_HOME:-"$HOME/.local/share"}/socket"}"
+fi
+
+if ! command -v "$profdata" >/dev/null 2>&1; then
+  echo >&2 "not ok - $profdata is required to merge profiles"
+  exit 1
+fi
+
+function install_library () {
+  mkdir -p "$SOCKET_HOME/lib/$arch-desktop"
+  cp -fp "$root/build/$arch-desktop/lib/libsocket-runtime-lto.a" "$SOCKET_HOME/lib/$arch-desktop/" || exit 1
+}
+
+# relinks the test app with `SSC_PGO` set, runs the desktop tests and
+# prints the benchmark comments
+function run_tests () {
+  (cd "$root/test" && SSC_PGO="$1" LLVM_PROFILE_FILE="$profile_directory/%p.profraw" npm run test:desktop -- --rebuild) |
+    tee "$profile_directory/$2.log" |
+    grep -E '^# (dispatch latency|udp throughput)'
+}
+
+rm -rf "$profile_directory"
+mkdir -p "$profile_directory"
+
+echo "# building instrumented runtime library ($arch-desktop)"
+"$root/bin/build-runtime-library.sh" --arch "$arch" --platform desktop --profile-generate "$@" || exit $?
+install_library
+
+echo "# collecting profile"
+run_tests generate baseline
+
+if ! compgen -G "$profile_directory/*.profraw" >/dev/null; then
+  echo >&2 "not ok - the instrumented test app wrote no profiles, see $profile_directory/baseline.log"
+  exit 1
+fi
+
+"$profdata" merge -output="$profile" "$profile_directory"/*.profraw || exit $?
+rm -f "$profile_directory"/*.profraw
+
+echo "# building optimized runtime library ($arch-desktop)"
+"$root/bin/build-runtime-library.sh" --arch "$arch" --platform desktop --profile-use "$profile" "$@" || exit $?
+install_library
+
+echo "# measuring optimized build"
+run_tests "$profile" optimized
+rm -f "$profile_directory"/*.profraw
+
+echo "ok - built profile guided runtime library, build apps with SSC_PGO=$profile"
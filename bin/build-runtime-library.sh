@@ -10,6 +10,9 @@ export CPU_CORES=$(set_cpu_cores)
 declare args=()
 declare pids=()
 declare force=0
+declare unity=${UNITY_BUILD:-0}
+declare lto=0
+declare profile=""
 
 declare arch="$(host_arch)"
 declare host_arch=$arch
@@ -48,10 +51,6 @@ if [[ "$host" == "Win32" ]]; then
 fi
 
 declare objects=()
-declare test_headers=(
-  $(find "$root/src"/**/*.hh)
-  "$root/src"/../VERSION.txt
-)
 declare sources=(
   $(find "$root"/src/app/*.cc)
   $(find "$root"/src/core/*.cc)
@@ -77,6 +76,22 @@ while (( $# > 0 )); do
     force=1; continue
   fi
 
+  if [[ "$arg" = "--unity" ]]; then
+    unity=1; continue
+  fi
+
+  if [[ "$arg" = "--lto" ]]; then
+    lto=1; continue
+  fi
+
+  if [[ "$arg" = "--profile-generate" ]]; then
+    lto=1; profile="generate"; continue
+  fi
+
+  if [[ "$arg" = "--profile-use" ]]; then
+    lto=1; profile="$(cd "$(dirname "$1")" && pwd)/$(basename "$1")"; shift; continue
+  fi
+
   if [[ "$arg" = "--platform" ]]; then
     if [[ "$1" = "ios" ]] || [[ "$1" = "iPhoneOS" ]] || [[ "$1" = "iphoneos" ]]; then
       arch="arm64"
@@ -127,52 +142,226 @@ elif [[ "$host" = "Win32" ]]; then
   sources+=("$root/src/process/win.cc")
 fi
 
-declare cflags=($("$root/bin/cflags.sh"))
+declare cflags=()
 declare ldflags=($("$root/bin/ldflags.sh"))
 
+# the build time define changes on every run and is not used by the runtime,
+# leave it out so objects and the precompiled header stay reusable
+for flag in $("$root/bin/cflags.sh"); do
+  if [[ "$flag" != "-DSSC_BUILD_TIME="* ]]; then
+    cflags+=("$flag")
+  fi
+done
+
 if [[ "$platform" = "android" ]]; then
   cflags+=("${android_includes[*]}")
 fi
 
+# libsodium is opt in, its static archive is shipped next to the runtime
+# library so apps link it without depending on a system or Homebrew library
+declare sodium_library=""
+
+if [[ -n "$SSC_CRYPTO_SODIUM" ]] && [[ "$platform" = "desktop" ]] && [[ "$host" != "Win32" ]]; then
+  sodium_library="$(pkg-config --variable=libdir libsodium 2>/dev/null)/libsodium.a"
+
+  if ! pkg-config --exists libsodium 2>/dev/null || ! test -f "$sodium_library"; then
+    echo >&2 "not ok - SSC_CRYPTO_SODIUM is set but no static libsodium was found with pkg-config"
+    echo >&2 "# install libsodium with its static archive or unset SSC_CRYPTO_SODIUM"
+    exit 1
+  fi
+fi
+
+# `--lto` builds `libsocket-runtime-lto.a` from ThinLTO bitcode objects next
+# to the regular library, `ssc build --prod` links it when it is installed.
+# `--profile-generate` and `--profile-use <file.profdata>` add clang's
+# instrumentation based profile guided optimization on top.
+declare variant=""
+if (( lto )); then
+  if [[ "$platform" != "desktop" ]] || [[ -n "$DEBUG" ]]; then
+    echo "# link time optimization is only used for desktop release builds, ignoring it"
+    lto=0
+    profile=""
+  elif ! $clang --version 2>/dev/null | grep -q clang; then
+    echo "# link time optimization needs clang, ignoring it"
+    lto=0
+    profile=""
+  else
+    variant="-lto"
+    cflags+=("-flto=thin")
+  fi
+fi
+
+if [[ "$profile" = "generate" ]]; then
+  cflags+=("-fprofile-instr-generate")
+elif [[ -n "$profile" ]]; then
+  if ! test -f "$profile"; then
+    echo >&2 "not ok - profile data not found: $profile"
+    exit 1
+  fi
+
+  cflags+=("-fprofile-instr-use=$profile")
+fi
+
 declare output_directory="$root/build/$arch-$platform"
 mkdir -p "$output_directory"
 
 cd "$(dirname "$output_directory")"
 
+if (( unity )) && [[ -n "$DEBUG" ]]; then
+  echo "# unity build is only used for release builds, ignoring it"
+  unity=0
+fi
+
+if (( unity )); then
+  # compile the sources of each directory as one translation unit
+  declare unity_directory="$output_directory/unity"
+  declare unity_sources=()
+  mkdir -p "$unity_directory"
+
+  for directory in app core ipc; do
+    declare unity_source="$unity_directory/$directory.cc"
+    declare unity_content=""
+
+    for source in "${sources[@]}"; do
+      if [[ "$source" = "$root/src/$directory/"*.cc ]]; then
+        unity_content+="#include \"../../../src/${source#"$root/src/"}\""$'\n'
+      fi
+    done
+
+    # only rewrite the unity source when it changes so it is not recompiled
+    if [[ "$(cat "$unity_source" 2>/dev/null)"$'\n' != "$unity_content" ]]; then
+      printf "%s" "$unity_content" > "$unity_source"
+    fi
+
+    unity_sources+=("$unity_source")
+  done
+
+  for source in "${sources[@]}"; do
+    if [[ "$source" != "$root/src/app/"*.cc ]] && \
+       [[ "$source" != "$root/src/core/"*.cc ]] && \
+       [[ "$source" != "$root/src/ipc/"*.cc ]]; then
+      unity_sources+=("$source")
+    fi
+  done
+
+  sources=("${unity_sources[@]}")
+fi
+
 echo "# building runtime static libary ($arch-$platform)"
 for source in "${sources[@]}"; do
   declare src_directory="$root/src"
-  declare object="${source/.cc/$d.o}"
+  declare object="${source/.cc/$d$variant.o}"
   declare object="${object/$src_directory/$output_directory}"
   objects+=("$object")
 done
 
+# Returns 0 if `object` must be compiled: it is missing, was compiled with a
+# different command, or is older than its source or any header listed in
+# the depfile written by the last compile with `-MMD`.
+function needs_rebuild () {
+  local source="$1"
+  local object="$2"
+  local command="$3"
+
+  if (( force )) || ! test -f "$object" || ! test -f "$object.d"; then
+    return 0
+  fi
+
+  if [[ "$(cat "$object.cmd" 2>/dev/null)" != "$command" ]]; then
+    return 0
+  fi
+
+  # depfiles are make rules, `object: source header \`, with escaped spaces
+  local dependencies="$(sed -e 's/^[^:]*://' -e 's/\\$//' "$object.d")"
+  dependencies="${dependencies//\\ /$'\x01'}"
+
+  local object_mtime="$(stat_mtime "$object")"
+
+  if [[ -n "$precompiled_header" ]] && [[ "$object" != "$precompiled_header" ]]; then
+    if (( $(stat_mtime "$precompiled_header") > object_mtime )); then
+      return 0
+    fi
+  fi
+
+  # objects compiled with `-fprofile-instr-use` depend on the profile data
+  for dependency in $source $dependencies ${profile_dependency[@]}; do
+    dependency="${dependency//$'\x01'/ }"
+    if ! test -f "$dependency" || (( $(stat_mtime "$dependency") > object_mtime )); then
+      return 0
+    fi
+  done
+
+  return 1
+}
+
+declare profile_dependency=()
+if [[ -n "$profile" ]] && [[ "$profile" != "generate" ]]; then
+  profile_dependency=("$profile")
+fi
+
+# `core.hh` pulls in the platform webview headers and is included by every
+# runtime source, so it is precompiled once when the compiler is clang.
+# Set `NO_PCH=1` to compile without it.
+declare precompiled_header=""
+if [[ -z "$NO_PCH" ]] && $clang --version 2>/dev/null | grep -q clang; then
+  precompiled_header="$output_directory/pch/core$d$variant.hh.pch"
+fi
+
 function main () {
   trap onsignal INT TERM
-  local i=0
   local max_concurrency=$CPU_CORES
+  local start=$SECONDS
 
-  local newest_mtime=0
-  newest_mtime="$(latest_mtime ${test_headers[@]})"
+  if [[ -n "$precompiled_header" ]]; then
+    local header="$root/src/core/core.hh"
+    local language="c++-header"
 
-  for source in "${sources[@]}"; do
-    if (( i++ > max_concurrency )); then
-      for pid in "${pids[@]}"; do
-        wait "$pid" 2>/dev/null
-      done
-      i=0
+    if [[ "$host" = "Darwin" ]] && [[ "$platform" != "android" ]]; then
+      language="objective-c++-header"
+    fi
+
+    local command="$clang ${cflags[*]} -x $language $header"
+
+    if needs_rebuild "$header" "$precompiled_header" "$command"; then
+      mkdir -p "$(dirname "$precompiled_header")"
+      rm -f "$precompiled_header" "$precompiled_header.cmd"
+      echo "# precompiling header ($arch-$platform) $(basename "$header")"
+      # Don't quote this, android clang contains --target argument, doesn't work with quiet argument splitting
+      if quiet $clang "${cflags[@]}" -MMD -MF "$precompiled_header.d" -x $language "$header" -o "$precompiled_header"; then
+        echo "$command" > "$precompiled_header.cmd"
+      else
+        echo "warn - unable to precompile $(basename "$header") ($arch-$platform), compiling without it"
+        precompiled_header=""
+      fi
     fi
+  fi
+
+  for source in "${sources[@]}"; do
+    # keep every core busy instead of waiting for whole batches to finish,
+    # `wait -n` needs bash 4.3 so fall back to polling
+    while (( $(jobs -pr | wc -l) >= max_concurrency )); do
+      wait -n 2>/dev/null || sleep 0.1
+    done
 
     {
       declare src_directory="$root/src"
-      declare object="${source/.cc/$d.o}"
+      declare object="${source/.cc/$d$variant.o}"
       declare object="${object/$src_directory/$output_directory}"
-      
-      if (( force )) || ! test -f "$object" || (( newest_mtime > $(stat_mtime "$object") )) || (( $(stat_mtime "$source") > $(stat_mtime "$object") )); then
+      declare pch_flags=()
+
+      if [[ -n "$precompiled_header" ]]; then
+        pch_flags=(-include-pch "$precompiled_header")
+      fi
+
+      declare command="$clang ${cflags[*]} ${pch_flags[*]} -c $source"
+
+      if needs_rebuild "$source" "$object" "$command"; then
         mkdir -p "$(dirname "$object")"
+        rm -f "$object" "$object.cmd"
         echo "# compiling object ($arch-$platform) $(basename "$source")"
         # Don't quote this, android clang contains --target argument, doesn't work with quiet argument splitting
-        quiet $clang "${cflags[@]}" -c "$source" -o "$object" || onsignal
+        quiet $clang "${cflags[@]}" "${pch_flags[@]}" -MMD -MF "$object.d" -c "$source" -o "$object" || onsignal
+        echo "$command" > "$object.cmd"
         echo "ok - built ${source/$src_directory\//} -> ${object/$output_directory\//} ($arch-$platform)"
       fi
     } & pids+=($!)
@@ -182,8 +371,10 @@ function main () {
     wait "$pid" 2>/dev/null
   done
 
+  echo "# compiled objects ($arch-$platform) in $(( SECONDS - start ))s"
+
   declare base_lib="libsocket-runtime";
-  declare static_library="$root/build/$arch-$platform/lib$d/$base_lib$d.a"
+  declare static_library="$root/build/$arch-$platform/lib$d/$base_lib$d$variant.a"
   mkdir -p "$(dirname "$static_library")"
   declare ar="ar"
 
@@ -191,10 +382,19 @@ function main () {
     ar="$(android_ar "$ANDROID_HOME" "$NDK_VERSION" "$host" "$host_arch")"
   elif [[ "$host" = "Win32" ]]; then
     ar="llvm-ar"
+  elif (( lto )) && command -v llvm-ar >/dev/null 2>&1; then
+    # the symbol table of bitcode objects is only written by `llvm-ar`
+    ar="llvm-ar"
   fi
 
   local build_static=0
   local static_library_mtime=$(stat_mtime "$static_library")
+
+  # the archive is rebuilt when objects are added or removed
+  if [[ "$(cat "$static_library.objects" 2>/dev/null)" != "${objects[*]}" ]]; then
+    build_static=1
+  fi
+
   for source in "${objects[@]}"; do
     if ! test -f "$source"; then
       echo "$source not built.."
@@ -207,7 +407,10 @@ function main () {
   done
 
   if (( build_static )); then
+    # `ar` keeps members of an existing archive, start from an empty one
+    rm -f "$static_library"
     $ar crs "$static_library" "${objects[@]}"
+    echo "${objects[*]}" > "$static_library.objects"
 
     if [ -f "$static_library" ]; then
       echo "ok - built static library ($arch-$platform): $(basename "$static_library")"
@@ -224,6 +427,14 @@ function main () {
     fi
   fi
 
+  # the app link uses `libsodium.a` when it is next to the runtime library
+  if [[ -n "$sodium_library" ]]; then
+    cp -pf "$sodium_library" "$(dirname "$static_library")/libsodium.a"
+    echo "ok - copied static library ($arch-$platform): libsodium.a"
+  else
+    rm -f "$(dirname "$static_library")/libsodium.a"
+  fi
+
   if [[ "$platform" == "android" ]]; then
     # This is a sanity check to confirm that the static_library is > 8 bytes
     # If an empty ${objects[@]} is provided to ar, it will still spit out a header without an error code.
@@ -98,6 +98,14 @@ if (( !TARGET_OS_ANDROID && !TARGET_ANDROID_EMULATOR )); then
   fi
 fi
 
+# the native `crypto.*` routes use libsodium when `SSC_CRYPTO_SODIUM=1` is set,
+# `build-runtime-library.sh` checks for it and ships its static archive
+if [[ -n "$SSC_CRYPTO_SODIUM" ]] && (( !TARGET_OS_IPHONE && !TARGET_IPHONE_SIMULATOR && !TARGET_OS_ANDROID && !TARGET_ANDROID_EMULATOR )); then
+  if [[ "$host" = "Darwin" ]] || [[ "$host" = "Linux" ]]; then
+    cflags+=("-DSSC_CRYPTO_SODIUM=1" $(pkg-config --cflags libsodium 2>/dev/null))
+  fi
+fi
+
 while (( $# > 0 )); do
   cflags+=("$1")
   shift
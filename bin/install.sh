@@ -295,6 +295,11 @@ function _build_runtime_library() {
   echo "# building runtime library"
   "$root/bin/build-runtime-library.sh" --arch "$arch" --platform desktop $pass_force & pids+=($!)
 
+  # `LTO=1` also builds the ThinLTO variant linked by `ssc build --prod`
+  if [[ -n "$LTO" ]] && [[ -z "$DEBUG" ]]; then
+    "$root/bin/build-runtime-library.sh" --arch "$arch" --platform desktop --lto $pass_force & pids+=($!)
+  fi
+
   if [[ "$host" = "Darwin" ]] && [[ -z "$NO_IOS" ]]; then
     "$root/bin/build-runtime-library.sh" --arch "$arch" --platform ios $pass_force & pids+=($!)
     "$root/bin/build-runtime-library.sh" --arch x86_64 --platform ios-simulator $pass_force & pids+=($!)
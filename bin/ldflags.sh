@@ -109,10 +109,18 @@ if [[ "$host" = "Darwin" ]]; then
   ldflags+=("-framework" "WebKit")
   ldflags+=("-framework" "UserNotifications")
   ldflags+=("-framework" "OSLog")
+
+  if [[ -n "$SSC_CRYPTO_SODIUM" ]] && (( !TARGET_OS_IPHONE && !TARGET_IPHONE_SIMULATOR )); then
+    ldflags+=("$(pkg-config --variable=libdir libsodium)/libsodium.a")
+  fi
 elif [[ "$host" = "Linux" ]]; then
   if [ -z "$BUILDING_SSC_CLI" ]; then
     ldflags+=($(pkg-config --libs gtk+-3.0 webkit2gtk-4.1))
   fi
+
+  if [ -z "$BUILDING_SSC_CLI" ] && [[ -n "$SSC_CRYPTO_SODIUM" ]]; then
+    ldflags+=("$(pkg-config --variable=libdir libsodium)/libsodium.a")
+  fi
 elif [[ "$host" = "Win32" ]]; then
   if [[ -n "$DEBUG" ]]; then
     # https://learn.microsoft.com/en-us/cpp/c-runtime-library/crt-library-features?view=msvc-170
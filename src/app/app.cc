@@ -29,7 +29,9 @@ namespace SSC {
 #endif
 
   App::App () {
+    StartupTrace::begin("core");
     this->core = new Core();
+    StartupTrace::end("core");
     auto cwd = getCwd();
     uv_chdir(cwd.c_str());
   }
@@ -59,10 +61,10 @@ namespace SSC {
     }
 
     if (msg.message == WM_APP) {
-      // from PostThreadMessage
-      auto callback = (std::function<void()> *)(msg.lParam);
-      (*callback)();
-      delete callback;
+      // from PostThreadMessage in `scheduleDispatchQueueDrain()`
+      if (this->drain()) {
+        PostThreadMessage(GetCurrentThreadId(), WM_APP, 0, 0);
+      }
     }
 
     if (msg.message == WM_QUIT && shouldExit) {
@@ -109,51 +111,129 @@ namespace SSC {
 #endif
   }
 
-  void App::dispatch (std::function<void()> callback) {
+  static void scheduleDispatchQueueDrain (App* app) {
 #if defined(__linux__) && !defined(__ANDROID__)
-    auto threadCallback = new std::function<void()>(callback);
-
     g_idle_add_full(
       G_PRIORITY_HIGH_IDLE,
-      (GSourceFunc)([](void* callback) -> int {
-        (*static_cast<std::function<void()>*>(callback))();
-        return G_SOURCE_REMOVE;
+      (GSourceFunc)([](void* app) -> int {
+        return static_cast<App*>(app)->drain()
+          ? G_SOURCE_CONTINUE
+          : G_SOURCE_REMOVE;
       }),
-      threadCallback,
-      [](void* callback) {
-        delete static_cast<std::function<void()>*>(callback);
-      }
+      app,
+      nullptr
     );
 #elif defined(__APPLE__)
-    auto priority = DISPATCH_QUEUE_PRIORITY_DEFAULT;
-    auto queue = dispatch_get_global_queue(priority, 0);
-
-    dispatch_async(queue, ^{
-      dispatch_sync(dispatch_get_main_queue(), ^{
-        callback();
-      });
+    dispatch_async(dispatch_get_main_queue(), ^{
+      if (app->drain()) {
+        scheduleDispatchQueueDrain(app);
+      }
     });
 #elif defined(_WIN32)
     static auto mainThread = GetCurrentThreadId();
-    auto threadCallback = (LPARAM) new std::function<void()>(callback);
-    if (this->isReady) {
-      PostThreadMessage(mainThread, WM_APP, 0, threadCallback);
+    if (app->isReady) {
+      PostThreadMessage(mainThread, WM_APP, 0, 0);
       return;
     }
-    std::thread t([&, threadCallback] {
+    std::thread t([app] {
 
       // TODO(trevnorris): Need to also check a shouldExit so this doesn't run forever in case
       // the rest of the application needs to exit before isReady is set.
-      while (!this->isReady) {
+      while (!app->isReady) {
         std::this_thread::sleep_for(std::chrono::milliseconds(16));
       }
 
-      PostThreadMessage(mainThread, WM_APP, 0, threadCallback);
+      PostThreadMessage(mainThread, WM_APP, 0, 0);
     });
     t.detach();
 #endif
   }
 
+  void App::dispatch (std::function<void()> callback) {
+    auto& queue = this->dispatchQueue;
+
+    {
+      Lock lock(queue.mutex);
+      queue.callbacks.push(callback);
+      queue.metrics.dispatched++;
+      queue.metrics.depth = queue.callbacks.size();
+
+      if (queue.metrics.depth > queue.metrics.maxDepth) {
+        queue.metrics.maxDepth = queue.metrics.depth.load();
+      }
+
+      // a drain is already pending on the main thread
+      if (queue.scheduled) {
+        return;
+      }
+
+      queue.scheduled = true;
+    }
+
+    scheduleDispatchQueueDrain(this);
+  }
+
+  // Runs queued callbacks on the main thread until the queue is empty or
+  // `APP_DISPATCH_QUEUE_DRAIN_BUDGET` is spent. Returns `true` if callbacks
+  // remain and the caller should schedule another drain.
+  bool App::drain () {
+    auto& queue = this->dispatchQueue;
+    auto start = std::chrono::steady_clock::now();
+    auto budget = std::chrono::milliseconds(APP_DISPATCH_QUEUE_DRAIN_BUDGET);
+    auto pending = true;
+
+    while (pending) {
+      std::function<void()> callback = nullptr;
+
+      {
+        Lock lock(queue.mutex);
+
+        if (queue.callbacks.size() == 0) {
+          queue.scheduled = false;
+          pending = false;
+          break;
+        }
+
+        callback = queue.callbacks.front();
+        queue.callbacks.pop();
+        queue.metrics.depth = queue.callbacks.size();
+      }
+
+      if (callback != nullptr) {
+        callback();
+      }
+
+      if (std::chrono::steady_clock::now() - start >= budget) {
+        break;
+      }
+    }
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now() - start
+    ).count();
+
+    queue.metrics.drains++;
+    queue.metrics.lastDrainTime = elapsed;
+
+    if (queue.metrics.lastDrainTime > queue.metrics.maxDrainTime) {
+      queue.metrics.maxDrainTime = queue.metrics.lastDrainTime.load();
+    }
+
+    return pending;
+  }
+
+  JSON::Object App::getDispatchQueueMetrics () {
+    auto& metrics = this->dispatchQueue.metrics;
+    return JSON::Object::Entries {
+      {"depth", (uint64_t) metrics.depth},
+      {"maxDepth", (uint64_t) metrics.maxDepth},
+      {"dispatched", (uint64_t) metrics.dispatched},
+      {"drains", (uint64_t) metrics.drains},
+      {"lastDrainTime", (uint64_t) metrics.lastDrainTime},
+      {"maxDrainTime", (uint64_t) metrics.maxDrainTime}
+    };
+  }
+
   String App::getCwd () {
     String cwd = "";
 
@@ -6,6 +6,9 @@
 
 
 namespace SSC {
+  // max time spent running callbacks per drain of the dispatch queue
+  constexpr int APP_DISPATCH_QUEUE_DRAIN_BUDGET = 8; // in milliseconds
+
   class WindowManager;
 
   class App {
@@ -29,6 +32,23 @@ namespace SSC {
       Map appData;
       Core *core;
 
+      // callbacks from `dispatch()` queued for the main thread, which is
+      // scheduled at most once and drained in batches by `drain()`
+      struct {
+        Mutex mutex;
+        Queue<std::function<void()>> callbacks;
+        bool scheduled = false;
+
+        struct {
+          std::atomic<uint64_t> depth = 0;
+          std::atomic<uint64_t> maxDepth = 0;
+          std::atomic<uint64_t> dispatched = 0;
+          std::atomic<uint64_t> drains = 0;
+          std::atomic<uint64_t> lastDrainTime = 0; // in microseconds
+          std::atomic<uint64_t> maxDrainTime = 0; // in microseconds
+        } metrics;
+      } dispatchQueue;
+
 #ifdef _WIN32
       App (void *);
       void ShowConsole();
@@ -44,6 +64,8 @@ namespace SSC {
       void exit (int code);
       void restart ();
       void dispatch (std::function<void()>);
+      bool drain ();
+      JSON::Object getDispatchQueueMetrics ();
       SSC::String getCwd ();
       void setWindowManager (WindowManager*);
       WindowManager* getWindowManager () const;
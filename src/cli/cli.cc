@@ -1,17 +1,24 @@
 #include "../common.hh"
 #include "../process/process.hh"
 #include "templates.hh"
+#include "watcher.hh"
 #include "../core/core.hh"
 
 #include <filesystem>
+#include <condition_variable>
+#include <set>
 
 #ifdef __linux__
 #include <cstring>
+#include <fcntl.h>
+#include <linux/fs.h>
+#include <sys/ioctl.h>
 #endif
 
 #if defined(__APPLE__)
 #include <Foundation/Foundation.h>
 #include <Cocoa/Cocoa.h>
+#include <sys/clonefile.h>
 #endif
 
 #include <sys/stat.h>
@@ -82,10 +89,15 @@ static dispatch_queue_t queue = dispatch_queue_create(
 );
 #endif
 
-const Map SSC::getUserConfig () {
+const Map& SSC::getUserConfig () {
   return settings;
 }
 
+const SettingsTable& SSC::getUserSettings () {
+  static const SettingsTable table(settings);
+  return table;
+}
+
 bool SSC::isDebugEnabled () {
   return DEBUG == 1;
 }
@@ -230,6 +242,493 @@ inline String prefixFile () {
   return socketHome;
 }
 
+//
+// Build cache
+// ---
+// Build outputs are stored in a content addressed cache, keyed by a hash of
+// everything that goes into them (commands, flags and input file contents),
+// so that unchanged outputs are restored instead of rebuilt.
+//
+constexpr uint64_t BUILD_CACHE_HASH_SEED = 0xcbf29ce484222325; // FNV-1a offset basis
+
+static uint64_t hashBytes (uint64_t hash, const char *bytes, size_t size) {
+  for (size_t i = 0; i < size; ++i) {
+    hash ^= (unsigned char) bytes[i];
+    hash *= 0x100000001b3; // FNV-1a prime
+  }
+
+  return hash;
+}
+
+static uint64_t hashString (uint64_t hash, const String& string) {
+  // include the size so adjacent strings can't be shifted into each other
+  auto size = std::to_string(string.size()) + ":";
+  hash = hashBytes(hash, size.data(), size.size());
+  return hashBytes(hash, string.data(), string.size());
+}
+
+static uint64_t hashFile (uint64_t hash, const Path& path) {
+  std::ifstream stream(path, std::ios::binary);
+  auto buffer = std::unique_ptr<char[]>(new char[EXEC_BUFFER_SIZE]);
+
+  hash = hashString(hash, std::to_string(fs::file_size(path)));
+
+  while (stream.read(buffer.get(), EXEC_BUFFER_SIZE) || stream.gcount() > 0) {
+    hash = hashBytes(hash, buffer.get(), stream.gcount());
+  }
+
+  return hash;
+}
+
+// Hashes the relative paths and contents of all files in `path` in a stable order.
+static uint64_t hashDirectory (uint64_t hash, const Path& path) {
+  Vector<Path> files;
+
+  for (auto const& entry : fs::recursive_directory_iterator(path)) {
+    if (entry.is_regular_file()) {
+      files.push_back(entry.path());
+    }
+  }
+
+  std::sort(files.begin(), files.end());
+
+  for (auto const& file : files) {
+    hash = hashString(hash, fs::relative(file, path).generic_string());
+    hash = hashFile(hash, file);
+  }
+
+  return hash;
+}
+
+static String getBuildCacheKey (uint64_t hash) {
+  char key[17] = {0};
+  snprintf(key, sizeof(key), "%016llx", (unsigned long long) hash);
+  return String(key);
+}
+
+// The build cache is shared by all target platforms of a project. Set
+// `SSC_BUILD_CACHE` to share it across projects, for example in CI.
+static Path getBuildCachePath (const Path& targetPath) {
+  auto path = getEnv("SSC_BUILD_CACHE");
+
+  if (path.size() > 0) {
+    return Path(path);
+  }
+
+  return targetPath / settings["build_output"] / ".cache";
+}
+
+// Marks a cache entry as used, so it is evicted last.
+static void touchBuildCacheEntry (const Path& path) {
+  std::error_code ec;
+  fs::last_write_time(path, fs::file_time_type::clock::now(), ec);
+}
+
+// Evicts the least recently used entries of the build cache until it is
+// below `SSC_BUILD_CACHE_SIZE` megabytes (2048 by default). Entries are the
+// files and directories directly in each of its `bin`, `pch`, `copy` and
+// `android` directories. Entries being written (`*.tmp`) are left alone.
+static void evictBuildCache (const Path& cachePath) {
+  struct Entry {
+    Path path;
+    uintmax_t size = 0;
+    fs::file_time_type mtime;
+  };
+
+  uintmax_t limit = 2048;
+  uintmax_t total = 0;
+  Vector<Entry> entries;
+  std::error_code ec;
+
+  try {
+    limit = std::stoull(getEnv("SSC_BUILD_CACHE_SIZE"));
+  } catch (...) {}
+
+  limit *= 1024 * 1024;
+
+  for (auto const& directory : fs::directory_iterator(cachePath, ec)) {
+    if (!directory.is_directory(ec)) continue;
+
+    for (auto const& child : fs::directory_iterator(directory.path(), ec)) {
+      if (child.path().extension() == ".tmp") continue;
+
+      auto entry = Entry { child.path(), 0, child.last_write_time(ec) };
+
+      if (child.is_directory(ec)) {
+        for (auto const& file : fs::recursive_directory_iterator(child.path(), ec)) {
+          if (file.is_regular_file(ec)) entry.size += file.file_size(ec);
+        }
+      } else {
+        entry.size = child.file_size(ec);
+      }
+
+      total += entry.size;
+      entries.push_back(entry);
+    }
+  }
+
+  if (total <= limit) {
+    return;
+  }
+
+  std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+    return a.mtime < b.mtime;
+  });
+
+  auto evicted = 0;
+
+  for (auto const& entry : entries) {
+    if (total <= limit) break;
+
+    if (fs::remove_all(entry.path, ec) > 0 && !ec) {
+      total -= entry.size;
+      evicted++;
+    }
+  }
+
+  log("evicted " + std::to_string(evicted) + " build cache entries");
+}
+
+// The `--version` output of `compiler`, so cache keys change when the
+// compiler and the headers it ships with are updated in place.
+static const String& getCompilerVersion (const String& compiler, const String& quote) {
+  static std::map<String, String> versions;
+
+  if (versions.count(compiler) == 0) {
+    versions[compiler] = exec(quote + quote + compiler + quote + " --version" + quote).output;
+  }
+
+  return versions[compiler];
+}
+
+// Precompiles `header` with the compile arguments of the native binary
+// into the build cache, so compiles can load it with `-include-pch` instead
+// of parsing it again. Only clang is supported, and `NO_PCH=1` opts out.
+// The cache key covers the compiler version, but not system headers the
+// header includes, so callers retry without the PCH if clang rejects it.
+// Returns an empty path if the header could not be precompiled.
+static Path getPrecompiledHeader (
+  const Path& cachePath,
+  const String& compiler,
+  const String& arguments,
+  const Path& header,
+  const String& language,
+  const String& quote
+) {
+  if (getEnv("NO_PCH").size() > 0 || compiler.find("clang") == String::npos) {
+    return Path();
+  }
+
+  auto hash = hashString(BUILD_CACHE_HASH_SEED, compiler);
+  hash = hashString(hash, getCompilerVersion(compiler, quote));
+  hash = hashString(hash, arguments);
+  hash = hashString(hash, language);
+  hash = hashFile(hash, header);
+
+  auto pch = cachePath / "pch" / (getBuildCacheKey(hash) + ".pch");
+
+  if (fs::exists(pch)) {
+    touchBuildCacheEntry(pch);
+    return pch;
+  }
+
+  std::error_code ec;
+  auto pchTempPath = Path(pch.string() + ".tmp");
+  fs::create_directories(pch.parent_path(), ec);
+
+  // win32 - quote the entire command and the binary path
+  auto r = exec(
+    quote + quote + compiler + quote + arguments +
+    " -x " + language + " " + header.string() +
+    " -o " + pchTempPath.string() + quote
+  );
+
+  if (r.exitCode != 0) {
+    log("WARNING: unable to precompile '" + header.string() + "', compiling without it");
+    fs::remove(pchTempPath, ec);
+    return Path();
+  }
+
+  fs::rename(pchTempPath, pch, ec);
+  return ec ? Path() : pch;
+}
+
+//
+// Copy stage
+// ---
+// Files from `[build] copy`, copy maps and the socket API are planned as
+// output to source pairs first and then copied in parallel. A manifest of
+// copied files persists between builds, so unchanged files are skipped and
+// outputs that are no longer planned are deleted.
+//
+struct CopyManifestEntry {
+  String source;
+  uintmax_t size = 0;
+  int64_t mtime = 0;
+  uint64_t hash = 0;
+  int64_t outputMtime = 0;
+};
+
+struct CopyStats {
+  size_t copied = 0;
+  size_t unchanged = 0;
+  size_t removed = 0;
+};
+
+static int64_t getFileMtime (const Path& path, std::error_code& ec) {
+  return fs::last_write_time(path, ec).time_since_epoch().count();
+}
+
+// Copies `src` to `dst` with a hard link if `link` is set, or a copy on
+// write clone if the file system supports it, before falling back to a
+// regular copy. Existing outputs are unlinked first so a hard linked
+// output never writes through to its source.
+static bool copyFileFast (const Path& src, const Path& dst, bool link) {
+  std::error_code ec;
+  fs::remove(dst, ec);
+
+  if (link) {
+    fs::create_hard_link(src, dst, ec);
+    if (!ec) return true;
+  }
+
+#if defined(__linux__)
+  struct stat stats;
+  auto in = open(src.c_str(), O_RDONLY);
+
+  if (in >= 0 && fstat(in, &stats) == 0) {
+    auto out = open(dst.c_str(), O_WRONLY | O_CREAT | O_TRUNC, stats.st_mode & 0777);
+
+    if (out >= 0) {
+      auto copied = ioctl(out, FICLONE, in) == 0;
+      off_t remaining = stats.st_size;
+
+      // copy in kernel space when cloning is not supported
+      while (!copied && remaining > 0) {
+        auto n = copy_file_range(in, nullptr, out, nullptr, remaining, 0);
+        if (n <= 0) break;
+        remaining -= n;
+      }
+
+      copied = copied || remaining == 0;
+      close(out);
+      close(in);
+
+      if (copied) return true;
+    } else {
+      close(in);
+    }
+  } else if (in >= 0) {
+    close(in);
+  }
+#elif defined(__APPLE__)
+  if (clonefile(src.c_str(), dst.c_str(), 0) == 0) {
+    return true;
+  }
+#endif
+
+  return fs::copy_file(src, dst, fs::copy_options::overwrite_existing, ec);
+}
+
+class CopyPlan {
+  public:
+    // the output directory, used to key the manifest
+    Path root;
+    // output -> source, for files only
+    std::map<Path, Path> files;
+    // outputs removed from the plan, deleted if they exist on disk
+    Vector<Path> excluded;
+
+    // Plans `src` to be copied to `dst` like `fs::copy()` with the
+    // `recursive` option would do it.
+    void add (const Path& src, const Path& dst) {
+      auto source = fs::absolute(src);
+      auto output = fs::absolute(dst).lexically_normal();
+
+      if (fs::is_directory(source)) {
+        auto options = fs::directory_options::follow_directory_symlink;
+        for (auto const& entry : fs::recursive_directory_iterator(source, options)) {
+          if (entry.is_regular_file()) {
+            auto path = (output / fs::relative(entry.path(), source)).lexically_normal();
+            this->files[path] = entry.path();
+          }
+        }
+      } else if (output == this->root || fs::is_directory(output)) {
+        this->files[output / source.filename()] = source;
+      } else {
+        this->files[output] = source;
+      }
+    }
+
+    // Removes `path` and everything planned below it.
+    void remove (const Path& path) {
+      auto output = fs::absolute(path).lexically_normal();
+      auto prefix = output.string() + (char) fs::path::preferred_separator;
+
+      for (auto it = this->files.begin(); it != this->files.end();) {
+        auto string = it->first.string();
+        if (it->first == output || string.starts_with(prefix)) {
+          it = this->files.erase(it);
+        } else {
+          ++it;
+        }
+      }
+
+      this->excluded.push_back(output);
+    }
+
+    CopyStats run (const Path& manifestPath, bool link) {
+      CopyStats stats;
+      auto manifest = readManifest(manifestPath);
+      std::error_code ec;
+
+      for (auto const& path : this->excluded) {
+        if (this->files.count(path) == 0 && fs::exists(path, ec)) {
+          fs::remove_all(path, ec);
+        }
+      }
+
+      for (auto const& tuple : manifest) {
+        if (this->files.count(tuple.first) == 0 && fs::exists(tuple.first, ec)) {
+          fs::remove(tuple.first, ec);
+          stats.removed++;
+        }
+      }
+
+      std::set<Path> directories;
+      for (auto const& tuple : this->files) {
+        directories.insert(tuple.first.parent_path());
+      }
+
+      for (auto const& directory : directories) {
+        fs::create_directories(directory, ec);
+      }
+
+      auto outputs = Vector<std::pair<Path, Path>>(this->files.begin(), this->files.end());
+      auto entries = Vector<CopyManifestEntry>(outputs.size());
+      std::atomic<size_t> next = 0;
+      std::atomic<size_t> copied = 0;
+      Vector<std::thread> workers;
+      auto concurrency = std::min((size_t) std::max(1u, std::thread::hardware_concurrency()), outputs.size());
+
+      for (size_t i = 0; i < concurrency; ++i) {
+        workers.emplace_back([&]() {
+          for (auto j = next++; j < outputs.size(); j = next++) {
+            auto const& output = outputs[j].first;
+            auto const& source = outputs[j].second;
+            auto cached = manifest.find(output);
+            auto& entry = entries[j];
+            std::error_code ec;
+
+            entry.source = source.string();
+            entry.size = fs::file_size(source, ec);
+            entry.mtime = getFileMtime(source, ec);
+
+            auto outputMtime = getFileMtime(output, ec);
+            auto outputExists = !ec;
+            auto isUnchanged = (
+              outputExists &&
+              cached != manifest.end() &&
+              cached->second.source == entry.source &&
+              cached->second.size == entry.size &&
+              cached->second.outputMtime == outputMtime &&
+              fs::file_size(output, ec) == entry.size
+            );
+
+            // a touched but otherwise unchanged source is only hashed
+            if (isUnchanged && cached->second.mtime != entry.mtime) {
+              entry.hash = hashFile(BUILD_CACHE_HASH_SEED, source);
+              isUnchanged = entry.hash == cached->second.hash;
+            } else if (isUnchanged) {
+              entry.hash = cached->second.hash;
+            }
+
+            if (isUnchanged) {
+              entry.outputMtime = outputMtime;
+              continue;
+            }
+
+            if (!copyFileFast(source, output, link)) {
+              log("WARNING: unable to copy '" + source.string() + "' to '" + output.string() + "'");
+              entry.source.clear();
+              continue;
+            }
+
+            if (entry.hash == 0) {
+              entry.hash = hashFile(BUILD_CACHE_HASH_SEED, source);
+            }
+
+            entry.outputMtime = getFileMtime(output, ec);
+            copied++;
+          }
+        });
+      }
+
+      for (auto& worker : workers) {
+        worker.join();
+      }
+
+      stats.copied = copied;
+      stats.unchanged = outputs.size() - copied;
+
+      std::map<Path, CopyManifestEntry> nextManifest;
+      for (size_t i = 0; i < outputs.size(); ++i) {
+        if (entries[i].source.size() > 0) {
+          nextManifest[outputs[i].first] = entries[i];
+        }
+      }
+
+      writeManifest(manifestPath, nextManifest);
+      return stats;
+    }
+
+    // one `output\tsource\tsize\tmtime\thash\toutputMtime` line per file
+    static std::map<Path, CopyManifestEntry> readManifest (const Path& path) {
+      std::map<Path, CopyManifestEntry> manifest;
+      std::ifstream stream(path);
+      String line;
+
+      while (std::getline(stream, line)) {
+        auto fields = split(line, '\t');
+        if (fields.size() != 6) continue;
+
+        try {
+          CopyManifestEntry entry;
+          entry.source = fields[1];
+          entry.size = std::stoull(fields[2]);
+          entry.mtime = std::stoll(fields[3]);
+          entry.hash = std::stoull(fields[4], nullptr, 16);
+          entry.outputMtime = std::stoll(fields[5]);
+          manifest[Path(fields[0])] = entry;
+        } catch (...) {}
+      }
+
+      return manifest;
+    }
+
+  private:
+    static void writeManifest (const Path& path, const std::map<Path, CopyManifestEntry>& manifest) {
+      std::error_code ec;
+      auto tmp = Path(path.string() + ".tmp");
+      fs::create_directories(path.parent_path(), ec);
+
+      {
+        std::ofstream stream(tmp, std::ios::trunc);
+        for (auto const& tuple : manifest) {
+          stream
+            << tuple.first.string() << "\t"
+            << tuple.second.source << "\t"
+            << tuple.second.size << "\t"
+            << tuple.second.mtime << "\t"
+            << getBuildCacheKey(tuple.second.hash) << "\t"
+            << tuple.second.outputMtime << "\n";
+        }
+      }
+
+      fs::rename(tmp, path, ec);
+    }
+};
+
 static Process::id_type appPid = 0;
 static Process* appProcess = nullptr;
 static std::atomic<int> appStatus = -1;
@@ -321,6 +820,14 @@ int runApp (const Path& path, const String& args, bool headless) {
 
     env[@"SSC_CLI_PID"] = [NSString stringWithFormat: @"%d", getpid()];
 
+    // set by `ssc build --watch` for the app to connect back for reloads,
+    // and by the startup benchmark to trace the app
+    for (auto const key : { "SSC_DEV_HOST", "SSC_DEV_PORT", "SSC_STARTUP_TRACE", "SSC_STARTUP_TRACE_EXIT" }) {
+      if (getEnv(key).size() > 0) {
+        env[[NSString stringWithUTF8String: key]] = [NSString stringWithUTF8String: getEnv(key).c_str()];
+      }
+    }
+
     for (auto const &envKey : parseStringList(settings["build_env"])) {
       auto cleanKey = trim(envKey);
       auto envValue = getEnv(cleanKey.c_str());
@@ -574,6 +1081,164 @@ int runApp (const Path& path, const String& args) {
   return runApp(path, args, false);
 }
 
+//
+// Watch mode
+// ---
+// `ssc build --watch` watches the project directory, reruns the build with
+// `--only-build` on changes and asks the running app to reload. An only-build
+// run reruns the build script and the copy stage, and only rebuilds the native
+// binary (or restores it from the build cache) when `socket.ini` changed. The
+// app connects back to the CLI on the dev host and port for reload requests.
+//
+constexpr int WATCH_QUIET_TIMEOUT = 50; // in milliseconds
+
+static void stopApp () {
+  if (appProcess != nullptr) {
+    appProcess->kill(appPid);
+  }
+#ifndef _WIN32
+  else if (appPid > 0) {
+    ::kill(appPid, SIGTERM);
+  }
+#endif
+}
+
+int runWatchMode (
+  const Path& binaryPath,
+  const String& argvForward,
+  bool headless,
+  const String& rebuildCommand,
+  const Path& root,
+  const Vector<Path>& ignored,
+  int port
+) {
+  DevWatcher watcher;
+  std::mutex mutex;
+  std::map<String, steady_clock::time_point> pendingReloads;
+  std::atomic<bool> isRestarting = false;
+  std::atomic<uint64_t> nextReloadId = 0;
+
+  watcher.onReloaded = [&](const String& id) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto pending = pendingReloads.find(id);
+
+    // every window acknowledges a reload, only the first one counts
+    if (pending != pendingReloads.end()) {
+      auto latency = duration_cast<milliseconds>(steady_clock::now() - pending->second);
+      log("reloaded, edit to screen in " + std::to_string(latency.count()) + "ms");
+      pendingReloads.erase(pending);
+    }
+  };
+
+  auto listening = watcher.start(root, ignored, port);
+
+  if (listening < 0) {
+    log("ERROR: unable to listen on port " + std::to_string(port) + ": " + uv_strerror(listening));
+    exit(1);
+  }
+
+  port = listening;
+  setEnv("SSC_DEV_HOST", "127.0.0.1");
+  setEnv("SSC_DEV_PORT", std::to_string(port));
+  log("watching " + root.string() + " for changes");
+
+  auto runAppInBackground = [&]() {
+    std::thread([&]() {
+      auto exitCode = runApp(binaryPath, argvForward, headless);
+
+      // the app was closed, not restarted by a rebuild
+      if (!isRestarting.exchange(false)) {
+        exit(exitCode);
+      }
+    }).detach();
+  };
+
+  runAppInBackground();
+
+  // the contents of changed files when they were last built, so a build
+  // script rewriting files in the project does not trigger endless rebuilds
+  std::map<Path, uint64_t> builtContents;
+
+  while (true) {
+    // changes made while rebuilding are kept for the next iteration
+    auto changes = watcher.wait(WATCH_QUIET_TIMEOUT);
+
+    std::erase_if(changes.paths, [&](const Path& path) {
+      std::error_code ec;
+
+      if (!fs::is_regular_file(path, ec)) {
+        builtContents.erase(path);
+        return false;
+      }
+
+      uint64_t hash = 0;
+
+      try {
+        hash = hashFile(BUILD_CACHE_HASH_SEED, path);
+      } catch (const fs::filesystem_error&) {
+        // removed while hashing, the next event reports it
+        return false;
+      }
+
+      auto built = builtContents.find(path);
+
+      if (built != builtContents.end() && built->second == hash) {
+        return true;
+      }
+
+      builtContents[path] = hash;
+      return false;
+    });
+
+    if (changes.paths.size() == 0) {
+      continue;
+    }
+
+    auto binaryMtime = fs::last_write_time(binaryPath);
+
+    log("rebuilding after " + std::to_string(changes.paths.size()) + " changed path(s)");
+
+    auto r = exec(rebuildCommand, [](const char *bytes, size_t size) {
+      std::cout.write(bytes, size);
+    });
+
+    watcher.rescan();
+
+    auto rebuildTime = duration_cast<milliseconds>(steady_clock::now() - changes.time);
+
+    if (r.exitCode != 0) {
+      log("rebuild failed with exit code " + std::to_string(r.exitCode));
+      continue;
+    }
+
+    log("rebuilt in " + std::to_string(rebuildTime.count()) + "ms");
+
+    if (fs::last_write_time(binaryPath) != binaryMtime) {
+      log("native binary changed, restarting the app");
+      isRestarting = true;
+      stopApp();
+
+      while (isRestarting) {
+        std::this_thread::sleep_for(milliseconds(WATCH_QUIET_TIMEOUT));
+      }
+
+      runAppInBackground();
+      continue;
+    }
+
+    auto id = std::to_string(++nextReloadId);
+
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      pendingReloads[id] = changes.time;
+    }
+
+    watcher.send("reload " + id);
+  }
+
+  return 0;
+}
+
 void runIOSSimulator (const Path& path, Map& settings) {
   #ifndef _WIN32
   if (settings["ios_simulator_device"].size() == 0) {
@@ -587,7 +1252,15 @@ void runIOSSimulator (const Path& path, Map& settings) {
     << " simctl"
     << " list devicetypes";
 
-  auto rListDeviceTypes = exec(listDeviceTypesCommand.str().c_str());
+  StringStream listDevicesCommand;
+  listDevicesCommand
+    << "xcrun"
+    << " simctl"
+    << " list devices available";
+
+  // both lists are independent, so query them concurrently
+  auto rLists = execAll({ listDeviceTypesCommand.str(), listDevicesCommand.str() });
+  auto rListDeviceTypes = rLists[0];
   if (rListDeviceTypes.exitCode != 0) {
     log("failed to list device types using \"" + listDeviceTypesCommand.str() + "\"");
     if (rListDeviceTypes.output.size() > 0) {
@@ -615,12 +1288,7 @@ void runIOSSimulator (const Path& path, Map& settings) {
     exit(rListDevices.exitCode);
   }
 
-  StringStream listDevicesCommand;
-  listDevicesCommand
-    << "xcrun"
-    << " simctl"
-    << " list devices available";
-  auto rListDevices = exec(listDevicesCommand.str().c_str());
+  auto rListDevices = rLists[1];
   if (rListDevices.exitCode != 0) {
     log("failed to list available devices using \"" + listDevicesCommand.str() + "\"");
     if (rListDevices.output.size() > 0) {
@@ -1545,8 +2213,9 @@ int main (const int argc, const char* argv[]) {
     exit(0);
   });
 
-  createSubcommand("build", { "--platform", "--host", "--port", "--quiet", "-o", "--only-build", "-r", "--run", "--prod", "-p", "-c", "-s", "-e", "-n", "--test", "--headless" }, true, [&](const std::span<const char *>& options) -> void {
+  createSubcommand("build", { "--platform", "--host", "--port", "--quiet", "-o", "--only-build", "-r", "--run", "--watch", "--prod", "-p", "-c", "-s", "-e", "-n", "--test", "--headless" }, true, [&](const std::span<const char *>& options) -> void {
     bool flagRunUserBuildOnly = false;
+    bool flagWatch = false;
     bool flagAppStore = false;
     bool flagCodeSign = false;
     bool flagHeadless = false;
@@ -1623,6 +2292,11 @@ int main (const int argc, const char* argv[]) {
         flagShouldRun = true;
       }
 
+      if (is(arg, "--watch")) {
+        flagWatch = true;
+        flagShouldRun = true;
+      }
+
       if (is(arg, "-s")|| is(rc["build_app_store"], "true")) {
         flagAppStore = true;
       }
@@ -1685,6 +2359,13 @@ int main (const int argc, const char* argv[]) {
       if (portArg.size() == 0) {
         portArg = optionValue("build", arg, "--port");
         if (portArg.size() > 0) {
+          auto isPort = portArg.size() <= 5 && std::all_of(portArg.begin(), portArg.end(), ::isdigit);
+
+          if (!isPort || std::stoi(portArg) > 65535) {
+            log("ERROR: invalid port: " + portArg);
+            exit(1);
+          }
+
           devPort = portArg;
         }
       }
@@ -1781,6 +2462,9 @@ int main (const int argc, const char* argv[]) {
 
     String flags;
     String files;
+    // `files` and the libraries linked through `flags`, hashed by path and
+    // content into the build cache key of the native binary
+    Vector<Path> linkInputs;
 
     Path pathResources;
     Path pathToArchive;
@@ -1821,6 +2505,17 @@ int main (const int argc, const char* argv[]) {
       files += prefixFile("src/init.cc");
       flags += " " + getCxxFlags();
 
+      linkInputs.push_back(prefixFile() + "objects/" + platform.arch + "-desktop/desktop/main.o");
+      linkInputs.push_back(prefixFile() + "src/init.cc");
+      linkInputs.push_back(prefixFile() + "lib/" + platform.arch + "-desktop/libsocket-runtime.a");
+      linkInputs.push_back(prefixFile() + "lib/" + platform.arch + "-desktop/libuv.a");
+
+      // shipped next to the runtime library when it was built with `SSC_CRYPTO_SODIUM=1`
+      if (fs::exists(prefixFile() + "lib/" + platform.arch + "-desktop/libsodium.a")) {
+        files += prefixFile("lib/" + platform.arch + "-desktop/libsodium.a");
+        linkInputs.push_back(prefixFile() + "lib/" + platform.arch + "-desktop/libsodium.a");
+      }
+
       Path pathBase = "Contents";
       pathResources = { paths.pathPackage / pathBase / "Resources" };
 
@@ -2386,7 +3081,8 @@ int main (const int argc, const char* argv[]) {
     if (platform.linux && !flagBuildForAndroid && !flagBuildForIOS) {
       log("preparing build for linux");
       flags = " -std=c++2a `pkg-config --cflags --libs gtk+-3.0 webkit2gtk-4.1`";
-      flags += " -ldl " + getCxxFlags();
+      flags += " -ldl";
+      flags += " " + getCxxFlags();
       flags += " -I" + Path(paths.platformSpecificOutputPath / "include").string();
       flags += " -I" + prefixFile();
       flags += " -I" + prefixFile("include");
@@ -2397,6 +3093,17 @@ int main (const int argc, const char* argv[]) {
       files += prefixFile("lib/" + platform.arch + "-desktop/libsocket-runtime.a");
       files += prefixFile("lib/" + platform.arch + "-desktop/libuv.a");
 
+      linkInputs.push_back(prefixFile() + "objects/" + platform.arch + "-desktop/desktop/main.o");
+      linkInputs.push_back(prefixFile() + "src/init.cc");
+      linkInputs.push_back(prefixFile() + "lib/" + platform.arch + "-desktop/libsocket-runtime.a");
+      linkInputs.push_back(prefixFile() + "lib/" + platform.arch + "-desktop/libuv.a");
+
+      // shipped next to the runtime library when it was built with `SSC_CRYPTO_SODIUM=1`
+      if (fs::exists(prefixFile() + "lib/" + platform.arch + "-desktop/libsodium.a")) {
+        files += prefixFile("lib/" + platform.arch + "-desktop/libsodium.a");
+        linkInputs.push_back(prefixFile() + "lib/" + platform.arch + "-desktop/libsodium.a");
+      }
+
       pathResources = paths.pathBin;
 
       // @TODO(jwerle): support other Linux based OS
@@ -2519,14 +3226,17 @@ int main (const int argc, const char* argv[]) {
         missing_assets = true;
       } else {
         files += main_o;
+        linkInputs.push_back(trim(main_o));
       }
       files += prefixFile("src/init.cc");
+      linkInputs.push_back(prefixFile() + "src/init.cc");
       auto static_runtime = prefixFile("lib" + d + "/" + platform.arch + "-desktop/libsocket-runtime" + d + ".a");
       if (!fs::exists(static_runtime)) {
         log("Can't find static runtime, unable to build: " + static_runtime);
         missing_assets = true;
       } else {
         files += static_runtime;
+        linkInputs.push_back(trim(static_runtime));
       }
 
       if (missing_assets) {
@@ -2621,6 +3331,9 @@ int main (const int argc, const char* argv[]) {
       fs::current_path(oldCwd);
     }
 
+    CopyPlan copyPlan;
+    copyPlan.root = fs::absolute(pathResourcesRelativeToUserBuild);
+
     if (settings.count("build_copy") != 0) {
       Path pathInput = settings["build_copy"].size() > 0
         ? settings["build_copy"]
@@ -2639,15 +3352,7 @@ int main (const int argc, const char* argv[]) {
           continue;
         }
 
-        if (!fs::exists(fs::status(dst.parent_path()))) {
-          fs::create_directories(dst.parent_path());
-        }
-
-        fs::copy(
-          src,
-          dst,
-          fs::copy_options::update_existing | fs::copy_options::recursive
-        );
+        copyPlan.add(src, dst);
       }
     // @deprecated
     } else if (settings.count("build_input") != 0) {
@@ -2660,11 +3365,8 @@ int main (const int argc, const char* argv[]) {
       Path pathInput = settings["build_input"].size() > 0
         ? targetPath / settings["build_input"]
         : targetPath / "src";
-      fs::copy(
-        pathInput,
-        pathResourcesRelativeToUserBuild,
-        fs::copy_options::update_existing | fs::copy_options::recursive
-      );
+
+      copyPlan.add(pathInput, pathResourcesRelativeToUserBuild);
     }
 
     for (const auto& tuple : settings) {
@@ -2695,24 +3397,13 @@ int main (const int argc, const char* argv[]) {
         continue;
       }
 
-      if (!fs::exists(fs::status(dst.parent_path()))) {
-        fs::create_directories(dst.parent_path());
-      }
-
-      auto mappedSourceFile = (
+      // a mapped file replaces its unmapped copy
+      copyPlan.remove(
         pathResourcesRelativeToUserBuild /
         fs::relative(src, targetPath)
       );
 
-      if (fs::exists(fs::status(mappedSourceFile))) {
-        fs::remove_all(mappedSourceFile);
-      }
-
-      fs::copy(
-        src,
-        dst,
-        fs::copy_options::update_existing | fs::copy_options::recursive
-      );
+      copyPlan.add(src, dst);
     }
 
     if (settings.count("build_copy_map") != 0) {
@@ -2767,24 +3458,12 @@ int main (const int argc, const char* argv[]) {
             continue;
           }
 
-          if (!fs::exists(fs::status(dst.parent_path()))) {
-            fs::create_directories(dst.parent_path());
-          }
-
-          auto mappedSourceFile = (
+          copyPlan.remove(
             pathResourcesRelativeToUserBuild /
             fs::relative(src, copyMapFileDirectory)
           );
 
-          if (fs::exists(fs::status(mappedSourceFile))) {
-            fs::remove_all(mappedSourceFile);
-          }
-
-          fs::copy(
-            src,
-            dst,
-            fs::copy_options::update_existing | fs::copy_options::recursive
-          );
+          copyPlan.add(src, dst);
         }
       }
     }
@@ -2797,11 +3476,7 @@ int main (const int argc, const char* argv[]) {
 
     if (fs::exists(fs::status(SOCKET_HOME_API))) {
       fs::create_directories(pathResources);
-      fs::copy(
-        SOCKET_HOME_API,
-        pathResources / "socket",
-        fs::copy_options::update_existing | fs::copy_options::recursive
-      );
+      copyPlan.add(SOCKET_HOME_API, pathResources / "socket");
 
       // XXX(@jwerle): 'node_modules/' sometimes can be found in the
       // SOCKET_HOME_API directory if distributed with npm. Handle all
@@ -2809,7 +3484,98 @@ int main (const int argc, const char* argv[]) {
       auto nodePaths = parseStringList(getEnv("NODE_PATH"), { ':', ';' });
       nodePaths.push_back("node_modules");
       for (const auto& path : nodePaths) {
-        fs::remove_all(pathResources / "socket" / path);
+        copyPlan.remove(pathResources / "socket" / path);
+      }
+    }
+
+    // with `[build] archive` (Linux only) planned files are packed straight
+    // from their sources, together with the files the build script wrote
+    // into the resources directory. They are still copied: windows,
+    // navigation and `fs` reads load resources with `file:` paths
+    auto shouldPackResources = (
+      platform.linux && !flagBuildForAndroid && !flagBuildForIOS &&
+      settings["build_archive"] == "true"
+    );
+
+    auto copyManifestKey = hashString(BUILD_CACHE_HASH_SEED, copyPlan.root.string());
+    auto copyManifestPath = getBuildCachePath(targetPath) / "copy" / (getBuildCacheKey(copyManifestKey) + ".manifest");
+    std::map<Path, Path> packedFiles;
+
+    if (shouldPackResources) {
+      std::error_code ec;
+      auto root = copyPlan.root;
+      auto options = fs::directory_options::follow_directory_symlink;
+
+      for (auto const& entry : fs::recursive_directory_iterator(root, options, ec)) {
+        if (entry.is_regular_file(ec)) {
+          packedFiles[entry.path().lexically_normal()] = entry.path();
+        }
+      }
+
+      // outputs copied by a previous build are removed by the copy stage
+      // below, they are not build script outputs
+      for (auto const& tuple : CopyPlan::readManifest(copyManifestPath)) {
+        packedFiles.erase(tuple.first);
+      }
+
+      packedFiles.erase((root / executable).lexically_normal());
+      packedFiles.erase((root / "resources.pack").lexically_normal());
+
+      for (auto const& excluded : copyPlan.excluded) {
+        auto prefix = excluded.string() + (char) fs::path::preferred_separator;
+        std::erase_if(packedFiles, [&](const auto& tuple) {
+          return tuple.first == excluded || tuple.first.string().starts_with(prefix);
+        });
+      }
+
+      // planned files replace build script outputs, like a copy would
+      for (auto const& tuple : copyPlan.files) {
+        packedFiles[tuple.first] = tuple.second;
+      }
+    }
+
+    {
+      auto stats = copyPlan.run(copyManifestPath, settings["build_copy_hardlinks"] == "true");
+
+      log(
+        "copied " + std::to_string(stats.copied) + " files (" +
+        std::to_string(stats.unchanged) + " unchanged, " +
+        std::to_string(stats.removed) + " removed)"
+      );
+    }
+
+    if (platform.linux && !flagBuildForAndroid && !flagBuildForIOS) {
+      auto archivePath = pathResources / "resources.pack";
+
+      if (shouldPackResources) {
+        Vector<Archive::Source> sources;
+
+        for (auto const& tuple : packedFiles) {
+          auto path = fs::relative(tuple.first, copyPlan.root).generic_string();
+          auto encoding = Archive::Encoding::Identity;
+
+          // `file.gz` next to `file` is stored precompressed in its place
+          if (path.ends_with(".gz")) {
+            auto decoded = tuple.first.parent_path() / tuple.first.stem();
+            if (packedFiles.count(decoded) > 0) {
+              path = path.substr(0, path.size() - 3);
+              encoding = Archive::Encoding::Gzip;
+            }
+          } else if (packedFiles.count(Path(tuple.first.string() + ".gz")) > 0) {
+            continue;
+          }
+
+          sources.push_back(Archive::Source { path, tuple.second, encoding });
+        }
+
+        if (!Archive::write(archivePath, sources)) {
+          log("ERROR: unable to write resource archive '" + archivePath.string() + "'");
+          exit(1);
+        }
+
+        log("packed " + std::to_string(sources.size()) + " resources");
+      } else if (fs::exists(archivePath)) {
+        fs::remove(archivePath);
       }
     }
 
@@ -2998,9 +3764,6 @@ int main (const int argc, const char* argv[]) {
             }
         }
 
-        // TODO(mribbons): Cache binaries, hash based on source contents. Copy if cache matches rather than building.
-        // TODO(mribbons): Expand cache system to other target platforms
-
         auto output = paths.platformSpecificOutputPath;
         // auto app = output / "app";
         auto src = app / "src";
@@ -3039,23 +3802,64 @@ int main (const int argc, const char* argv[]) {
           if (androidBuildSocketRuntime) {
             fs::create_directories(jniLibs);
 
-            ndkBuildArgs
-              << ndkBuild.str()
-              << " -j"
-              << " NDK_PROJECT_PATH=" << _main
-              << " NDK_APPLICATION_MK=" << app_mk
-              << (flagDebugMode ? " NDK_DEBUG=1" : "")
-              << " APP_PLATFORM=" << androidPlatform
-              << " NDK_LIBS_OUT=" << jniLibs
-            ;
-
-            if (!(debugEnv || verboseEnv)) ndkBuildArgs << " >" << (!platform.win ? "/dev/null" : "NUL") << " 2>&1";
-
-            if (debugEnv || verboseEnv) log(ndkBuildArgs.str());
-            if (std::system(ndkBuildArgs.str().c_str()) != 0) {
-              log(ndkBuildArgs.str());
-              log("ERROR: ndk build failed.");
-              exit(1);
+            // the runtime libraries only depend on the sources and settings
+            // copied into `jni/` and on the ndk-build options
+            auto cacheHash = hashString(BUILD_CACHE_HASH_SEED, ndkBuild.str());
+            cacheHash = hashString(cacheHash, androidPlatform);
+            cacheHash = hashString(cacheHash, flagDebugMode ? "debug" : "release");
+            cacheHash = hashDirectory(cacheHash, jni);
+
+            auto cachedJniLibs = getBuildCachePath(targetPath) / "android" / getBuildCacheKey(cacheHash);
+
+            if (fs::exists(cachedJniLibs)) {
+              fs::copy(
+                cachedJniLibs,
+                jniLibs,
+                fs::copy_options::overwrite_existing | fs::copy_options::recursive
+              );
+
+              touchBuildCacheEntry(cachedJniLibs);
+              log("restored android runtime libraries from build cache");
+            } else {
+              ndkBuildArgs
+                << ndkBuild.str()
+                << " -j"
+                << " NDK_PROJECT_PATH=" << _main
+                << " NDK_APPLICATION_MK=" << app_mk
+                << (flagDebugMode ? " NDK_DEBUG=1" : "")
+                << " APP_PLATFORM=" << androidPlatform
+                << " NDK_LIBS_OUT=" << jniLibs
+              ;
+
+              if (!(debugEnv || verboseEnv)) ndkBuildArgs << " >" << (!platform.win ? "/dev/null" : "NUL") << " 2>&1";
+
+              if (debugEnv || verboseEnv) log(ndkBuildArgs.str());
+              if (std::system(ndkBuildArgs.str().c_str()) != 0) {
+                log(ndkBuildArgs.str());
+                log("ERROR: ndk build failed.");
+                exit(1);
+              }
+
+              auto cachedJniLibsTempPath = Path(cachedJniLibs.string() + ".tmp");
+              std::error_code ec;
+              fs::remove_all(cachedJniLibsTempPath, ec);
+              fs::create_directories(cachedJniLibsTempPath, ec);
+              fs::copy(
+                jniLibs,
+                cachedJniLibsTempPath,
+                fs::copy_options::overwrite_existing | fs::copy_options::recursive,
+                ec
+              );
+
+              if (!ec) {
+                fs::rename(cachedJniLibsTempPath, cachedJniLibs, ec);
+              }
+
+              if (ec) {
+                log("WARNING: unable to write to build cache: " + ec.message());
+              }
+
+              evictBuildCache(getBuildCachePath(targetPath));
             }
           }
         }
@@ -3180,39 +3984,174 @@ int main (const int argc, const char* argv[]) {
         quote = "\"";
       }
 
-      // windows / spaces in bin path - https://stackoverflow.com/a/27976653/3739540
-      compileCommand
-        << quote // win32 - quote the entire command
-        << quote // win32 - quote the binary path
-        << getEnv("CXX")
-        << quote // win32 - quote the binary path
-        << " " << files
+      // `--prod` desktop builds with clang link the ThinLTO variant of the
+      // runtime library when it is installed (bin/build-runtime-library.sh
+      // --lto). `SSC_PGO=generate` instruments the binary and
+      // `SSC_PGO=<file.profdata>` optimizes it with a merged profile.
+      String optimizationFlags = "";
+      auto pgo = getEnv("SSC_PGO");
+      auto isClang = getEnv("CXX").find("clang") != String::npos;
+      auto isDesktop = !flagBuildForIOS && !flagBuildForAndroid;
+      auto ltoLibraryPath = Path(prefixFile()) / "lib" / (platform.arch + "-desktop") / "libsocket-runtime-lto.a";
+
+      if (!flagDebugMode && isClang && isDesktop && fs::exists(ltoLibraryPath)) {
+        files = replace(files, "libsocket-runtime\\.a", "libsocket-runtime-lto.a");
+        flags = replace(flags, "-lsocket-runtime( |$)", "-lsocket-runtime-lto$1");
+
+        for (auto& input : linkInputs) {
+          if (input.filename() == "libsocket-runtime.a") {
+            input = ltoLibraryPath;
+          }
+        }
+        optimizationFlags += " -flto=thin";
+
+        if (platform.linux) {
+          optimizationFlags += " -fuse-ld=lld";
+        }
+
+        log("linking the ThinLTO runtime library");
+      }
+
+      if (!flagDebugMode && isClang && isDesktop && pgo == "generate") {
+        optimizationFlags += " -fprofile-instr-generate";
+      } else if (!flagDebugMode && isClang && isDesktop && pgo.size() > 0) {
+        optimizationFlags += " -fprofile-instr-use=" + fs::absolute(pgo).string();
+      }
+
+      // settings are compiled in through `user-config-bytes.hh` in init.cc,
+      // which is part of the cache key below, and are not passed as a define
+      StringStream compileFlags;
+      compileFlags
         << " " << flags
         << " " << extraFlags
-        << " -o " << binaryPath.string()
         << " -DIOS=" << (flagBuildForIOS ? 1 : 0)
         << " -DANDROID=" << (flagBuildForAndroid ? 1 : 0)
         << " -DDEBUG=" << (flagDebugMode ? 1 : 0)
         << " -DHOST=" << devHost
         << " -DPORT=" << devPort
-        << " -DSSC_SETTINGS=\"" << encodeURIComponent(_settings) << "\""
         << " -DSSC_VERSION=" << SSC::VERSION_STRING
         << " -DSSC_VERSION_HASH=" << SSC::VERSION_HASH_STRING
-        << quote // win32 - quote the entire command
+        << optimizationFlags
       ;
 
-      if (getEnv("DEBUG") == "1" || getEnv("VERBOSE") == "1")
-        log(compileCommand.str());
+      StringStream compileArguments;
+      compileArguments << " " << files << compileFlags.str();
+
+      // `init.cc` only includes `common.hh`, which is precompiled with the
+      // same defines and flags
+      auto precompiledHeader = getPrecompiledHeader(
+        getBuildCachePath(targetPath),
+        getEnv("CXX"),
+        compileFlags.str(),
+        trim(prefixFile("src/common.hh")),
+        platform.mac ? "objective-c++-header" : "c++-header",
+        quote
+      );
 
-      auto r = exec(compileCommand.str());
+      // windows / spaces in bin path - https://stackoverflow.com/a/27976653/3739540
+      auto writeCompileCommand = [&]() {
+        compileCommand.str("");
+        compileCommand
+          << quote // win32 - quote the entire command
+          << quote // win32 - quote the binary path
+          << getEnv("CXX")
+          << quote // win32 - quote the binary path
+          << compileArguments.str()
+          << (precompiledHeader.empty() ? "" : " -include-pch " + precompiledHeader.string())
+          << " -o " << binaryPath.string()
+          << quote // win32 - quote the entire command
+        ;
+      };
 
-      if (r.exitCode != 0) {
-        log("Unable to build");
-        log(r.output);
-        exit(r.exitCode);
+      writeCompileCommand();
+
+      auto cacheHash = hashString(BUILD_CACHE_HASH_SEED, getEnv("CXX"));
+      cacheHash = hashString(cacheHash, getCompilerVersion(getEnv("CXX"), quote));
+      cacheHash = hashString(cacheHash, compileArguments.str());
+      cacheHash = hashFile(cacheHash, paths.platformSpecificOutputPath / "include" / "user-config-bytes.hh");
+
+      if (pgo.size() > 0 && pgo != "generate" && fs::exists(pgo)) {
+        cacheHash = hashFile(cacheHash, pgo);
       }
 
-      log("compiled native binary");
+      for (auto const& input : linkInputs) {
+        cacheHash = hashString(cacheHash, input.string());
+
+        if (fs::exists(input)) {
+          cacheHash = hashFile(cacheHash, input);
+        }
+      }
+
+      auto cachedBinaryPath = getBuildCachePath(targetPath) / "bin" / (getBuildCacheKey(cacheHash) + executable.extension().string());
+
+      if (fs::exists(cachedBinaryPath)) {
+        fs::copy_file(cachedBinaryPath, binaryPath, fs::copy_options::overwrite_existing);
+        touchBuildCacheEntry(cachedBinaryPath);
+        log("restored native binary from build cache");
+      } else {
+        if (getEnv("DEBUG") == "1" || getEnv("VERBOSE") == "1")
+          log(compileCommand.str());
+
+        auto isVerbose = getEnv("DEBUG") == "1" || getEnv("VERBOSE") == "1";
+        auto compileStart = steady_clock::now();
+        auto r = exec(compileCommand.str(), isVerbose
+          ? [](const char *bytes, size_t size) { std::cout.write(bytes, size); }
+          : ExecOutputCallback(nullptr)
+        );
+
+        // a PCH built against headers that changed since is rejected by
+        // clang, so drop it and compile without it
+        if (
+          r.exitCode != 0 &&
+          !precompiledHeader.empty() &&
+          (
+            r.output.find("precompiled") != String::npos ||
+            r.output.find("PCH") != String::npos ||
+            r.output.find("AST file") != String::npos
+          )
+        ) {
+          log("WARNING: precompiled header '" + precompiledHeader.string() + "' was rejected, compiling without it");
+
+          std::error_code ec;
+          fs::remove(precompiledHeader, ec);
+          precompiledHeader = Path();
+          writeCompileCommand();
+
+          r = exec(compileCommand.str(), isVerbose
+            ? [](const char *bytes, size_t size) { std::cout.write(bytes, size); }
+            : ExecOutputCallback(nullptr)
+          );
+        }
+
+        if (r.exitCode != 0) {
+          log("Unable to build");
+          if (!isVerbose) log(r.output);
+          exit(r.exitCode);
+        }
+
+        auto compileTime = duration_cast<milliseconds>(steady_clock::now() - compileStart).count();
+        log(
+          "compiled native binary in " + std::to_string(compileTime) + "ms" +
+          (precompiledHeader.empty() ? "" : " (precompiled headers)")
+        );
+
+        // write to a temporary file first so a concurrent build never
+        // restores a partially written binary
+        auto cachedBinaryTempPath = Path(cachedBinaryPath.string() + ".tmp");
+        std::error_code ec;
+        fs::create_directories(cachedBinaryPath.parent_path(), ec);
+        fs::copy_file(binaryPath, cachedBinaryTempPath, fs::copy_options::overwrite_existing, ec);
+
+        if (!ec) {
+          fs::rename(cachedBinaryTempPath, cachedBinaryPath, ec);
+        }
+
+        if (ec) {
+          log("WARNING: unable to write to build cache: " + ec.message());
+        }
+
+        evictBuildCache(getBuildCachePath(targetPath));
+      }
     }
 
     //
@@ -3750,6 +4689,45 @@ int main (const int argc, const char* argv[]) {
       }
     }
 
+    if (flagWatch) {
+      if (flagBuildForIOS || flagBuildForAndroid) {
+        log("ERROR: --watch is only supported for desktop builds");
+        exit(1);
+      }
+
+      // rebuild with the same options, but only run the build script and
+      // the copy stage unless 'socket.ini' changed
+      StringStream rebuildCommand;
+      rebuildCommand << quote << fs::absolute(argv[0]).string() << quote << " build -o";
+
+      for (auto const option : options) {
+        if (
+          is(option, "-r") || is(option, "--run") || is(option, "--watch") ||
+          is(option, "-o") || is(option, "--only-build")
+        ) {
+          continue;
+        }
+
+        rebuildCommand << " " << quote << option << quote;
+      }
+
+      rebuildCommand << " " << quote << targetPath.string() << quote;
+
+      exit(runWatchMode(
+        binaryPath,
+        argvForward,
+        flagHeadless,
+        rebuildCommand.str(),
+        targetPath,
+        {
+          targetPath / settings["build_output"],
+          targetPath / ".git",
+          targetPath / "node_modules"
+        },
+        std::stoi(devPort)
+      ));
+    }
+
     int exitCode = 0;
     if (flagShouldRun) {
       exitCode = runApp(binaryPath, argvForward, flagHeadless);
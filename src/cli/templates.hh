@@ -37,6 +37,7 @@ options:
   --port=<port>         load "index.html" from "http://localhost:<port>"
   -o, --only-build      only run build step,
   -r, --run             run after building
+  --watch               run, then rebuild and reload the app on changes
   --headless            run headlessly
   --stdin               read from stdin (emitted in window 0)
   --test[=path]         indicate test mode, optionally importing a test file
@@ -1372,6 +1373,16 @@ constexpr auto gDefaultConfig = R"INI(
 ; the Socket bundle resources directory.
 copy = "src"
 
+; If true, copied files are hard linked to their source where possible instead
+; of being copied. Only use this if nothing modifies the build output in place.
+copy_hardlinks = false
+
+; If true, files are also packed into a single archive that the runtime
+; memory maps and serves the default window from (Linux only), along with the
+; files the build script wrote. Files missing from the archive are served
+; from disk. A `file.gz` next to `file` is packed precompressed in its place.
+archive = false
+
 ; An list of environment variables, separated by commas.
 env = USER, TMPDIR, PWD
 
@@ -1395,6 +1406,26 @@ output = "build"
 flags = "-g"
 
 
+[core]
+
+; If true, the runtime event loop sleeps between passes to coalesce wakeups.
+; This lowers power usage at the cost of higher IPC latency.
+event_loop_power_saving = false
+
+; The protocol of the stdout and stdin pipes of the "back-end" process. Use
+; "framed" for length-prefixed binary frames instead of newline delimited text.
+backend_protocol = "lines"
+
+; If true, the stdio pipes of the "back-end" process are read on the runtime
+; event loop instead of a dedicated thread. Not supported on Windows.
+backend_event_loop = false
+
+; If true, the proxy modules served for `socket:` imports are all prepared
+; at launch instead of on first import, and an import map resolves `socket:`
+; imports straight to the module files (Linux only).
+preload_modules = false
+
+
 [meta]
 
 ; A unique ID that identifies the bundle (used by all app stores).
@@ -0,0 +1,305 @@
+#ifndef SSC_CLI_WATCHER_H
+#define SSC_CLI_WATCHER_H
+
+#include "../common.hh"
+
+#include <condition_variable>
+#include <set>
+#include <uv.h>
+
+namespace SSC {
+  //
+  // Watches a project directory for `ssc build --watch` and serves the
+  // reload requests the running app connects back for, see `runWatchMode()`.
+  //
+  class DevWatcher {
+    public:
+      using ReloadCallback = std::function<void(const String&)>;
+
+      struct Changes {
+        std::set<Path> paths;
+        std::chrono::steady_clock::time_point time;
+      };
+
+      ReloadCallback onReloaded = nullptr;
+
+      // Starts watching `root` and listening for the app on `port` (0 for any
+      // free port) on the loopback interface. Returns the bound port, or a
+      // negative libuv error code if it could not listen.
+      int start (const Path& root, const Vector<Path>& ignored, int port) {
+        this->root = root;
+        this->ignored = ignored;
+
+        uv_loop_init(&this->loop);
+        uv_async_init(&this->loop, &this->async, [](uv_async_t *handle) {
+          reinterpret_cast<DevWatcher *>(handle->data)->flush();
+        });
+
+        this->async.data = this;
+        this->server.data = this;
+
+        struct sockaddr_in addr;
+        int namelen = sizeof(addr);
+        uv_ip4_addr("127.0.0.1", port, &addr);
+        uv_tcp_init(&this->loop, &this->server);
+
+        auto err = uv_tcp_bind(&this->server, (const struct sockaddr *) &addr, 0);
+
+        if (err == 0) {
+          err = uv_listen((uv_stream_t *) &this->server, 16, [](uv_stream_t *server, int status) {
+            if (status == 0) {
+              reinterpret_cast<DevWatcher *>(server->data)->accept();
+            }
+          });
+        }
+
+        if (err != 0) {
+          return err;
+        }
+
+        uv_tcp_getsockname(&this->server, (struct sockaddr *) &addr, &namelen);
+        this->watch(root);
+
+        this->thread = std::thread([this]() {
+          uv_run(&this->loop, UV_RUN_DEFAULT);
+        });
+
+        return ntohs(addr.sin_port);
+      }
+
+      // Blocks until something changed, then until no more changes arrive
+      // for `quiet` milliseconds, so a save of many files is one rebuild.
+      Changes wait (int quiet) {
+        std::unique_lock<std::mutex> lock(this->mutex);
+        this->condition.wait(lock, [this] { return this->changes.paths.size() > 0; });
+
+        auto count = this->changes.paths.size();
+        while (this->condition.wait_for(lock, std::chrono::milliseconds(quiet), [&] {
+          return this->changes.paths.size() != count;
+        })) {
+          count = this->changes.paths.size();
+        }
+
+        Changes changes = this->changes;
+        this->changes.paths.clear();
+        return changes;
+      }
+
+      // Watches directories created since the last scan, for example by a
+      // rebuild. Changes made in the meantime are kept for the next `wait()`.
+      void rescan () {
+        {
+          std::lock_guard<std::mutex> lock(this->mutex);
+          this->rescanning = true;
+        }
+
+        uv_async_send(&this->async);
+      }
+
+      // Sends a line to all connected apps.
+      void send (const String& line) {
+        {
+          std::lock_guard<std::mutex> lock(this->mutex);
+          this->outgoing.push_back(line + "\n");
+        }
+
+        uv_async_send(&this->async);
+      }
+
+    private:
+      struct Client {
+        uv_tcp_t handle;
+        DevWatcher *watcher;
+        String buffer;
+      };
+
+      struct Write {
+        uv_write_t request;
+        String bytes;
+      };
+
+      uv_loop_t loop;
+      uv_async_t async;
+      uv_tcp_t server;
+      std::thread thread;
+      Path root;
+      Vector<Path> ignored;
+      std::set<String> directories;
+      std::set<Client *> clients;
+
+      std::mutex mutex;
+      std::condition_variable condition;
+      Changes changes;
+      Vector<String> outgoing;
+      bool rescanning = false;
+
+      bool isIgnored (const Path& path) {
+        for (auto const& ignored : this->ignored) {
+          auto prefix = ignored.string() + (char) fs::path::preferred_separator;
+          if (path == ignored || path.string().starts_with(prefix)) {
+            return true;
+          }
+        }
+
+        return false;
+      }
+
+      // Watches `path` and, where file system events are not recursive
+      // (inotify on Linux), each of its directories with its own watcher.
+      void watch (const Path& path) {
+        std::error_code ec;
+
+        if (this->isIgnored(path) || this->directories.contains(path.string())) {
+          return;
+        }
+
+        auto handle = new uv_fs_event_t;
+        handle->data = this;
+        uv_fs_event_init(&this->loop, handle);
+
+      #if defined(__linux__)
+        auto flags = 0;
+      #else
+        auto flags = UV_FS_EVENT_RECURSIVE;
+      #endif
+
+        auto err = uv_fs_event_start(handle, [](uv_fs_event_t *handle, const char *filename, int, int status) {
+          if (status == 0) {
+            reinterpret_cast<DevWatcher *>(handle->data)->changed(handle, filename);
+          }
+        }, path.string().c_str(), flags);
+
+        if (err != 0) {
+          uv_close((uv_handle_t *) handle, [](uv_handle_t *handle) {
+            delete (uv_fs_event_t *) handle;
+          });
+          return;
+        }
+
+        this->directories.insert(path.string());
+
+      #if defined(__linux__)
+        for (auto const& entry : fs::directory_iterator(path, ec)) {
+          if (entry.is_directory(ec) && !entry.is_symlink(ec)) {
+            this->watch(entry.path());
+          }
+        }
+      #endif
+      }
+
+      void changed (uv_fs_event_t *handle, const char *filename) {
+        char directory[4096];
+        size_t size = sizeof(directory);
+
+        if (filename == nullptr || uv_fs_event_getpath(handle, directory, &size) != 0) {
+          return;
+        }
+
+        auto path = Path(String(directory, size)) / filename;
+
+        if (this->isIgnored(path)) {
+          return;
+        }
+
+      #if defined(__linux__)
+        std::error_code ec;
+        if (fs::is_directory(path, ec)) {
+          this->watch(path);
+        }
+      #endif
+
+        std::lock_guard<std::mutex> lock(this->mutex);
+
+        if (this->changes.paths.size() == 0) {
+          this->changes.time = std::chrono::steady_clock::now();
+        }
+
+        this->changes.paths.insert(path);
+        this->condition.notify_all();
+      }
+
+      void flush () {
+        Vector<String> outgoing;
+        bool rescanning = false;
+
+        {
+          std::lock_guard<std::mutex> lock(this->mutex);
+          std::swap(outgoing, this->outgoing);
+          std::swap(rescanning, this->rescanning);
+        }
+
+      #if defined(__linux__)
+        if (rescanning) {
+          std::error_code ec;
+          for (auto const& entry : fs::recursive_directory_iterator(this->root, ec)) {
+            if (entry.is_directory(ec) && !entry.is_symlink(ec)) {
+              this->watch(entry.path());
+            }
+          }
+        }
+      #endif
+
+        for (auto const& line : outgoing) {
+          for (auto client : this->clients) {
+            auto write = new Write { {}, line };
+            auto buf = uv_buf_init(write->bytes.data(), write->bytes.size());
+            write->request.data = write;
+
+            uv_write(&write->request, (uv_stream_t *) &client->handle, &buf, 1, [](uv_write_t *request, int) {
+              delete reinterpret_cast<Write *>(request->data);
+            });
+          }
+        }
+      }
+
+      void accept () {
+        auto client = new Client;
+        client->watcher = this;
+        client->handle.data = client;
+        uv_tcp_init(&this->loop, &client->handle);
+
+        if (uv_accept((uv_stream_t *) &this->server, (uv_stream_t *) &client->handle) != 0) {
+          uv_close((uv_handle_t *) &client->handle, [](uv_handle_t *handle) {
+            delete reinterpret_cast<Client *>(handle->data);
+          });
+          return;
+        }
+
+        uv_tcp_nodelay(&client->handle, 1);
+        this->clients.insert(client);
+
+        uv_read_start(
+          (uv_stream_t *) &client->handle,
+          [](uv_handle_t *handle, size_t size, uv_buf_t *buf) {
+            *buf = uv_buf_init(new char[size], size);
+          },
+          [](uv_stream_t *stream, ssize_t nread, const uv_buf_t *buf) {
+            auto client = reinterpret_cast<Client *>(stream->data);
+
+            if (nread > 0) {
+              client->buffer.append(buf->base, nread);
+              size_t offset = 0;
+
+              while ((offset = client->buffer.find('\n')) != String::npos) {
+                auto line = client->buffer.substr(0, offset);
+                client->buffer.erase(0, offset + 1);
+
+                if (line.starts_with("reloaded ") && client->watcher->onReloaded != nullptr) {
+                  client->watcher->onReloaded(line.substr(9));
+                }
+              }
+            } else if (nread < 0) {
+              client->watcher->clients.erase(client);
+              uv_close((uv_handle_t *) stream, [](uv_handle_t *handle) {
+                delete reinterpret_cast<Client *>(handle->data);
+              });
+            }
+
+            delete [] buf->base;
+          }
+        );
+      }
+  };
+}
+
+#endif
@@ -20,8 +20,8 @@ static os_log_t SSC_OS_LOG_DEBUG_BUNDLE = nullptr;
 // wrap `os_log*` functions for global debugger
 #define osdebug(format, fmt, ...) ({                                           \
   if (!SSC_OS_LOG_DEBUG_BUNDLE) {                                              \
-    static auto userConfig = SSC::getUserConfig();                             \
-    static auto bundleIdentifier = userConfig["meta_bundle_identifier"];       \
+    static auto bundleIdentifier =                                             \
+      SSC::getUserSettings().get("meta_bundle_identifier");                    \
     SSC_OS_LOG_DEBUG_BUNDLE = os_log_create(                                   \
       bundleIdentifier.c_str(),                                                \
       "socket.runtime.debug"                                                   \
@@ -123,6 +123,7 @@ static os_log_t SSC_OS_LOG_DEBUG_BUNDLE = nullptr;
 #include <unistd.h>
 #endif
 
+#include <algorithm>
 #include <any>
 #include <array>
 #include <chrono>
@@ -132,14 +133,18 @@ static os_log_t SSC_OS_LOG_DEBUG_BUNDLE = nullptr;
 #include <filesystem>
 #include <fstream>
 #include <functional>
+#include <list>
 #include <map>
 #include <mutex>
 #include <queue>
 #include <regex>
+#include <set>
 #include <span>
 #include <sstream>
 #include <string>
 #include <thread>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #ifndef DEBUG
@@ -216,7 +221,71 @@ namespace SSC {
   inline const auto DEFAULT_SSC_RC_FILENAME = String(".sscrc");
   inline const auto DEFAULT_SSC_ENV_FILENAME = String(".ssc.env");
 
-  const Map getUserConfig ();
+  // An immutable table of settings sorted by key. Lookups are binary
+  // searches that return references into the table and never allocate.
+  class SettingsTable {
+    public:
+      using Entry = std::pair<String, String>;
+
+      SettingsTable () = default;
+      // `Map` iterates in key order, so the entries are already sorted
+      SettingsTable (const Map& map) : entries(map.begin(), map.end()) {}
+
+      bool has (const String& key) const {
+        return this->find(key) != nullptr;
+      }
+
+      const String& get (const String& key) const {
+        static const String empty = "";
+        auto entry = this->find(key);
+        return entry != nullptr ? entry->second : empty;
+      }
+
+      // by value, so a temporary `fallback` is never referenced
+      String get (const String& key, const String& fallback) const {
+        auto entry = this->find(key);
+        return entry != nullptr && entry->second.size() > 0 ? entry->second : fallback;
+      }
+
+      bool getBool (const String& key, bool fallback = false) const {
+        auto& value = this->get(key);
+        if (value == "true" || value == "1") return true;
+        if (value == "false" || value == "0") return false;
+        return fallback;
+      }
+
+      int64_t getInt (const String& key, int64_t fallback = 0) const {
+        auto& value = this->get(key);
+        try {
+          return value.size() > 0 ? std::stoll(value) : fallback;
+        } catch (...) {
+          return fallback;
+        }
+      }
+
+      size_t size () const {
+        return this->entries.size();
+      }
+
+    private:
+      Vector<Entry> entries;
+
+      const Entry* find (const String& key) const {
+        auto it = std::lower_bound(
+          this->entries.begin(),
+          this->entries.end(),
+          key,
+          [](const Entry& entry, const String& key) { return entry.first < key; }
+        );
+
+        return it != this->entries.end() && it->first == key ? &*it : nullptr;
+      }
+  };
+
+  // Settings compiled into the application, extended in debug builds by
+  // the file named by `SSC_SETTINGS_FILE` if it is set. Loaded once.
+  const Map& getUserConfig ();
+  const SettingsTable& getUserSettings ();
 
   bool isDebugEnabled ();
 
@@ -918,6 +987,22 @@ namespace SSC {
       /* F */ 0,0,0,0, 0,0,0,0, 0,0,0,0, 0,0,0,0
   };
 
+  // Appends the `size` low bytes of `value` to `output`, little endian.
+  inline void putUInt (String& output, uint64_t value, int size) {
+    for (int i = 0; i < size; ++i) {
+      output.push_back((char) ((value >> (i * 8)) & 0xff));
+    }
+  }
+
+  // Reads a `size` byte little endian integer from `bytes`.
+  inline uint64_t getUInt (const char* bytes, int size) {
+    uint64_t value = 0;
+    for (int i = size - 1; i >= 0; --i) {
+      value = (value << 8) | (unsigned char) bytes[i];
+    }
+    return value;
+  }
+
   inline String encodeURIComponent (const String& sSrc) {
     const char DEC2HEX[16 + 1] = "0123456789ABCDEF";
     const unsigned char* pSrc = (const unsigned char*) sSrc.c_str();
@@ -0,0 +1,325 @@
+#include "archive.hh"
+#include <cstring>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace SSC {
+  static constexpr size_t ARCHIVE_HEADER_SIZE = 16;
+  static constexpr size_t ARCHIVE_INDEX_ENTRY_SIZE = 40;
+
+  static const std::map<String, String> archiveMimeTypes = {
+    { ".avif", "image/avif" },
+    { ".bmp", "image/bmp" },
+    { ".css", "text/css" },
+    { ".csv", "text/csv" },
+    { ".gif", "image/gif" },
+    { ".htm", "text/html" },
+    { ".html", "text/html" },
+    { ".ico", "image/x-icon" },
+    { ".jpeg", "image/jpeg" },
+    { ".jpg", "image/jpeg" },
+    { ".js", "text/javascript" },
+    { ".json", "application/json" },
+    { ".map", "application/json" },
+    { ".mjs", "text/javascript" },
+    { ".mp3", "audio/mpeg" },
+    { ".mp4", "video/mp4" },
+    { ".oga", "audio/ogg" },
+    { ".ogg", "audio/ogg" },
+    { ".ogv", "video/ogg" },
+    { ".otf", "font/otf" },
+    { ".pdf", "application/pdf" },
+    { ".png", "image/png" },
+    { ".svg", "image/svg+xml" },
+    { ".ttf", "font/ttf" },
+    { ".txt", "text/plain" },
+    { ".wasm", "application/wasm" },
+    { ".wav", "audio/wav" },
+    { ".webm", "video/webm" },
+    { ".webp", "image/webp" },
+    { ".woff", "font/woff" },
+    { ".woff2", "font/woff2" },
+    { ".xml", "application/xml" }
+  };
+
+  static uint64_t alignArchiveOffset (uint64_t offset) {
+    return (offset + 7) & ~((uint64_t) 7);
+  }
+
+  String Archive::getMimeType (const String& path) {
+    auto extension = fs::path(path).extension().string();
+
+    for (auto& c : extension) {
+      c = (char) std::tolower((unsigned char) c);
+    }
+
+    auto it = archiveMimeTypes.find(extension);
+
+    if (it != archiveMimeTypes.end()) {
+      return it->second;
+    }
+
+    return "application/octet-stream";
+  }
+
+  bool Archive::write (const Path& path, const Vector<Source>& sources) {
+    std::error_code ec;
+    String index;
+    Vector<uint64_t> sizes;
+    Vector<uint64_t> offsets;
+    uint64_t indexSize = 0;
+
+    for (const auto& source : sources) {
+      auto size = fs::file_size(source.file, ec);
+      if (ec) return false;
+      sizes.push_back(size);
+      indexSize += ARCHIVE_INDEX_ENTRY_SIZE + source.path.size();
+      indexSize += getMimeType(source.path).size();
+    }
+
+    auto offset = alignArchiveOffset(ARCHIVE_HEADER_SIZE + indexSize);
+
+    for (size_t i = 0; i < sources.size(); ++i) {
+      const auto& source = sources[i];
+      auto mimeType = getMimeType(source.path);
+      auto decodedSize = sizes[i];
+
+      // gzip stores the size of the decoded input modulo 2^32 in its trailer
+      if (source.encoding == Encoding::Gzip && sizes[i] >= 4) {
+        char trailer[4] = {0};
+        std::ifstream stream(source.file, std::ios::binary);
+        stream.seekg(-4, std::ios::end);
+        stream.read(trailer, 4);
+        decodedSize = getUInt(trailer, 4);
+      }
+
+      offsets.push_back(offset);
+      putUInt(index, (uint32_t) source.path.size(), 4);
+      putUInt(index, (uint32_t) mimeType.size(), 4);
+      putUInt(index, (uint32_t) source.encoding, 4);
+      putUInt(index, 0, 4);
+      putUInt(index, offset, 8);
+      putUInt(index, sizes[i], 8);
+      putUInt(index, decodedSize, 8);
+      index += source.path;
+      index += mimeType;
+      offset = alignArchiveOffset(offset + sizes[i]);
+    }
+
+    auto temporary = Path(path.string() + ".tmp");
+    std::ofstream output(temporary, std::ios::binary | std::ios::trunc);
+
+    if (!output.is_open()) {
+      return false;
+    }
+
+    String header(MAGIC, sizeof(MAGIC));
+    putUInt(header, VERSION, 4);
+    putUInt(header, (uint32_t) sources.size(), 4);
+
+    output.write(header.data(), header.size());
+    output.write(index.data(), index.size());
+
+    Vector<char> buffer(64 * 1024);
+    uint64_t position = ARCHIVE_HEADER_SIZE + index.size();
+
+    for (size_t i = 0; i < sources.size(); ++i) {
+      static const char padding[8] = {0};
+      output.write(padding, offsets[i] - position);
+      position = offsets[i];
+
+      std::ifstream input(sources[i].file, std::ios::binary);
+      uint64_t remaining = sizes[i];
+
+      while (input && remaining > 0) {
+        auto count = std::min((uint64_t) buffer.size(), remaining);
+        input.read(buffer.data(), count);
+        output.write(buffer.data(), input.gcount());
+        remaining -= input.gcount();
+      }
+
+      if (remaining > 0) {
+        output.close();
+        fs::remove(temporary, ec);
+        return false;
+      }
+
+      position += sizes[i];
+    }
+
+    output.close();
+
+    if (!output) {
+      fs::remove(temporary, ec);
+      return false;
+    }
+
+    fs::rename(temporary, path, ec);
+    return !ec;
+  }
+
+  Archive::~Archive () {
+    this->close();
+  }
+
+  bool Archive::open (const Path& path) {
+    this->close();
+
+#if defined(_WIN32)
+    this->file = CreateFileW(
+      path.c_str(),
+      GENERIC_READ,
+      FILE_SHARE_READ,
+      nullptr,
+      OPEN_EXISTING,
+      FILE_ATTRIBUTE_NORMAL,
+      nullptr
+    );
+
+    if (this->file == INVALID_HANDLE_VALUE) {
+      this->file = nullptr;
+      return false;
+    }
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(this->file, &size) || size.QuadPart < (LONGLONG) ARCHIVE_HEADER_SIZE) {
+      this->close();
+      return false;
+    }
+
+    this->mapping = CreateFileMappingW(this->file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+    if (this->mapping == nullptr) {
+      this->close();
+      return false;
+    }
+
+    this->data = (const char*) MapViewOfFile(this->mapping, FILE_MAP_READ, 0, 0, 0);
+    this->size = (size_t) size.QuadPart;
+#else
+    auto fd = ::open(path.c_str(), O_RDONLY);
+    struct stat stats;
+
+    if (fd < 0) {
+      return false;
+    }
+
+    if (fstat(fd, &stats) != 0 || stats.st_size < (off_t) ARCHIVE_HEADER_SIZE) {
+      ::close(fd);
+      return false;
+    }
+
+    auto mapped = mmap(nullptr, stats.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+
+    if (mapped == MAP_FAILED) {
+      return false;
+    }
+
+    this->data = (const char*) mapped;
+    this->size = (size_t) stats.st_size;
+#endif
+
+    if (this->data == nullptr) {
+      this->close();
+      return false;
+    }
+
+    if (
+      memcmp(this->data, MAGIC, sizeof(MAGIC)) != 0 ||
+      getUInt(this->data + 8, 4) != VERSION
+    ) {
+      this->close();
+      return false;
+    }
+
+    auto count = getUInt(this->data + 12, 4);
+    uint64_t offset = ARCHIVE_HEADER_SIZE;
+
+    for (uint64_t i = 0; i < count; ++i) {
+      if (offset + ARCHIVE_INDEX_ENTRY_SIZE > this->size) {
+        this->close();
+        return false;
+      }
+
+      auto record = this->data + offset;
+      auto pathLength = getUInt(record, 4);
+      auto mimeLength = getUInt(record + 4, 4);
+      auto start = getUInt(record + 16, 8);
+      auto length = getUInt(record + 24, 8);
+      auto strings = offset + ARCHIVE_INDEX_ENTRY_SIZE;
+
+      if (
+        strings + pathLength + mimeLength > this->size ||
+        start > this->size ||
+        length > this->size - start
+      ) {
+        this->close();
+        return false;
+      }
+
+      Entry entry;
+      entry.path = std::string_view(this->data + strings, pathLength);
+      entry.mimeType = std::string_view(this->data + strings + pathLength, mimeLength);
+      entry.encoding = (Encoding) getUInt(record + 8, 4);
+      entry.bytes = this->data + start;
+      entry.size = length;
+      entry.decodedSize = getUInt(record + 32, 8);
+
+      this->entries[entry.path] = entry;
+      offset = strings + pathLength + mimeLength;
+    }
+
+    return true;
+  }
+
+  void Archive::close () {
+    this->entries.clear();
+
+#if defined(_WIN32)
+    if (this->data != nullptr) {
+      UnmapViewOfFile(this->data);
+    }
+
+    if (this->mapping != nullptr) {
+      CloseHandle(this->mapping);
+      this->mapping = nullptr;
+    }
+
+    if (this->file != nullptr) {
+      CloseHandle(this->file);
+      this->file = nullptr;
+    }
+#else
+    if (this->data != nullptr) {
+      munmap((void*) this->data, this->size);
+    }
+#endif
+
+    this->data = nullptr;
+    this->size = 0;
+  }
+
+  bool Archive::isOpen () const {
+    return this->data != nullptr;
+  }
+
+  const Archive::Entry* Archive::find (const String& path) const {
+    auto it = this->entries.find(std::string_view(path));
+
+    if (it == this->entries.end()) {
+      return nullptr;
+    }
+
+    return &it->second;
+  }
+
+  const std::map<std::string_view, Archive::Entry>& Archive::getEntries () const {
+    return this->entries;
+  }
+}
@@ -0,0 +1,69 @@
+#ifndef SSC_CORE_ARCHIVE_H
+#define SSC_CORE_ARCHIVE_H
+
+#include "../common.hh"
+#include <string_view>
+
+namespace SSC {
+  // A read only archive of the files in an application's resources
+  // directory, written by `ssc build` and memory mapped at launch so
+  // resources are served without opening individual files.
+  //
+  // Layout (integers are little endian):
+  //   header: magic (8 bytes), version (u32), entry count (u32)
+  //   index:  per entry: path length (u32), mime length (u32),
+  //           encoding (u32), reserved (u32), offset (u64), size (u64),
+  //           decoded size (u64), path bytes, mime bytes
+  //   data:   entry bytes, each aligned to 8 bytes
+  class Archive {
+    public:
+      static constexpr char MAGIC[8] = { 'S', 'S', 'C', 'A', 'R', 'C', 'H', '\0' };
+      static constexpr uint32_t VERSION = 1;
+
+      enum class Encoding : uint32_t {
+        Identity = 0,
+        Gzip = 1
+      };
+
+      struct Entry {
+        std::string_view path;
+        std::string_view mimeType;
+        Encoding encoding = Encoding::Identity;
+        const char* bytes = nullptr;
+        uint64_t size = 0;
+        // size of the entry after decoding
+        uint64_t decodedSize = 0;
+      };
+
+      struct Source {
+        // path relative to the archive root, using `/` separators
+        String path;
+        Path file;
+        Encoding encoding = Encoding::Identity;
+      };
+
+      static String getMimeType (const String& path);
+      static bool write (const Path& path, const Vector<Source>& sources);
+
+      Archive () = default;
+      Archive (const Archive&) = delete;
+      ~Archive ();
+
+      bool open (const Path& path);
+      void close ();
+      bool isOpen () const;
+      const Entry* find (const String& path) const;
+      // entries keyed by path, in path order
+      const std::map<std::string_view, Entry>& getEntries () const;
+
+    private:
+      const char* data = nullptr;
+      size_t size = 0;
+      std::map<std::string_view, Entry> entries;
+#if defined(_WIN32)
+      void* file = nullptr;
+      void* mapping = nullptr;
+#endif
+  };
+}
+#endif
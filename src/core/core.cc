@@ -476,6 +476,7 @@ namespace SSC {
     this->core->dispatchEventLoop([=, this]() {
       // init page
       if (event == "domcontentloaded") {
+        StartupTrace::complete("domcontentloaded");
         Lock lock(this->core->fs.mutex);
 
         for (auto const &tuple : this->core->fs.descriptors) {
@@ -706,99 +707,6 @@ namespace SSC {
 #endif
   }
 
-  void Core::DNS::lookup (
-    const String seq,
-    LookupOptions options,
-    Core::Module::Callback cb
-  ) {
-    this->core->dispatchEventLoop([=, this]() {
-      auto ctx = new Core::Module::RequestContext(seq, cb);
-      auto loop = this->core->getEventLoop();
-
-      struct addrinfo hints = {0};
-
-      if (options.family == 6) {
-        hints.ai_family = AF_INET6;
-      } else if (options.family == 4) {
-        hints.ai_family = AF_INET;
-      } else {
-        hints.ai_family = AF_UNSPEC;
-      }
-
-      hints.ai_socktype = 0; // `0` for any
-      hints.ai_protocol = 0; // `0` for any
-
-      auto resolver = new uv_getaddrinfo_t;
-      resolver->data = ctx;
-
-      auto err = uv_getaddrinfo(loop, resolver, [](uv_getaddrinfo_t *resolver, int status, struct addrinfo *res) {
-        auto ctx = (Core::DNS::RequestContext*) resolver->data;
-
-        if (status < 0) {
-          auto result = JSON::Object::Entries {
-            {"source", "dns.lookup"},
-            {"err", JSON::Object::Entries {
-              {"code", std::to_string(status)},
-              {"message", String(uv_strerror(status))}
-            }}
-          };
-
-          ctx->cb(ctx->seq, result, Post{});
-          uv_freeaddrinfo(res);
-          delete resolver;
-          delete ctx;
-          return;
-        }
-
-        String address = "";
-
-        if (res->ai_family == AF_INET) {
-          char addr[17] = {'\0'};
-          uv_ip4_name((struct sockaddr_in*)(res->ai_addr), addr, 16);
-          address = String(addr, 17);
-        } else if (res->ai_family == AF_INET6) {
-          char addr[40] = {'\0'};
-          uv_ip6_name((struct sockaddr_in6*)(res->ai_addr), addr, 39);
-          address = String(addr, 40);
-        }
-
-        address = address.erase(address.find('\0'));
-
-        auto family = res->ai_family == AF_INET
-          ? 4
-          : res->ai_family == AF_INET6
-            ? 6
-            : 0;
-
-        auto result = JSON::Object::Entries {
-          {"source", "dns.lookup"},
-          {"data", JSON::Object::Entries {
-            {"address", address},
-            {"family", family}
-          }}
-        };
-
-        ctx->cb(ctx->seq, result, Post{});
-        uv_freeaddrinfo(res);
-        delete resolver;
-        delete ctx;
-      }, options.hostname.c_str(), nullptr, &hints);
-
-      if (err < 0) {
-        auto result = JSON::Object::Entries {
-          {"source", "dns.lookup"},
-          {"err", JSON::Object::Entries {
-            {"code", std::to_string(err)},
-            {"message", String(uv_strerror(err))}
-          }}
-        };
-
-        ctx->cb(seq, result, Post{});
-        delete ctx;
-      }
-    });
-  }
-
 #if defined(__linux__) && !defined(__ANDROID__)
   struct UVSource {
     GSource base; // should ALWAYS be first member
@@ -838,11 +746,20 @@ namespace SSC {
     }
 
     didLoopInit = true;
+    StartupTrace::begin("initEventLoop");
     Lock lock(loopMutex);
     uv_loop_init(&eventLoop);
     eventLoopAsync.data = (void *) this;
     uv_async_init(&eventLoop, &eventLoopAsync, [](uv_async_t *handle) {
       auto core = reinterpret_cast<SSC::Core  *>(handle->data);
+
+      // `stopEventLoop()` signals this handle so `uv_stop()` is called
+      // from the loop thread, waking it from a blocking `uv_run()`
+      if (!core->isLoopRunning) {
+        uv_stop(handle->loop);
+        return;
+      }
+
       while (true) {
         Lock lock(core->loopMutex);
         if (core->eventLoopDispatchQueue.size() == 0) break;
@@ -864,6 +781,8 @@ namespace SSC {
 
     g_source_attach(source, nullptr);
 #endif
+
+    StartupTrace::end("initEventLoop");
   }
 
   uv_loop_t* Core::getEventLoop () {
@@ -881,9 +800,13 @@ namespace SSC {
     return uv_loop_alive(getEventLoop());
   }
 
+  bool Core::isLoopPowerSaving () {
+    return options.loop.powerSaving;
+  }
+
   void Core::stopEventLoop() {
     isLoopRunning = false;
-    uv_stop(&eventLoop);
+    uv_async_send(&eventLoopAsync);
   #if defined(__ANDROID__) || defined(_WIN32)
     if (eventLoopThread != nullptr) {
       if (eventLoopThread->joinable()) {
@@ -927,7 +850,11 @@ namespace SSC {
     auto loop = core->getEventLoop();
 
     while (core->isLoopRunning) {
-      core->sleepEventLoop(EVENT_LOOP_POLL_TIMEOUT);
+      // the loop thread otherwise only blocks in `uv_run()` below and is
+      // woken by I/O, timers, or `eventLoopAsync` on dispatch
+      if (core->isLoopPowerSaving() || !core->isLoopAlive()) {
+        core->sleepEventLoop(EVENT_LOOP_POLL_TIMEOUT);
+      }
 
       do {
         uv_run(loop, UV_RUN_DEFAULT);
@@ -40,8 +40,10 @@
 #pragma comment(lib, "uv_a.lib")
 #endif
 
+#include "archive.hh"
 #include "json.hh"
 #include "runtime-preload.hh"
+#include "trace.hh"
 
 #if defined(__APPLE__)
 @interface SSCBluetoothController : NSObject<
@@ -152,6 +154,9 @@ namespace SSC {
     PEER_STATE_TCP_BOUND = 1 << 20,
     PEER_STATE_TCP_CONNECTED = 1 << 21,
     PEER_STATE_TCP_PAUSED = 1 << 13,
+    PEER_STATE_TCP_READ_STARTED = 1 << 22,
+    PEER_STATE_TCP_LISTENING = 1 << 23,
+    PEER_STATE_TCP_SHUTDOWN = 1 << 24,
     PEER_STATE_MAX = 1 << 0xF
   } peer_state_t;
 
@@ -204,17 +209,83 @@ namespace SSC {
       // uv handles
       union {
         uv_udp_t udp;
-        uv_tcp_t tcp; // XXX: FIXME
+        uv_tcp_t tcp;
       } handle;
 
       // sockaddr
-      struct sockaddr_in addr;
+      struct sockaddr_storage addr;
+
+      // parsed send destinations, direct mapped by address and port so
+      // repeated sends to the same endpoint skip re-parsing
+      struct CachedAddress {
+        String address;
+        int port = -1;
+        struct sockaddr_storage addr;
+      };
+
+      static constexpr size_t ADDRESS_CACHE_SIZE = 8;
+      CachedAddress addressCache[ADDRESS_CACHE_SIZE];
+
+      // UDP segmentation offload (Linux `UDP_SEGMENT` and `UDP_GRO`) limits,
+      // a segmented send may carry at most 64 datagrams in one IP packet
+      static constexpr size_t UDP_MAX_SEGMENTS = 64;
+      static constexpr size_t UDP_MAX_SEGMENTED_PAYLOAD = 65535 - 40 - 8;
+
+      // reads coalesced datagrams when `options.udp.gro` is set, defined
+      // in `peer.cc`
+      struct ReceiveOffload;
+      ReceiveOffload *receiveOffload = nullptr;
+
+      // a NAT keepalive destination, probed every `punchInterval` while it
+      // is unreachable (hole punching) and every `interval` after that
+      struct KeepaliveTarget {
+        String address;
+        int port = 0;
+        uint64_t interval = 25 * 1000;
+        // unreachable after this long without a datagram from the target,
+        // `0` for three intervals
+        uint64_t timeout = 0;
+        unsigned int punchAttempts = 8;
+        uint64_t punchInterval = 500;
+
+        bool reachable = false;
+        // `uv_now()` of the last datagram received from the target
+        uint64_t lastSeen = 0;
+        uint64_t sent = 0;
+        uint64_t received = 0;
+      };
+
+      // called on the event loop thread when a target becomes reachable or
+      // stops answering
+      using KeepaliveCallback = std::function<void(const KeepaliveTarget&)>;
+
+      // keepalive timer and targets, defined in `peer.cc`
+      struct Keepalive;
+      Keepalive *keepalive = nullptr;
+
+      using UDPReceiveFilter = std::function<bool(
+        ssize_t,
+        const uv_buf_t*,
+        const struct sockaddr*
+      )>;
+
+      // a callback that keeps `buf->base` sets it to `nullptr`, otherwise
+      // the buffer goes back to the read buffer pool when it returns
+      using TCPReadCallback = std::function<void(ssize_t, uv_buf_t*)>;
+      // `peer` is the accepted connection, `nullptr` when `status < 0`
+      using TCPConnectionCallback = std::function<void(Peer*, int)>;
 
       // callbacks
       UDPReceiveCallback receiveCallback;
+      TCPReadCallback readCallback;
+      TCPConnectionCallback connectionCallback;
+      // called before `receiveCallback`, a filter that returns `true` has
+      // consumed the datagram and owns `buf->base`
+      UDPReceiveFilter receiveFilter;
       std::vector<std::function<void()>> onclose;
 
-      // instance state
+      // instance state, `id` only changes when a pooled ephemeral peer is
+      // reused by `Core::createPeer()`
       uint64_t id = 0;
       std::recursive_mutex mutex;
       Core *core;
@@ -222,16 +293,40 @@ namespace SSC {
       struct {
         struct {
           bool reuseAddr = false;
-          bool ipv6Only = false; // @TODO
+          bool ipv6Only = false;
+          // receive coalesced datagrams with `UDP_GRO` where supported
+          bool gro = false;
         } udp;
+
+        // applied to accepted connections of a listening peer too
+        struct {
+          bool ipv6Only = false;
+          bool noDelay = false;
+          bool keepAlive = false;
+          unsigned int keepAliveDelay = 0;
+        } tcp;
       } options;
 
+      // set when a write reported backpressure, cleared when the write
+      // queue drains
+      bool needsDrain = false;
+
+      // segment size of the datagram being delivered to `receiveCallback`,
+      // `0` unless it is a `UDP_GRO` super-packet of equally sized segments
+      size_t receiveSegmentSize = 0;
+
+      // set when the kernel or route rejected `UDP_SEGMENT`, later segmented
+      // sends go out as individual datagrams
+      bool segmentationUnsupported = false;
+
       // peer state
       LocalPeerInfo local;
       RemotePeerInfo remote;
+      // `type` is set once at construction, `flags` and `state` are atomic
+      // so state queries do not take `mutex`
       peer_type_t type = PEER_TYPE_NONE;
-      peer_flag_t flags = PEER_FLAG_NONE;
-      peer_state_t state = PEER_STATE_NONE;
+      std::atomic<int> flags = PEER_FLAG_NONE;
+      std::atomic<int> state = PEER_STATE_NONE;
 
       /**
       * Private `Peer` class constructor
@@ -259,9 +354,20 @@ namespace SSC {
       int bind ();
       int bind (String address, int port);
       int bind (String address, int port, bool reuseAddr);
+      int bind (String address, int port, bool reuseAddr, bool ipv6Only);
       int rebind ();
       int connect (String address, int port);
       int disconnect ();
+      int resolveAddress (
+        const String& address,
+        int port,
+        struct sockaddr_storage *addr
+      );
+      const struct sockaddr* getCachedAddress (
+        const String& address,
+        int port,
+        int *err
+      );
       void send (
         char *buf,
         size_t size,
@@ -269,13 +375,94 @@ namespace SSC {
         const String address,
         Peer::RequestContext::Callback cb
       );
+      // splits `buf` into `segmentSize` datagrams, sent with `UDP_SEGMENT`
+      // where supported
+      void sendSegments (
+        char *buf,
+        size_t size,
+        size_t segmentSize,
+        int port,
+        const String address,
+        Peer::RequestContext::Callback cb
+      );
       int recvstart ();
       int recvstart (UDPReceiveCallback onrecv);
       int recvstop ();
+      int listen (int backlog, TCPConnectionCallback onconnection);
+      void connect (
+        String address,
+        int port,
+        Peer::RequestContext::Callback cb
+      );
+      int readstart ();
+      int readstart (TCPReadCallback onread);
+      int readstop ();
+      // all `chunks` are written with a single `uv_write()` (writev)
+      int write (Vector<String> chunks, Peer::RequestContext::Callback cb);
+      void shutdown (Peer::RequestContext::Callback cb);
+      int setNoDelay (bool enable);
+      int setKeepAlive (bool enable, unsigned int delay);
+      size_t getWriteQueueSize ();
       int resume ();
       int pause ();
       void close ();
       void close (std::function<void()> onclose);
+      // returns an ephemeral peer to `Core::peers` for reuse once its last
+      // send completed, closing it when the pool is full
+      void release ();
+      // sends `payload` to each of `targets` from the event loop, without a
+      // round trip through JavaScript. targets already scheduled keep their
+      // reachability and take the new intervals
+      int addKeepaliveTargets (
+        const Vector<KeepaliveTarget>& targets,
+        const String& payload,
+        KeepaliveCallback onchange
+      );
+      // stops keepalives to `targets`, or to every target when empty, and
+      // returns the number of targets left
+      int removeKeepaliveTargets (const Vector<KeepaliveTarget>& targets);
+      Vector<KeepaliveTarget> getKeepaliveTargets ();
+  };
+
+  /**
+   * `Peer` instances by ID, split over shards with their own lock so lookups
+   * and updates of different peers rarely contend. Also pools idle ephemeral
+   * UDP peers so one-shot sends reuse their socket instead of creating and
+   * closing a handle per send.
+   */
+  class PeerRegistry {
+    public:
+      static constexpr size_t SHARDS = 16;
+      static constexpr size_t MAX_POOLED_PEERS = 32;
+
+      bool has (uint64_t id);
+      Peer* get (uint64_t id);
+      void insert (Peer *peer);
+      // removes `id` only while it still maps to `peer`, when given
+      void remove (uint64_t id, Peer *peer = nullptr);
+      size_t size ();
+      Vector<Peer*> snapshot ();
+
+      // takes an idle pooled peer whose handle was bound to an address of
+      // `family` by its sends, or `nullptr` when the pool has none
+      Peer* acquire (int family);
+      // unregisters `peer` and pools it, `false` when the pool is full
+      bool release (Peer *peer);
+
+    private:
+      struct alignas(64) Shard {
+        std::mutex mutex;
+        std::unordered_map<uint64_t, Peer*> peers;
+      };
+
+      Shard shards[SHARDS];
+      Mutex poolMutex;
+      Vector<Peer*> pool;
+
+      inline Shard& shard (uint64_t id) {
+        // IDs are mostly random, mixing in the high bits covers sequential ones
+        return this->shards[(id ^ (id >> 32)) % SHARDS];
+      }
   };
 
   static inline String addrToIPv4 (struct sockaddr_in* sin) {
@@ -290,10 +477,41 @@ namespace SSC {
     return String(buf);
   }
 
+  /**
+   * Parses an IPv4 or IPv6 `address` and `port` into `addr`.
+   */
+  static inline int parseSocketAddress (
+    const String& address,
+    int port,
+    struct sockaddr_storage *addr
+  ) {
+    *addr = {};
+
+    if (uv_ip4_addr(address.c_str(), port, (struct sockaddr_in *) addr) == 0) {
+      return 0;
+    }
+
+    return uv_ip6_addr(address.c_str(), port, (struct sockaddr_in6 *) addr);
+  }
+
+  static inline const char* getAddressFamily (const struct sockaddr *name) {
+    return name->sa_family == AF_INET6 ? "IPv6" : "IPv4";
+  }
+
+  /**
+   * Writes the port and address of `name` into `port` and `address`, which
+   * must hold at least `INET6_ADDRSTRLEN` bytes.
+   */
   static inline void parseAddress (struct sockaddr *name, int* port, char* address) {
-    struct sockaddr_in *name_in = (struct sockaddr_in *) name;
-    *port = ntohs(name_in->sin_port);
-    uv_ip4_name(name_in, address, 17);
+    if (name->sa_family == AF_INET6) {
+      struct sockaddr_in6 *name_in6 = (struct sockaddr_in6 *) name;
+      *port = ntohs(name_in6->sin6_port);
+      uv_ip6_name(name_in6, address, INET6_ADDRSTRLEN);
+    } else {
+      struct sockaddr_in *name_in = (struct sockaddr_in *) name;
+      *port = ntohs(name_in->sin_port);
+      uv_ip4_name(name_in, address, INET_ADDRSTRLEN);
+    }
   }
 
   class Bluetooth {
@@ -358,6 +576,90 @@ namespace SSC {
           }
       };
 
+      class Crypto : public Module {
+        public:
+          Crypto (auto core) : Module(core) {}
+
+          // Batched inputs and outputs are sequences of records, each a
+          // little endian u32 length followed by that many bytes. Every
+          // input record produces one output record, failed records are
+          // empty. Keys are hex encoded.
+          using Transform = std::function<bool(const String&, String&)>;
+
+          static bool isSupported ();
+
+          void seal (
+            const String seq,
+            const String publicKey,
+            const char* bytes,
+            size_t size,
+            Module::Callback cb
+          );
+          void open (
+            const String seq,
+            const String publicKey,
+            const String secretKey,
+            const char* bytes,
+            size_t size,
+            Module::Callback cb
+          );
+          void sign (
+            const String seq,
+            const String secretKey,
+            const char* bytes,
+            size_t size,
+            Module::Callback cb
+          );
+          // records are a detached signature followed by the signed message,
+          // output records are a single byte, 1 if the signature is valid
+          void verify (
+            const String seq,
+            const String publicKey,
+            const char* bytes,
+            size_t size,
+            Module::Callback cb
+          );
+          void ed25519PublicKeyToCurve25519 (
+            const String seq,
+            const char* bytes,
+            size_t size,
+            Module::Callback cb
+          );
+          void ed25519SecretKeyToCurve25519 (
+            const String seq,
+            const char* bytes,
+            size_t size,
+            Module::Callback cb
+          );
+          // `algorithm` is "sha256" or "blake2b", `digestSize` is the BLAKE2b
+          // output size in bytes and is ignored for SHA-256
+          void hash (
+            const String seq,
+            const String algorithm,
+            size_t digestSize,
+            const char* bytes,
+            size_t size,
+            Module::Callback cb
+          );
+          // streams the file behind an open `Core::FS` descriptor through the
+          // hash on the threadpool, the file bytes never leave native code
+          void hashDescriptor (
+            const String seq,
+            const String algorithm,
+            size_t digestSize,
+            uint64_t id,
+            Module::Callback cb
+          );
+          void queue (
+            const String seq,
+            const String source,
+            const char* bytes,
+            size_t size,
+            Transform transform,
+            Module::Callback cb
+          );
+      };
+
       class Diagnostics : public Module {
         public:
           Diagnostics (auto core) : Module(core) {}
@@ -365,20 +667,79 @@ namespace SSC {
 
       class DNS : public Module {
         public:
+          // `getaddrinfo()` does not report record TTLs, so answers are kept
+          // for a fixed time. only "not found" errors are cached
+          static constexpr uint64_t POSITIVE_TTL = 60 * 1000;
+          static constexpr uint64_t NEGATIVE_TTL = 5 * 1000;
+          static constexpr size_t MAX_CACHE_ENTRIES = 1024;
+
+          struct Address {
+            String address;
+            int family;
+          };
+
+          using ResolveCallback = std::function<void(int, Vector<Address>)>;
+          // replaces `uv_getaddrinfo()`, called on the event loop thread
+          using Resolver = std::function<void(
+            const String&,
+            int,
+            ResolveCallback
+          )>;
+
           DNS (auto core) : Module(core) {}
           struct LookupOptions {
             String hostname;
             int family;
+            bool all = false;
             // TODO: support these options
             // - hints
-            // - all
             // -verbatim
           };
+          void clearCache (const String seq, Module::Callback cb);
+          void getStats (const String seq, Module::Callback cb);
           void lookup (
             const String seq,
             LookupOptions options,
             Module::Callback cb
           );
+          // answers lookups of `hostname` with `addresses` instead of
+          // the resolver, an empty list removes the entry
+          void setLocalAddresses (
+            const String seq,
+            const String hostname,
+            Vector<String> addresses,
+            Module::Callback cb
+          );
+          void setResolver (Resolver resolver);
+
+        private:
+          struct CacheEntry {
+            Vector<Address> addresses;
+            int err = 0;
+            uint64_t expires = 0;
+          };
+
+          struct PendingLookup {
+            String seq;
+            bool all;
+            Module::Callback cb;
+          };
+
+          // only used on the event loop thread
+          std::map<String, CacheEntry> cache;
+          std::map<String, Vector<PendingLookup>> inflight;
+          std::map<String, Vector<Address>> localAddresses;
+          Resolver resolver = nullptr;
+
+          struct {
+            uint64_t hits = 0;
+            uint64_t negativeHits = 0;
+            uint64_t misses = 0;
+            uint64_t coalesced = 0;
+            uint64_t evictions = 0;
+          } stats;
+
+          void resolve (const String& hostname, int family, ResolveCallback cb);
       };
 
       class FS : public Module {
@@ -608,6 +969,85 @@ namespace SSC {
           );
       };
 
+      class TCP : public Module {
+        public:
+          TCP (auto core) : Module(core) {}
+
+          // reads land in pooled fixed size buffers. Small reads are copied
+          // out at their size and the buffer is reused, reads of at least
+          // half a buffer are handed to the post without a copy
+          static constexpr size_t READ_BUFFER_SIZE = 64 * 1024;
+          static constexpr size_t MAX_POOLED_READ_BUFFERS = 64;
+          static constexpr size_t DEFAULT_HIGH_WATER_MARK = 1024 * 1024;
+
+          struct ListenOptions {
+            String address;
+            int port;
+            int backlog = 511;
+            bool ipv6Only = false;
+          };
+
+          struct ConnectOptions {
+            String address;
+            int port;
+          };
+
+          struct WriteOptions {
+            char *bytes = nullptr;
+            size_t size = 0;
+            // `bytes` holds records of a little endian u32 length followed
+            // by that many bytes, each record becomes one writev buffer
+            bool batch = false;
+            size_t highWaterMark = DEFAULT_HIGH_WATER_MARK;
+          };
+
+          char * acquireReadBuffer ();
+          void releaseReadBuffer (char *buffer);
+
+          void close (const String seq, uint64_t id, Module::Callback cb);
+          void connect (
+            const String seq,
+            uint64_t id,
+            ConnectOptions options,
+            Module::Callback cb
+          );
+          void getPeerName (const String seq, uint64_t id, Module::Callback cb);
+          void getSockName (const String seq, uint64_t id, Module::Callback cb);
+          void getState (const String seq, uint64_t id, Module::Callback cb);
+          void listen (
+            const String seq,
+            uint64_t id,
+            ListenOptions options,
+            Module::Callback cb
+          );
+          void readStart (const String seq, uint64_t id, Module::Callback cb);
+          void readStop (const String seq, uint64_t id, Module::Callback cb);
+          void setKeepAlive (
+            const String seq,
+            uint64_t id,
+            bool enable,
+            unsigned int delay,
+            Module::Callback cb
+          );
+          void setNoDelay (
+            const String seq,
+            uint64_t id,
+            bool enable,
+            Module::Callback cb
+          );
+          void shutdown (const String seq, uint64_t id, Module::Callback cb);
+          void write (
+            const String seq,
+            uint64_t id,
+            WriteOptions options,
+            Module::Callback cb
+          );
+
+        private:
+          Mutex mutex;
+          Vector<char *> buffers;
+      };
+
       class UDP : public Module {
         public:
           UDP (auto core) : Module(core) {}
@@ -616,6 +1056,8 @@ namespace SSC {
             String address;
             int port;
             bool reuseAddr = false;
+            bool ipv6Only = false;
+            bool gro = false;
           };
 
           struct ConnectOptions {
@@ -628,9 +1070,15 @@ namespace SSC {
             int port = 0;
             char *bytes = nullptr;
             size_t size = 0;
+            size_t segmentSize = 0;
             bool ephemeral = false;
           };
 
+          struct KeepaliveOptions {
+            Vector<Peer::KeepaliveTarget> targets;
+            String payload;
+          };
+
           void bind (
             const String seq,
             uint64_t id,
@@ -648,6 +1096,23 @@ namespace SSC {
           void getPeerName (const String seq, uint64_t id, Module::Callback cb);
           void getSockName (const String seq, uint64_t id, Module::Callback cb);
           void getState (const String seq, uint64_t id,  Module::Callback cb);
+          void keepaliveGetState (
+            const String seq,
+            uint64_t id,
+            Module::Callback cb
+          );
+          void keepaliveStart (
+            const String seq,
+            uint64_t id,
+            KeepaliveOptions options,
+            Module::Callback cb
+          );
+          void keepaliveStop (
+            const String seq,
+            uint64_t id,
+            Vector<Peer::KeepaliveTarget> targets,
+            Module::Callback cb
+          );
           void readStart (const String seq, uint64_t id, Module::Callback cb);
           void readStop (const String seq, uint64_t id, Module::Callback cb);
           void send (
@@ -658,18 +1123,205 @@ namespace SSC {
           );
       };
 
+      class Relay : public Module {
+        public:
+          Relay (auto core) : Module(core) {}
+
+          // stream-relay frame layout, all integers are big endian
+          static constexpr size_t ID_SIZE = 32;
+          static constexpr size_t MESSAGE_SIZE = 1024;
+          static constexpr size_t FRAME_SIZE = 1 + 1 + 4 + 4 + 4 + ID_SIZE * 6 + 2;
+          static constexpr size_t PACKET_SIZE = FRAME_SIZE + MESSAGE_SIZE;
+          static constexpr size_t HOPS_OFFSET = 2;
+          static constexpr uint8_t VERSION = 1;
+          static constexpr uint8_t PACKET_TYPE_PUBLISH = 5;
+
+          struct Packet {
+            uint8_t type = 0;
+            uint8_t version = 0;
+            uint32_t hops = 0;
+            uint32_t clock = 0;
+            int32_t index = -1;
+            String packetId;
+            String clusterId;
+            String previousId;
+            String nextId;
+            String to;
+            String usr1;
+            String message;
+
+            static bool decode (const char* bytes, size_t size, Packet& packet);
+          };
+
+          struct StartOptions {
+            Vector<String> clusters;
+            uint32_t maxHops = 16;
+            // forwarded packets are sent to this many peers
+            size_t fanout = 3;
+            // peers that have not sent a packet within this window are not
+            // forwarded to
+            uint64_t peerTimeout = 60 * 1000;
+            // cached packets older than this are evicted
+            uint64_t cacheTimeout = 24 * 60 * 60 * 1000;
+            size_t cacheSize = (16 * 1024 * 1024) / PACKET_SIZE;
+          };
+
+          struct RemotePeer {
+            String address;
+            int port = 0;
+            uint64_t lastSeen = 0;
+          };
+
+          // Bounded packet cache. Entries are kept in insertion order so the
+          // oldest entry is evicted or expired in O(1), and are indexed by
+          // cluster and by `previousId` so chains compose without a scan.
+          class Cache {
+            public:
+              static constexpr char MAGIC[8] = { 'S', 'S', 'C', 'R', 'C', 'A', 'C', 'H' };
+              static constexpr uint32_t VERSION = 1;
+
+              struct Entry {
+                String packetId;
+                String clusterId;
+                String previousId;
+                int32_t index = -1;
+                String bytes;
+                uint64_t timestamp = 0;
+                std::list<String>::iterator position;
+              };
+
+              size_t maxSize = (16 * 1024 * 1024) / PACKET_SIZE;
+              uint64_t timeout = 24 * 60 * 60 * 1000;
+              uint64_t expired = 0;
+
+              bool insert (const Packet& packet, const char* bytes, size_t size, uint64_t now);
+              bool has (const String& packetId) const;
+              const Entry* get (const String& packetId) const;
+              void remove (const String& packetId);
+              void expire (uint64_t now);
+              size_t size () const;
+              size_t size (const String& clusterId) const;
+              Vector<const Entry*> compose (const String& packetId) const;
+              bool snapshot (const Path& path, uint64_t now) const;
+              int restore (const Path& path, uint64_t now);
+
+            private:
+              std::unordered_map<String, Entry> entries;
+              // packet ids, oldest first
+              std::list<String> order;
+              std::unordered_map<String, std::unordered_set<String>> clusters;
+              std::unordered_map<String, std::unordered_set<String>> children;
+          };
+
+          // per socket relay state, only used on the event loop thread
+          struct State {
+            uint64_t id = 0;
+            StartOptions options;
+            std::set<String> clusters;
+            std::map<String, RemotePeer> peers;
+            Cache cache;
+
+            struct {
+              uint64_t received = 0;
+              uint64_t delivered = 0;
+              uint64_t forwarded = 0;
+              uint64_t duplicates = 0;
+            } stats;
+
+            bool receive (Peer* peer, ssize_t nread, const uv_buf_t* buf, const struct sockaddr* addr);
+            void forward (
+              Peer* peer,
+              const char* bytes,
+              size_t size,
+              uint32_t hops,
+              const String& from,
+              uint64_t now
+            );
+          };
+
+          std::map<uint64_t, std::shared_ptr<State>> states;
+          Mutex mutex;
+
+          void start (
+            const String seq,
+            uint64_t id,
+            StartOptions options,
+            Module::Callback cb
+          );
+          void stop (const String seq, uint64_t id, Module::Callback cb);
+          void subscribe (
+            const String seq,
+            uint64_t id,
+            const String clusterId,
+            Module::Callback cb
+          );
+          void unsubscribe (
+            const String seq,
+            uint64_t id,
+            const String clusterId,
+            Module::Callback cb
+          );
+          void addPeer (
+            const String seq,
+            uint64_t id,
+            const String address,
+            int port,
+            Module::Callback cb
+          );
+          void getState (const String seq, uint64_t id, Module::Callback cb);
+          void cacheInsert (
+            const String seq,
+            uint64_t id,
+            const char* bytes,
+            size_t size,
+            Module::Callback cb
+          );
+          void cacheHas (
+            const String seq,
+            uint64_t id,
+            const String packetId,
+            Module::Callback cb
+          );
+          void cacheGet (
+            const String seq,
+            uint64_t id,
+            const String packetId,
+            Module::Callback cb
+          );
+          void cacheCompose (
+            const String seq,
+            uint64_t id,
+            const String packetId,
+            Module::Callback cb
+          );
+          void cacheSnapshot (
+            const String seq,
+            uint64_t id,
+            const String path,
+            Module::Callback cb
+          );
+          void cacheRestore (
+            const String seq,
+            uint64_t id,
+            const String path,
+            Module::Callback cb
+          );
+      };
+
+      Crypto crypto;
       Diagnostics diagnostics;
       DNS dns;
       FS fs;
       OS os;
       Platform platform;
+      Relay relay;
+      TCP tcp;
       UDP udp;
 
       std::shared_ptr<Posts> posts;
-      std::map<uint64_t, Peer*> peers;
+      PeerRegistry peers;
 
       std::recursive_mutex loopMutex;
-      std::recursive_mutex peersMutex;
       std::recursive_mutex postsMutex;
       std::recursive_mutex timersMutex;
 
@@ -679,6 +1331,14 @@ namespace SSC {
 
       std::atomic<bool> isLoopRunning = false;
 
+      struct {
+        struct {
+          // sleep for `EVENT_LOOP_POLL_TIMEOUT` before each loop pass to
+          // coalesce wakeups, trading dispatch latency for power usage
+          bool powerSaving = false;
+        } loop;
+      } options;
+
       uv_loop_t eventLoop;
       uv_async_t eventLoopAsync;
       std::queue<EventLoopDispatchCallback> eventLoopDispatchQueue;
@@ -699,14 +1359,21 @@ namespace SSC {
 #endif
 
       Core () :
+        crypto(this),
         diagnostics(this),
         dns(this),
         fs(this),
         os(this),
         platform(this),
+        relay(this),
+        tcp(this),
         udp(this)
       {
         this->posts = std::shared_ptr<Posts>(new Posts());
+        this->options.loop.powerSaving = (
+          getUserSettings().getBool("core_event_loop_power_saving")
+        );
+
         initEventLoop();
       }
 
@@ -718,6 +1385,7 @@ namespace SSC {
       Peer* getPeer (uint64_t id);
       Peer* createPeer (peer_type_t type, uint64_t id);
       Peer* createPeer (peer_type_t type, uint64_t id, bool isEphemeral);
+      Peer* createPeer (peer_type_t type, uint64_t id, bool isEphemeral, int family);
 
       Post getPost (uint64_t id);
       bool hasPost (uint64_t id);
@@ -736,6 +1404,7 @@ namespace SSC {
       uv_loop_t* getEventLoop ();
       int getEventLoopTimeout ();
       bool isLoopAlive ();
+      bool isLoopPowerSaving ();
       void initEventLoop ();
       void runEventLoop ();
       void stopEventLoop ();
@@ -747,6 +1416,12 @@ namespace SSC {
 
   String createJavaScript (const String& name, const String& source);
 
+  // shared by the `udp.*` and `tcp.*` routes, defined in `peer.cc`
+  JSON::Object::Entries ERR_SOCKET_ALREADY_BOUND (
+    const String& source,
+    uint64_t id
+  );
+
   String getEmitToRenderProcessJavaScript (
     const String& event,
     const String& value,
@@ -0,0 +1,682 @@
+#include "core.hh"
+#include <cstring>
+
+#if defined(SSC_CRYPTO_SODIUM)
+#include <sodium.h>
+#endif
+
+namespace SSC {
+  struct CryptoWorkContext {
+    uv_work_t req;
+    String seq;
+    String source;
+    String input;
+    String output;
+    Core::Crypto::Transform transform;
+    Core::Module::Callback cb;
+  };
+
+  static JSON::Object::Entries ERR_CRYPTO (
+    const String& source,
+    const String& code,
+    const String& message
+  ) {
+    return JSON::Object::Entries {
+      {"source", source},
+      {"err", JSON::Object::Entries {
+        {"type", "InternalError"},
+        {"code", code},
+        {"message", message}
+      }}
+    };
+  }
+
+  static void putRecord (String& output, const String& record) {
+    auto size = (uint32_t) record.size();
+    for (int i = 0; i < 4; ++i) {
+      output.push_back((char) ((size >> (i * 8)) & 0xff));
+    }
+    output += record;
+  }
+
+  static String toHex (const String& input) {
+    static const char digits[] = "0123456789abcdef";
+    String output;
+
+    output.reserve(input.size() * 2);
+
+    for (unsigned char byte : input) {
+      output += digits[byte >> 4];
+      output += digits[byte & 0x0f];
+    }
+
+    return output;
+  }
+
+  // incremental SHA-256 (FIPS 180-4), always available so that integrity
+  // checks do not depend on the runtime being built with libsodium. This is
+  // a portable scalar implementation, it does not use SHA-NI or the ARMv8
+  // SHA-2 instructions
+  class SHA256 {
+    public:
+      SHA256 () {
+        static const uint32_t initial[8] = {
+          0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+          0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+        };
+
+        memcpy(this->state, initial, sizeof(this->state));
+      }
+
+      void update (const unsigned char* bytes, size_t size) {
+        this->length += size;
+
+        if (this->used > 0) {
+          auto count = std::min(size, sizeof(this->block) - this->used);
+          memcpy(this->block + this->used, bytes, count);
+          this->used += count;
+          bytes += count;
+          size -= count;
+
+          if (this->used < sizeof(this->block)) {
+            return;
+          }
+
+          this->compress(this->block);
+          this->used = 0;
+        }
+
+        for (; size >= sizeof(this->block); size -= sizeof(this->block)) {
+          this->compress(bytes);
+          bytes += sizeof(this->block);
+        }
+
+        memcpy(this->block, bytes, size);
+        this->used = size;
+      }
+
+      String digest () {
+        auto bits = this->length * 8;
+        unsigned char padding[72] = { 0x80 };
+        auto count = (this->used < 56 ? 56 : 120) - this->used;
+
+        for (int i = 0; i < 8; ++i) {
+          padding[count + i] = (unsigned char) (bits >> (56 - i * 8));
+        }
+
+        this->update(padding, count + 8);
+
+        String output(32, '\0');
+
+        for (int i = 0; i < 8; ++i) {
+          output[i * 4] = (char) (this->state[i] >> 24);
+          output[i * 4 + 1] = (char) (this->state[i] >> 16);
+          output[i * 4 + 2] = (char) (this->state[i] >> 8);
+          output[i * 4 + 3] = (char) this->state[i];
+        }
+
+        return output;
+      }
+
+    private:
+      uint32_t state[8];
+      uint64_t length = 0;
+      unsigned char block[64];
+      size_t used = 0;
+
+      static uint32_t rotate (uint32_t value, int bits) {
+        return (value >> bits) | (value << (32 - bits));
+      }
+
+      void compress (const unsigned char* chunk) {
+        static const uint32_t k[64] = {
+          0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+          0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+          0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+          0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+          0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+          0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+          0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+          0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+        };
+
+        uint32_t w[64];
+
+        for (int i = 0; i < 16; ++i) {
+          w[i] = (uint32_t) chunk[i * 4] << 24 | (uint32_t) chunk[i * 4 + 1] << 16 |
+                 (uint32_t) chunk[i * 4 + 2] << 8 | (uint32_t) chunk[i * 4 + 3];
+        }
+
+        for (int i = 16; i < 64; ++i) {
+          auto s0 = rotate(w[i - 15], 7) ^ rotate(w[i - 15], 18) ^ (w[i - 15] >> 3);
+          auto s1 = rotate(w[i - 2], 17) ^ rotate(w[i - 2], 19) ^ (w[i - 2] >> 10);
+          w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+        }
+
+        auto a = state[0], b = state[1], c = state[2], d = state[3];
+        auto e = state[4], f = state[5], g = state[6], h = state[7];
+
+        for (int i = 0; i < 64; ++i) {
+          auto t1 = h + (rotate(e, 6) ^ rotate(e, 11) ^ rotate(e, 25)) + ((e & f) ^ (~e & g)) + k[i] + w[i];
+          auto t2 = (rotate(a, 2) ^ rotate(a, 13) ^ rotate(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+          h = g; g = f; f = e; e = d + t1;
+          d = c; c = b; b = a; a = t1 + t2;
+        }
+
+        state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+        state[4] += e; state[5] += f; state[6] += g; state[7] += h;
+      }
+  };
+
+  // BLAKE2b comes from libsodium, which selects its AVX2 or SSSE3
+  // implementation at runtime when the CPU has them
+  class Hasher {
+    public:
+      bool init (const String& algorithm, size_t digestSize) {
+        this->algorithm = algorithm;
+        this->digestSize = digestSize;
+
+        if (algorithm == "sha256") {
+          return true;
+        }
+
+      #if defined(SSC_CRYPTO_SODIUM)
+        if (algorithm == "blake2b") {
+          return (
+            Core::Crypto::isSupported() &&
+            digestSize >= crypto_generichash_BYTES_MIN &&
+            digestSize <= crypto_generichash_BYTES_MAX &&
+            crypto_generichash_init(&this->blake2b, nullptr, 0, digestSize) == 0
+          );
+        }
+      #endif
+
+        return false;
+      }
+
+      void update (const char* bytes, size_t size) {
+        if (this->algorithm == "sha256") {
+          this->sha256.update((const unsigned char *) bytes, size);
+        }
+
+      #if defined(SSC_CRYPTO_SODIUM)
+        if (this->algorithm == "blake2b") {
+          crypto_generichash_update(&this->blake2b, (const unsigned char *) bytes, size);
+        }
+      #endif
+      }
+
+      String digest () {
+      #if defined(SSC_CRYPTO_SODIUM)
+        if (this->algorithm == "blake2b") {
+          String output(this->digestSize, '\0');
+          crypto_generichash_final(&this->blake2b, (unsigned char *) output.data(), output.size());
+          return output;
+        }
+      #endif
+
+        return this->sha256.digest();
+      }
+
+    private:
+      String algorithm;
+      size_t digestSize = 0;
+      SHA256 sha256;
+    #if defined(SSC_CRYPTO_SODIUM)
+      crypto_generichash_state blake2b;
+    #endif
+  };
+
+  struct HashWorkContext {
+    uv_work_t req;
+    String seq;
+    uint64_t id;
+    uv_file fd;
+    Hasher hasher;
+    String digest;
+    uint64_t size = 0;
+    int err = 0;
+    Core::Module::Callback cb;
+  };
+
+  static void closeHashDescriptor (uv_file fd) {
+    uv_fs_t req;
+    uv_fs_close(nullptr, &req, fd, nullptr);
+    uv_fs_req_cleanup(&req);
+  }
+
+  bool Core::Crypto::isSupported () {
+  #if defined(SSC_CRYPTO_SODIUM)
+    static std::once_flag flag;
+    static bool initialized = false;
+    std::call_once(flag, [] { initialized = sodium_init() >= 0; });
+    return initialized;
+  #else
+    return false;
+  #endif
+  }
+
+  void Core::Crypto::queue (
+    const String seq,
+    const String source,
+    const char* bytes,
+    size_t size,
+    Transform transform,
+    Module::Callback cb
+  ) {
+  #if defined(SSC_CRYPTO_SODIUM)
+    if (!isSupported()) {
+      transform = nullptr;
+    }
+  #endif
+
+    if (transform == nullptr) {
+      auto json = ERR_CRYPTO(source, "ERR_NOT_SUPPORTED", "Operation is not supported by this runtime");
+      return cb(seq, json, Post{});
+    }
+
+    auto ctx = new CryptoWorkContext;
+
+    ctx->seq = seq;
+    ctx->source = source;
+    // `bytes` belong to the IPC message, copy them before leaving this thread
+    ctx->input = String(bytes != nullptr ? bytes : "", bytes != nullptr ? size : 0);
+    ctx->transform = transform;
+    ctx->cb = cb;
+    ctx->req.data = (void *) ctx;
+
+    this->core->dispatchEventLoop([=, this]() {
+      auto loop = this->core->getEventLoop();
+      auto err = uv_queue_work(loop, &ctx->req, [](uv_work_t *req) {
+        auto ctx = (CryptoWorkContext *) req->data;
+        auto bytes = ctx->input.data();
+        size_t offset = 0;
+        String output;
+
+        while (offset + 4 <= ctx->input.size()) {
+          uint32_t length = 0;
+          for (int i = 3; i >= 0; --i) {
+            length = (length << 8) | (unsigned char) bytes[offset + i];
+          }
+
+          offset += 4;
+
+          if (offset + length > ctx->input.size()) {
+            break;
+          }
+
+          auto record = String(bytes + offset, length);
+          output.clear();
+
+          if (!ctx->transform(record, output)) {
+            output.clear();
+          }
+
+          putRecord(ctx->output, output);
+          offset += length;
+        }
+      }, [](uv_work_t *req, int status) {
+        auto ctx = (CryptoWorkContext *) req->data;
+
+        if (status < 0) {
+          auto json = ERR_CRYPTO(ctx->source, "ERR_CRYPTO", String(uv_strerror(status)));
+          ctx->cb(ctx->seq, json, Post{});
+          delete ctx;
+          return;
+        }
+
+        Post post;
+        auto headers = Headers {{
+          {"content-type" ,"application/octet-stream"},
+          {"content-length", (uint64_t) ctx->output.size()}
+        }};
+
+        post.id = rand64();
+        post.body = new char[ctx->output.size()]{0};
+        post.length = ctx->output.size();
+        post.headers = headers.str();
+        memcpy(post.body, ctx->output.data(), ctx->output.size());
+
+        ctx->cb(ctx->seq, JSON::Object{}, post);
+        delete ctx;
+      });
+
+      if (err < 0) {
+        auto json = ERR_CRYPTO(ctx->source, "ERR_CRYPTO", String(uv_strerror(err)));
+        ctx->cb(ctx->seq, json, Post{});
+        delete ctx;
+      }
+    });
+  }
+
+#if defined(SSC_CRYPTO_SODIUM)
+  static String fromHex (const String& input) {
+    String output;
+
+    if (input.size() % 2 != 0) {
+      return output;
+    }
+
+    output.reserve(input.size() / 2);
+
+    for (size_t i = 0; i < input.size(); i += 2) {
+      auto high = std::tolower((unsigned char) input[i]);
+      auto low = std::tolower((unsigned char) input[i + 1]);
+
+      if (!std::isxdigit(high) || !std::isxdigit(low)) {
+        return String();
+      }
+
+      auto value = (std::isdigit(high) ? high - '0' : high - 'a' + 10) << 4;
+      value |= std::isdigit(low) ? low - '0' : low - 'a' + 10;
+      output += (char) value;
+    }
+
+    return output;
+  }
+
+  #define CRYPTO_REQUIRE_KEY(source, name, value, length)                     \
+    auto value = fromHex(name);                                                \
+    if (value.size() != length) {                                              \
+      auto json = ERR_CRYPTO(source, "ERR_INVALID_KEY", "Invalid '" #name "' given in parameters"); \
+      return cb(seq, json, Post{});                                            \
+    }
+#endif
+
+  void Core::Crypto::seal (
+    const String seq,
+    const String publicKey,
+    const char* bytes,
+    size_t size,
+    Module::Callback cb
+  ) {
+  #if defined(SSC_CRYPTO_SODIUM)
+    CRYPTO_REQUIRE_KEY("crypto.seal", publicKey, pk, crypto_box_PUBLICKEYBYTES);
+    this->queue(seq, "crypto.seal", bytes, size, [pk](auto& input, auto& output) {
+      output.resize(input.size() + crypto_box_SEALBYTES);
+      return crypto_box_seal(
+        (unsigned char *) output.data(),
+        (const unsigned char *) input.data(),
+        input.size(),
+        (const unsigned char *) pk.data()
+      ) == 0;
+    }, cb);
+  #else
+    this->queue(seq, "crypto.seal", bytes, size, nullptr, cb);
+  #endif
+  }
+
+  void Core::Crypto::open (
+    const String seq,
+    const String publicKey,
+    const String secretKey,
+    const char* bytes,
+    size_t size,
+    Module::Callback cb
+  ) {
+  #if defined(SSC_CRYPTO_SODIUM)
+    CRYPTO_REQUIRE_KEY("crypto.open", publicKey, pk, crypto_box_PUBLICKEYBYTES);
+    CRYPTO_REQUIRE_KEY("crypto.open", secretKey, sk, crypto_box_SECRETKEYBYTES);
+    this->queue(seq, "crypto.open", bytes, size, [pk, sk](auto& input, auto& output) {
+      if (input.size() < crypto_box_SEALBYTES) {
+        return false;
+      }
+
+      output.resize(input.size() - crypto_box_SEALBYTES);
+      return crypto_box_seal_open(
+        (unsigned char *) output.data(),
+        (const unsigned char *) input.data(),
+        input.size(),
+        (const unsigned char *) pk.data(),
+        (const unsigned char *) sk.data()
+      ) == 0;
+    }, cb);
+  #else
+    this->queue(seq, "crypto.open", bytes, size, nullptr, cb);
+  #endif
+  }
+
+  void Core::Crypto::sign (
+    const String seq,
+    const String secretKey,
+    const char* bytes,
+    size_t size,
+    Module::Callback cb
+  ) {
+  #if defined(SSC_CRYPTO_SODIUM)
+    CRYPTO_REQUIRE_KEY("crypto.sign", secretKey, sk, crypto_sign_SECRETKEYBYTES);
+    this->queue(seq, "crypto.sign", bytes, size, [sk](auto& input, auto& output) {
+      output.resize(crypto_sign_BYTES);
+      return crypto_sign_detached(
+        (unsigned char *) output.data(),
+        nullptr,
+        (const unsigned char *) input.data(),
+        input.size(),
+        (const unsigned char *) sk.data()
+      ) == 0;
+    }, cb);
+  #else
+    this->queue(seq, "crypto.sign", bytes, size, nullptr, cb);
+  #endif
+  }
+
+  void Core::Crypto::verify (
+    const String seq,
+    const String publicKey,
+    const char* bytes,
+    size_t size,
+    Module::Callback cb
+  ) {
+  #if defined(SSC_CRYPTO_SODIUM)
+    CRYPTO_REQUIRE_KEY("crypto.verify", publicKey, pk, crypto_sign_PUBLICKEYBYTES);
+    this->queue(seq, "crypto.verify", bytes, size, [pk](auto& input, auto& output) {
+      auto valid = input.size() >= crypto_sign_BYTES && crypto_sign_verify_detached(
+        (const unsigned char *) input.data(),
+        (const unsigned char *) input.data() + crypto_sign_BYTES,
+        input.size() - crypto_sign_BYTES,
+        (const unsigned char *) pk.data()
+      ) == 0;
+
+      output = String(1, valid ? 1 : 0);
+      return true;
+    }, cb);
+  #else
+    this->queue(seq, "crypto.verify", bytes, size, nullptr, cb);
+  #endif
+  }
+
+  void Core::Crypto::ed25519PublicKeyToCurve25519 (
+    const String seq,
+    const char* bytes,
+    size_t size,
+    Module::Callback cb
+  ) {
+  #if defined(SSC_CRYPTO_SODIUM)
+    this->queue(seq, "crypto.ed25519PublicKeyToCurve25519", bytes, size, [](auto& input, auto& output) {
+      if (input.size() != crypto_sign_PUBLICKEYBYTES) {
+        return false;
+      }
+
+      output.resize(crypto_box_PUBLICKEYBYTES);
+      return crypto_sign_ed25519_pk_to_curve25519(
+        (unsigned char *) output.data(),
+        (const unsigned char *) input.data()
+      ) == 0;
+    }, cb);
+  #else
+    this->queue(seq, "crypto.ed25519PublicKeyToCurve25519", bytes, size, nullptr, cb);
+  #endif
+  }
+
+  void Core::Crypto::ed25519SecretKeyToCurve25519 (
+    const String seq,
+    const char* bytes,
+    size_t size,
+    Module::Callback cb
+  ) {
+  #if defined(SSC_CRYPTO_SODIUM)
+    this->queue(seq, "crypto.ed25519SecretKeyToCurve25519", bytes, size, [](auto& input, auto& output) {
+      if (input.size() != crypto_sign_SECRETKEYBYTES) {
+        return false;
+      }
+
+      output.resize(crypto_box_SECRETKEYBYTES);
+      return crypto_sign_ed25519_sk_to_curve25519(
+        (unsigned char *) output.data(),
+        (const unsigned char *) input.data()
+      ) == 0;
+    }, cb);
+  #else
+    this->queue(seq, "crypto.ed25519SecretKeyToCurve25519", bytes, size, nullptr, cb);
+  #endif
+  }
+
+  void Core::Crypto::hash (
+    const String seq,
+    const String algorithm,
+    size_t digestSize,
+    const char* bytes,
+    size_t size,
+    Module::Callback cb
+  ) {
+    Hasher hasher;
+    Transform transform = nullptr;
+
+    if (hasher.init(algorithm, digestSize)) {
+      transform = [algorithm, digestSize](auto& input, auto& output) {
+        Hasher hasher;
+        hasher.init(algorithm, digestSize);
+        hasher.update(input.data(), input.size());
+        output = hasher.digest();
+        return true;
+      };
+    }
+
+    this->queue(seq, "crypto.hash", bytes, size, transform, cb);
+  }
+
+  void Core::Crypto::hashDescriptor (
+    const String seq,
+    const String algorithm,
+    size_t digestSize,
+    uint64_t id,
+    Module::Callback cb
+  ) {
+    this->core->dispatchEventLoop([=, this]() {
+      auto desc = this->core->fs.getDescriptor(id);
+
+      if (desc == nullptr) {
+        auto json = JSON::Object::Entries {
+          {"source", "crypto.hashDescriptor"},
+          {"err", JSON::Object::Entries {
+            {"id", std::to_string(id)},
+            {"code", "ENOTOPEN"},
+            {"type", "NotFoundError"},
+            {"message", "No file descriptor found with that id"}
+          }}
+        };
+
+        return cb(seq, json, Post{});
+      }
+
+      auto ctx = new HashWorkContext;
+
+      if (!ctx->hasher.init(algorithm, digestSize)) {
+        auto json = ERR_CRYPTO("crypto.hashDescriptor", "ERR_NOT_SUPPORTED", "Operation is not supported by this runtime");
+        delete ctx;
+        return cb(seq, json, Post{});
+      }
+
+      // the work reads a duplicate so a `fs.close` while it runs can not
+      // close the file or hand its number to another open under the hash
+      #if defined(_WIN32)
+        ctx->fd = _dup(desc->fd);
+      #else
+        ctx->fd = dup(desc->fd);
+      #endif
+
+      if (ctx->fd < 0) {
+        auto err = errno == EMFILE ? UV_EMFILE : UV_EBADF;
+        auto json = JSON::Object::Entries {
+          {"source", "crypto.hashDescriptor"},
+          {"err", JSON::Object::Entries {
+            {"id", std::to_string(id)},
+            {"code", err},
+            {"message", String(uv_strerror(err))}
+          }}
+        };
+
+        delete ctx;
+        return cb(seq, json, Post{});
+      }
+
+      ctx->seq = seq;
+      ctx->id = id;
+      ctx->cb = cb;
+      ctx->req.data = (void *) ctx;
+
+      auto loop = this->core->getEventLoop();
+      auto err = uv_queue_work(loop, &ctx->req, [](uv_work_t *req) {
+        auto ctx = (HashWorkContext *) req->data;
+        auto buffer = std::make_unique<char[]>(64 * 1024);
+
+        // positional reads leave the descriptor offset untouched for `fs.read`
+        while (true) {
+          uv_fs_t fs;
+          auto buf = uv_buf_init(buffer.get(), 64 * 1024);
+          auto result = uv_fs_read(nullptr, &fs, ctx->fd, &buf, 1, (int64_t) ctx->size, nullptr);
+          uv_fs_req_cleanup(&fs);
+
+          if (result < 0) {
+            ctx->err = result;
+            return;
+          }
+
+          if (result == 0) {
+            break;
+          }
+
+          ctx->hasher.update(buffer.get(), result);
+          ctx->size += result;
+        }
+
+        ctx->digest = ctx->hasher.digest();
+      }, [](uv_work_t *req, int status) {
+        auto ctx = (HashWorkContext *) req->data;
+        auto err = status < 0 ? status : ctx->err;
+        auto json = JSON::Object {};
+
+        if (err < 0) {
+          json = JSON::Object::Entries {
+            {"source", "crypto.hashDescriptor"},
+            {"err", JSON::Object::Entries {
+              {"id", std::to_string(ctx->id)},
+              {"code", err},
+              {"message", String(uv_strerror(err))}
+            }}
+          };
+        } else {
+          json = JSON::Object::Entries {
+            {"source", "crypto.hashDescriptor"},
+            {"data", JSON::Object::Entries {
+              {"id", std::to_string(ctx->id)},
+              {"digest", toHex(ctx->digest)},
+              {"size", ctx->size}
+            }}
+          };
+        }
+
+        closeHashDescriptor(ctx->fd);
+        ctx->cb(ctx->seq, json, Post{});
+        delete ctx;
+      });
+
+      if (err < 0) {
+        auto json = ERR_CRYPTO("crypto.hashDescriptor", "ERR_CRYPTO", String(uv_strerror(err)));
+        closeHashDescriptor(ctx->fd);
+        ctx->cb(seq, json, Post{});
+        delete ctx;
+      }
+    });
+  }
+}
@@ -0,0 +1,312 @@
+#include "core.hh"
+
+namespace SSC {
+  struct DNSResolveRequest {
+    uv_getaddrinfo_t req;
+    Core::DNS::ResolveCallback cb;
+  };
+
+  static String getCacheKey (const String& hostname, int family) {
+    auto key = hostname;
+    std::transform(key.begin(), key.end(), key.begin(), ::tolower);
+    return key + ":" + std::to_string(family);
+  }
+
+  static JSON::Object::Entries getLookupResult (
+    bool all,
+    int err,
+    const Vector<Core::DNS::Address>& addresses
+  ) {
+    if (err == 0 && addresses.size() == 0) {
+      err = UV_EAI_NONAME;
+    }
+
+    if (err < 0) {
+      return JSON::Object::Entries {
+        {"source", "dns.lookup"},
+        {"err", JSON::Object::Entries {
+          {"code", std::to_string(err)},
+          {"message", String(uv_strerror(err))}
+        }}
+      };
+    }
+
+    auto data = JSON::Object::Entries {
+      {"address", addresses[0].address},
+      {"family", addresses[0].family}
+    };
+
+    if (all) {
+      JSON::Array::Entries entries;
+
+      for (const auto& address : addresses) {
+        entries.push_back(JSON::Object::Entries {
+          {"address", address.address},
+          {"family", address.family}
+        });
+      }
+
+      data["addresses"] = entries;
+    }
+
+    return JSON::Object::Entries {
+      {"source", "dns.lookup"},
+      {"data", data}
+    };
+  }
+
+  void Core::DNS::resolve (
+    const String& hostname,
+    int family,
+    Core::DNS::ResolveCallback cb
+  ) {
+    auto local = this->localAddresses.find(getCacheKey(hostname, 0));
+
+    if (local != this->localAddresses.end()) {
+      Vector<Address> addresses;
+
+      for (const auto& address : local->second) {
+        if (family == 0 || address.family == family) {
+          addresses.push_back(address);
+        }
+      }
+
+      return cb(addresses.size() > 0 ? 0 : UV_EAI_NONAME, addresses);
+    }
+
+    if (this->resolver != nullptr) {
+      return this->resolver(hostname, family, cb);
+    }
+
+    auto loop = this->core->getEventLoop();
+    auto request = new DNSResolveRequest;
+    struct addrinfo hints = {0};
+
+    if (family == 6) {
+      hints.ai_family = AF_INET6;
+    } else if (family == 4) {
+      hints.ai_family = AF_INET;
+    } else {
+      hints.ai_family = AF_UNSPEC;
+    }
+
+    // one result per address instead of one per socket type
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_protocol = 0; // `0` for any
+
+    request->cb = cb;
+    request->req.data = (void *) request;
+
+    auto err = uv_getaddrinfo(loop, &request->req, [](uv_getaddrinfo_t *req, int status, struct addrinfo *res) {
+      auto request = (DNSResolveRequest *) req->data;
+      Vector<Address> addresses;
+
+      for (auto info = status == 0 ? res : nullptr; info != nullptr; info = info->ai_next) {
+        char address[INET6_ADDRSTRLEN] = {0};
+        int family = 0;
+
+        if (info->ai_family == AF_INET) {
+          uv_ip4_name((struct sockaddr_in *) info->ai_addr, address, sizeof(address));
+          family = 4;
+        } else if (info->ai_family == AF_INET6) {
+          uv_ip6_name((struct sockaddr_in6 *) info->ai_addr, address, sizeof(address));
+          family = 6;
+        } else {
+          continue;
+        }
+
+        auto duplicate = std::find_if(addresses.begin(), addresses.end(), [&](const auto& entry) {
+          return entry.address == address;
+        });
+
+        if (duplicate == addresses.end()) {
+          addresses.push_back(Address { address, family });
+        }
+      }
+
+      uv_freeaddrinfo(res);
+      request->cb(status, addresses);
+      delete request;
+    }, hostname.c_str(), nullptr, &hints);
+
+    if (err < 0) {
+      delete request;
+      cb(err, Vector<Address>{});
+    }
+  }
+
+  void Core::DNS::lookup (
+    const String seq,
+    LookupOptions options,
+    Core::Module::Callback cb
+  ) {
+    this->core->dispatchEventLoop([=, this]() {
+      auto key = getCacheKey(options.hostname, options.family);
+      auto now = uv_now(this->core->getEventLoop());
+      auto cached = this->cache.find(key);
+
+      if (cached != this->cache.end()) {
+        if (cached->second.expires > now) {
+          if (cached->second.err < 0) {
+            this->stats.negativeHits++;
+          } else {
+            this->stats.hits++;
+          }
+
+          auto json = getLookupResult(options.all, cached->second.err, cached->second.addresses);
+          return cb(seq, json, Post{});
+        }
+
+        this->cache.erase(cached);
+      }
+
+      // concurrent lookups of the same name share one query
+      if (this->inflight.contains(key)) {
+        this->stats.coalesced++;
+        this->inflight[key].push_back(PendingLookup { seq, options.all, cb });
+        return;
+      }
+
+      this->stats.misses++;
+      this->inflight[key].push_back(PendingLookup { seq, options.all, cb });
+
+      this->resolve(options.hostname, options.family, [=, this](int err, Vector<Address> addresses) {
+        auto entry = CacheEntry { addresses, err, 0 };
+        auto now = uv_now(this->core->getEventLoop());
+
+        if (err == 0 && addresses.size() == 0) {
+          entry.err = UV_EAI_NONAME;
+        }
+
+        // transient failures, like `EAI_AGAIN`, are not cached
+        if (entry.err == 0) {
+          entry.expires = now + POSITIVE_TTL;
+        } else if (entry.err == UV_EAI_NONAME || entry.err == UV_EAI_NODATA) {
+          entry.expires = now + NEGATIVE_TTL;
+        }
+
+        if (entry.expires > 0) {
+          if (this->cache.size() >= MAX_CACHE_ENTRIES) {
+            std::erase_if(this->cache, [now](const auto& tuple) {
+              return tuple.second.expires <= now;
+            });
+          }
+
+          if (this->cache.size() >= MAX_CACHE_ENTRIES) {
+            this->cache.erase(this->cache.begin());
+            this->stats.evictions++;
+          }
+
+          this->cache[key] = entry;
+        }
+
+        auto pending = std::move(this->inflight[key]);
+        this->inflight.erase(key);
+
+        for (const auto& lookup : pending) {
+          auto json = getLookupResult(lookup.all, entry.err, entry.addresses);
+          lookup.cb(lookup.seq, json, Post{});
+        }
+      });
+    });
+  }
+
+  void Core::DNS::clearCache (const String seq, Module::Callback cb) {
+    this->core->dispatchEventLoop([=, this]() {
+      auto size = this->cache.size();
+      this->cache.clear();
+
+      auto json = JSON::Object::Entries {
+        {"source", "dns.clearCache"},
+        {"data", JSON::Object::Entries {
+          {"cleared", (uint64_t) size}
+        }}
+      };
+
+      cb(seq, json, Post{});
+    });
+  }
+
+  void Core::DNS::getStats (const String seq, Module::Callback cb) {
+    this->core->dispatchEventLoop([=, this]() {
+      auto answered = this->stats.hits + this->stats.negativeHits + this->stats.coalesced;
+      auto lookups = answered + this->stats.misses;
+
+      auto json = JSON::Object::Entries {
+        {"source", "dns.getStats"},
+        {"data", JSON::Object::Entries {
+          {"lookups", lookups},
+          {"hits", this->stats.hits},
+          {"negativeHits", this->stats.negativeHits},
+          {"misses", this->stats.misses},
+          {"coalesced", this->stats.coalesced},
+          {"evictions", this->stats.evictions},
+          {"size", (uint64_t) this->cache.size()},
+          {"inflight", (uint64_t) this->inflight.size()},
+          // lookups answered without a query of their own
+          {"hitRatio", lookups > 0 ? (double) answered / lookups : 0.0}
+        }}
+      };
+
+      cb(seq, json, Post{});
+    });
+  }
+
+  void Core::DNS::setLocalAddresses (
+    const String seq,
+    const String hostname,
+    Vector<String> addresses,
+    Module::Callback cb
+  ) {
+    this->core->dispatchEventLoop([=, this]() {
+      auto key = getCacheKey(hostname, 0);
+      Vector<Address> entries;
+
+      for (const auto& address : addresses) {
+        struct sockaddr_storage addr;
+
+        if (parseSocketAddress(address, 0, &addr) != 0) {
+          auto json = JSON::Object::Entries {
+            {"source", "dns.setLocalAddresses"},
+            {"err", JSON::Object::Entries {
+              {"type", "TypeError"},
+              {"message", "Invalid IP address: " + address}
+            }}
+          };
+
+          return cb(seq, json, Post{});
+        }
+
+        entries.push_back(Address { address, addr.ss_family == AF_INET6 ? 6 : 4 });
+      }
+
+      if (entries.size() > 0) {
+        this->localAddresses[key] = entries;
+      } else {
+        this->localAddresses.erase(key);
+      }
+
+      // drop answers cached for any family of `hostname`
+      for (auto family : { 0, 4, 6 }) {
+        this->cache.erase(getCacheKey(hostname, family));
+      }
+
+      auto json = JSON::Object::Entries {
+        {"source", "dns.setLocalAddresses"},
+        {"data", JSON::Object::Entries {
+          {"hostname", hostname},
+          {"addresses", (uint64_t) entries.size()}
+        }}
+      };
+
+      cb(seq, json, Post{});
+    });
+  }
+
+  void Core::DNS::setResolver (Resolver resolver) {
+    this->core->dispatchEventLoop([=, this]() {
+      this->resolver = resolver;
+      this->cache.clear();
+    });
+  }
+}
@@ -14,14 +14,14 @@ namespace SSC::JSON {
     auto output = std::to_string(value);
     auto decimal = output.find(".");
 
-    // trim trailing zeros
-    if (decimal >= 0) {
+    // trim trailing zeros, and the decimal point for whole numbers
+    if (decimal != std::string::npos) {
       auto i = output.size() - 1;
-      while (output[i] != '0') {
+      while (i > decimal && output[i] == '0') {
         i--;
       }
 
-      return output.substr(0, i + 1);
+      return output.substr(0, i == decimal ? i : i + 1);
     }
 
     return output;
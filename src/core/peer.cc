@@ -1,11 +1,469 @@
 #include "core.hh"
+#include <cstring>
+
+#if defined(__linux__)
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// `linux/udp.h` values, missing from older libc headers
+#ifndef UDP_SEGMENT
+#define UDP_SEGMENT 103
+#endif
+
+#ifndef UDP_GRO
+#define UDP_GRO 104
+#endif
+#endif
 
 namespace SSC {
+  JSON::Object::Entries ERR_SOCKET_ALREADY_BOUND (
+    const String& source,
+    uint64_t id
+  ) {
+    return JSON::Object::Entries {
+      {"source", source},
+      {"err", JSON::Object::Entries {
+        {"id", std::to_string(id)},
+        {"type", "InternalError"},
+        {"code", "ERR_SOCKET_ALREADY_BOUND"},
+        {"message", "Socket is already bound"}
+      }}
+    };
+  }
+
+  // one `uv_udp_send()` per datagram of a segmented send that could not be
+  // handed to the kernel with `UDP_SEGMENT`
+  struct SegmentedSendContext {
+    Peer::RequestContext::Callback cb;
+    Peer *peer = nullptr;
+    char *bytes = nullptr;
+    size_t pending = 0;
+    int status = 0;
+  };
+
+  // one timer per peer, armed for the earliest target deadline
+  struct Peer::Keepalive {
+    struct Entry {
+      Peer::KeepaliveTarget target;
+      struct sockaddr_storage addr;
+      uint64_t deadline = 0;
+      // hole punching probes sent since the target was last reachable
+      unsigned int attempts = 0;
+    };
+
+    uv_timer_t timer;
+    Peer *peer = nullptr;
+    String payload;
+    Peer::KeepaliveCallback onchange;
+    // keyed by the resolved address, which is how datagrams are matched
+    std::map<String, Entry> entries;
+  };
+
+  static String getKeepaliveKey (const struct sockaddr *addr) {
+    char address[INET6_ADDRSTRLEN] = {0};
+    int port = 0;
+
+    parseAddress((struct sockaddr *) addr, &port, address);
+    return String(address) + ":" + std::to_string(port);
+  }
+
+  static void runKeepalive (uv_timer_t *timer);
+
+  static void scheduleKeepalive (Peer::Keepalive *keepalive) {
+    if (keepalive->entries.size() == 0) {
+      uv_timer_stop(&keepalive->timer);
+      return;
+    }
+
+    auto now = uv_now(keepalive->timer.loop);
+    auto deadline = keepalive->entries.begin()->second.deadline;
+
+    for (const auto& tuple : keepalive->entries) {
+      const auto& target = tuple.second.target;
+      deadline = std::min(deadline, tuple.second.deadline);
+
+      // wake up in time to report a target that stopped answering
+      if (target.reachable) {
+        auto timeout = target.timeout > 0 ? target.timeout : target.interval * 3;
+        deadline = std::min(deadline, target.lastSeen + timeout);
+      }
+    }
+
+    uv_timer_start(&keepalive->timer, runKeepalive, deadline > now ? deadline - now : 0, 0);
+  }
+
+  static void runKeepalive (uv_timer_t *timer) {
+    auto keepalive = (Peer::Keepalive *) timer->data;
+    auto peer = keepalive->peer;
+    auto now = uv_now(timer->loop);
+    // paused peers have their handle closed until resumed
+    auto canSend = !peer->isPaused() && !peer->isClosing() && !peer->isClosed();
+    Vector<Peer::KeepaliveTarget> changes;
+
+    for (auto& tuple : keepalive->entries) {
+      auto& entry = tuple.second;
+      auto& target = entry.target;
+      auto timeout = target.timeout > 0 ? target.timeout : target.interval * 3;
+
+      if (target.reachable && now - target.lastSeen >= timeout) {
+        target.reachable = false;
+        entry.attempts = 0;
+        entry.deadline = now;
+        changes.push_back(target);
+      }
+
+      if (entry.deadline > now) {
+        continue;
+      }
+
+      if (canSend) {
+        auto buf = uv_buf_init(
+          (char *) keepalive->payload.data(),
+          (unsigned int) keepalive->payload.size()
+        );
+
+        auto status = uv_udp_try_send(
+          (uv_udp_t *) &peer->handle,
+          &buf,
+          1,
+          (const struct sockaddr *) &entry.addr
+        );
+
+        // a full send queue only delays the probe to the next deadline
+        if (status >= 0) {
+          target.sent++;
+        }
+      }
+
+      if (!target.reachable && ++entry.attempts < target.punchAttempts) {
+        entry.deadline = now + target.punchInterval;
+      } else {
+        entry.deadline = now + target.interval;
+      }
+    }
+
+    scheduleKeepalive(keepalive);
+
+    // last, as `onchange` may remove targets
+    if (keepalive->onchange != nullptr) {
+      for (const auto& target : changes) {
+        keepalive->onchange(target);
+      }
+    }
+  }
+
+  static void observeKeepalive (Peer *peer, const struct sockaddr *addr) {
+    auto keepalive = peer->keepalive;
+
+    if (keepalive == nullptr || addr == nullptr) {
+      return;
+    }
+
+    auto it = keepalive->entries.find(getKeepaliveKey(addr));
+
+    if (it == keepalive->entries.end()) {
+      return;
+    }
+
+    auto& entry = it->second;
+    auto now = uv_now(keepalive->timer.loop);
+
+    entry.target.lastSeen = now;
+    entry.target.received++;
+
+    if (!entry.target.reachable) {
+      entry.target.reachable = true;
+      entry.attempts = 0;
+      entry.deadline = now + entry.target.interval;
+      scheduleKeepalive(keepalive);
+
+      // a copy, as `onchange` may remove the entry
+      auto target = entry.target;
+      if (keepalive->onchange != nullptr) {
+        keepalive->onchange(target);
+      }
+    }
+  }
+
+  static void stopKeepalive (Peer *peer) {
+    auto keepalive = peer->keepalive;
+
+    if (keepalive == nullptr) {
+      return;
+    }
+
+    peer->keepalive = nullptr;
+    uv_timer_stop(&keepalive->timer);
+    uv_close((uv_handle_t *) &keepalive->timer, [](uv_handle_t *handle) {
+      delete (Peer::Keepalive *) handle->data;
+    });
+  }
+
+#if defined(__linux__)
+  struct Peer::ReceiveOffload {
+    uv_poll_t poll;
+    uv_os_sock_t fd = -1;
+    Peer *peer = nullptr;
+    char buffer[65536];
+  };
+
+  static void deliverReceiveOffload (
+    Peer *peer,
+    const char *bytes,
+    ssize_t nread,
+    size_t segmentSize,
+    const struct sockaddr *addr
+  ) {
+    if (nread > 0) {
+      observeKeepalive(peer, addr);
+    }
+
+    // receive filters (the relay) expect one datagram per call
+    if (peer->receiveFilter != nullptr && segmentSize > 0) {
+      for (ssize_t offset = 0; offset < nread; offset += segmentSize) {
+        auto length = std::min((ssize_t) segmentSize, nread - offset);
+        auto buf = uv_buf_init(new char[length], (unsigned int) length);
+
+        memcpy(buf.base, bytes + offset, length);
+
+        if (!peer->receiveFilter(length, &buf, addr)) {
+          peer->receiveCallback(length, &buf, addr);
+        }
+      }
+
+      return;
+    }
+
+    auto buf = uv_buf_init(new char[nread > 0 ? nread : 1], (unsigned int) nread);
+
+    if (nread > 0) {
+      memcpy(buf.base, bytes, nread);
+    }
+
+    if (peer->receiveFilter != nullptr && peer->receiveFilter(nread, &buf, addr)) {
+      return;
+    }
+
+    peer->receiveSegmentSize = segmentSize;
+    peer->receiveCallback(nread, &buf, addr);
+    peer->receiveSegmentSize = 0;
+  }
+
+  // `uv_udp_recv_start()` does not surface the `UDP_GRO` control message,
+  // so coalesced datagrams are read with `recvmsg()` from a duplicate of the
+  // socket polled on the same loop
+  static int startReceiveOffload (Peer *peer) {
+    auto loop = peer->core->getEventLoop();
+    uv_os_fd_t fd;
+    int enable = 1;
+    int err = 0;
+
+    if ((err = uv_fileno((uv_handle_t *) &peer->handle, &fd))) {
+      return err;
+    }
+
+    if (setsockopt(fd, IPPROTO_UDP, UDP_GRO, &enable, sizeof(enable)) < 0) {
+      return -errno;
+    }
+
+    auto offload = new Peer::ReceiveOffload;
+    offload->peer = peer;
+    offload->fd = dup(fd);
+
+    if (offload->fd < 0) {
+      err = -errno;
+    } else if ((err = uv_poll_init(loop, &offload->poll, offload->fd))) {
+      ::close(offload->fd);
+    }
+
+    if (err) {
+      enable = 0;
+      setsockopt(fd, IPPROTO_UDP, UDP_GRO, &enable, sizeof(enable));
+      delete offload;
+      return err;
+    }
+
+    offload->poll.data = (void *) offload;
+    peer->receiveOffload = offload;
+
+    return uv_poll_start(&offload->poll, UV_READABLE, [](uv_poll_t *handle, int status, int events) {
+      auto offload = (Peer::ReceiveOffload *) handle->data;
+      auto peer = offload->peer;
+
+      if (status < 0) {
+        auto buf = uv_buf_init(nullptr, 0);
+        peer->receiveCallback(status, &buf, nullptr);
+        return;
+      }
+
+      // bounded so a busy socket does not starve the loop
+      for (int i = 0; i < 64 && peer->receiveOffload == offload; ++i) {
+        struct sockaddr_storage from;
+        char control[CMSG_SPACE(sizeof(int))];
+        struct iovec iov = { offload->buffer, sizeof(offload->buffer) };
+        struct msghdr message = {};
+        size_t segmentSize = 0;
+        ssize_t nread = 0;
+
+        message.msg_name = &from;
+        message.msg_namelen = sizeof(from);
+        message.msg_iov = &iov;
+        message.msg_iovlen = 1;
+        message.msg_control = control;
+        message.msg_controllen = sizeof(control);
+
+        do {
+          nread = recvmsg(offload->fd, &message, MSG_DONTWAIT);
+        } while (nread < 0 && errno == EINTR);
+
+        if (nread < 0) {
+          if (errno != EAGAIN && errno != EWOULDBLOCK) {
+            auto buf = uv_buf_init(nullptr, 0);
+            peer->receiveCallback(-errno, &buf, nullptr);
+          }
+
+          break;
+        }
+
+        for (
+          auto cmsg = CMSG_FIRSTHDR(&message);
+          cmsg != nullptr;
+          cmsg = CMSG_NXTHDR(&message, cmsg)
+        ) {
+          if (cmsg->cmsg_level == IPPROTO_UDP && cmsg->cmsg_type == UDP_GRO) {
+            int size = 0;
+            memcpy(&size, CMSG_DATA(cmsg), sizeof(size));
+            segmentSize = size > 0 ? (size_t) size : 0;
+          }
+        }
+
+        if (segmentSize >= (size_t) nread) {
+          segmentSize = 0;
+        }
+
+        deliverReceiveOffload(
+          peer,
+          offload->buffer,
+          nread,
+          segmentSize,
+          (const struct sockaddr *) &from
+        );
+      }
+    });
+  }
+
+  static void stopReceiveOffload (Peer *peer) {
+    auto offload = peer->receiveOffload;
+
+    if (offload == nullptr) {
+      return;
+    }
+
+    peer->receiveOffload = nullptr;
+    uv_poll_stop(&offload->poll);
+    uv_close((uv_handle_t *) &offload->poll, [](uv_handle_t *handle) {
+      auto offload = (Peer::ReceiveOffload *) handle->data;
+      ::close(offload->fd);
+      delete offload;
+    });
+  }
+#endif
+
+  bool PeerRegistry::has (uint64_t id) {
+    auto& shard = this->shard(id);
+    std::lock_guard lock(shard.mutex);
+    return shard.peers.find(id) != shard.peers.end();
+  }
+
+  Peer* PeerRegistry::get (uint64_t id) {
+    auto& shard = this->shard(id);
+    std::lock_guard lock(shard.mutex);
+    auto it = shard.peers.find(id);
+    return it != shard.peers.end() ? it->second : nullptr;
+  }
+
+  void PeerRegistry::insert (Peer *peer) {
+    auto& shard = this->shard(peer->id);
+    std::lock_guard lock(shard.mutex);
+    shard.peers[peer->id] = peer;
+  }
+
+  void PeerRegistry::remove (uint64_t id, Peer *peer) {
+    auto& shard = this->shard(id);
+    std::lock_guard lock(shard.mutex);
+    auto it = shard.peers.find(id);
+
+    if (it != shard.peers.end() && (peer == nullptr || it->second == peer)) {
+      shard.peers.erase(it);
+    }
+  }
+
+  size_t PeerRegistry::size () {
+    size_t size = 0;
+
+    for (auto& shard : this->shards) {
+      std::lock_guard lock(shard.mutex);
+      size += shard.peers.size();
+    }
+
+    return size;
+  }
+
+  Vector<Peer*> PeerRegistry::snapshot () {
+    Vector<Peer*> peers;
+
+    for (auto& shard : this->shards) {
+      std::lock_guard lock(shard.mutex);
+      for (const auto& tuple : shard.peers) {
+        peers.push_back(tuple.second);
+      }
+    }
+
+    return peers;
+  }
+
+  Peer* PeerRegistry::acquire (int family) {
+    Lock lock(this->poolMutex);
+
+    // the first send auto binds a handle to the wildcard address of the
+    // destination family, it can not send to the other family afterwards
+    for (auto it = this->pool.rbegin(); it != this->pool.rend(); ++it) {
+      struct sockaddr_storage addr;
+      int namelen = sizeof(addr);
+      auto peer = *it;
+
+      if (
+        uv_udp_getsockname(&peer->handle.udp, (struct sockaddr *) &addr, &namelen) == 0 &&
+        addr.ss_family != family
+      ) {
+        continue;
+      }
+
+      this->pool.erase(std::next(it).base());
+      return peer;
+    }
+
+    return nullptr;
+  }
+
+  bool PeerRegistry::release (Peer *peer) {
+    Lock lock(this->poolMutex);
+
+    if (this->pool.size() >= PeerRegistry::MAX_POOLED_PEERS) {
+      return false;
+    }
+
+    this->remove(peer->id, peer);
+    this->pool.push_back(peer);
+    return true;
+  }
+
+  // peers are collected first as `pause()` and `resume()` may close peers,
+  // which removes them from the registry
   void Core::resumeAllPeers () {
     dispatchEventLoop([=, this]() {
-      Lock lock(this->peersMutex);
-      for (auto const &tuple : this->peers) {
-        auto peer = tuple.second;
+      for (auto peer : this->peers.snapshot()) {
         if (peer != nullptr && (peer->isBound() || peer->isConnected())) {
           peer->resume();
         }
@@ -15,9 +473,7 @@ namespace SSC {
 
   void Core::pauseAllPeers () {
     dispatchEventLoop([=, this]() {
-      Lock lock(this->peersMutex);
-      for (auto const &tuple : this->peers) {
-        auto peer = tuple.second;
+      for (auto peer : this->peers.snapshot()) {
         if (peer != nullptr && (peer->isBound() || peer->isConnected())) {
           peer->pause();
         }
@@ -26,8 +482,7 @@ namespace SSC {
   }
 
   bool Core::hasPeer (uint64_t peerId) {
-    Lock lock(this->peersMutex);
-    return this->peers.find(peerId) != this->peers.end();
+    return this->peers.has(peerId);
   }
 
   void Core::removePeer (uint64_t peerId) {
@@ -35,23 +490,19 @@ namespace SSC {
   }
 
   void Core::removePeer (uint64_t peerId, bool autoClose) {
-    if (this->hasPeer(peerId)) {
+    auto peer = this->peers.get(peerId);
+
+    if (peer != nullptr) {
       if (autoClose) {
-        auto peer = this->getPeer(peerId);
-        if (peer != nullptr) {
-          peer->close();
-        }
+        peer->close();
       }
 
-      Lock lock(this->peersMutex);
-      this->peers.erase(peerId);
+      this->peers.remove(peerId, peer);
     }
   }
 
   Peer* Core::getPeer (uint64_t peerId) {
-    if (!this->hasPeer(peerId)) return nullptr;
-    Lock lock(this->peersMutex);
-    return this->peers.at(peerId);
+    return this->peers.get(peerId);
   }
 
   Peer* Core::createPeer (peer_type_t peerType, uint64_t peerId) {
@@ -63,21 +514,40 @@ namespace SSC {
     uint64_t peerId,
     bool isEphemeral
   ) {
-    if (this->hasPeer(peerId)) {
-      auto peer = this->getPeer(peerId);
-      if (peer != nullptr) {
-        if (isEphemeral) {
-          Lock lock(peer->mutex);
-          peer->flags = (peer_flag_t) (peer->flags | PEER_FLAG_EPHEMERAL);
-        }
+    return this->createPeer(peerType, peerId, isEphemeral, AF_UNSPEC);
+  }
+
+  // `family` is the address family the peer sends to, pooled ephemeral
+  // handles are only reused for it
+  Peer* Core::createPeer (
+    peer_type_t peerType,
+    uint64_t peerId,
+    bool isEphemeral,
+    int family
+  ) {
+    auto peer = this->peers.get(peerId);
+
+    if (peer != nullptr) {
+      if (isEphemeral) {
+        peer->flags |= PEER_FLAG_EPHEMERAL;
       }
 
       return peer;
     }
 
-    auto peer = new Peer(this, peerType, peerId, isEphemeral);
-    Lock lock(this->peersMutex);
-    this->peers[peer->id] = peer;
+    // ephemeral UDP peers reuse a pooled handle when one is idle
+    if (isEphemeral && peerType == PEER_TYPE_UDP && family != AF_UNSPEC) {
+      peer = this->peers.acquire(family);
+    }
+
+    if (peer != nullptr) {
+      Lock lock(peer->mutex);
+      peer->id = peerId;
+    } else {
+      peer = new Peer(this, peerType, peerId, isEphemeral);
+    }
+
+    this->peers.insert(peer);
     return peer;
   }
 
@@ -184,14 +654,15 @@ namespace SSC {
     this->core = core;
 
     if (isEphemeral) {
-      this->flags = (peer_flag_t) (this->flags | PEER_FLAG_EPHEMERAL);
+      this->flags |= PEER_FLAG_EPHEMERAL;
     }
 
     this->init();
   }
 
   Peer::~Peer () {
-    this->core->removePeer(this->id, true); // auto close
+    // only unregisters this instance, the ID may belong to a reused peer
+    this->core->peers.remove(this->id, this);
   }
 
   int Peer::init () {
@@ -237,18 +708,15 @@ namespace SSC {
   }
 
   void Peer::addState (peer_state_t value) {
-    Lock lock(this->mutex);
-    this->state = (peer_state_t) (this->state | value);
+    this->state.fetch_or(value);
   }
 
   void Peer::removeState (peer_state_t value) {
-    Lock lock(this->mutex);
-    this->state = (peer_state_t) (this->state & ~value);
+    this->state.fetch_and(~value);
   }
 
   bool Peer::hasState (peer_state_t value) {
-    Lock lock(this->mutex);
-    return (value & this->state) == value;
+    return (value & this->state.load()) == value;
   }
 
   const RemotePeerInfo* Peer::getRemotePeerInfo () {
@@ -262,18 +730,15 @@ namespace SSC {
   }
 
   bool Peer::isUDP () {
-    Lock lock(this->mutex);
     return this->type == PEER_TYPE_UDP;
   }
 
   bool Peer::isTCP () {
-    Lock lock(this->mutex);
     return this->type == PEER_TYPE_TCP;
   }
 
   bool Peer::isEphemeral () {
-    Lock lock(this->mutex);
-    return (PEER_FLAG_EPHEMERAL & this->flags) == PEER_FLAG_EPHEMERAL;
+    return (PEER_FLAG_EPHEMERAL & this->flags.load()) == PEER_FLAG_EPHEMERAL;
   }
 
   bool Peer::isBound () {
@@ -318,31 +783,51 @@ namespace SSC {
       return info->err;
     }
 
-    return this->bind(info->address, info->port, this->options.udp.reuseAddr);
+    return this->bind(
+      info->address,
+      info->port,
+      this->options.udp.reuseAddr,
+      this->isTCP() ? this->options.tcp.ipv6Only : this->options.udp.ipv6Only
+    );
   }
 
   int Peer::bind (const String address, int port) {
-    return this->bind(address, port, false);
+    return this->bind(address, port, false, false);
   }
 
   int Peer::bind (const String address, int port, bool reuseAddr) {
+    return this->bind(address, port, reuseAddr, false);
+  }
+
+  int Peer::bind (const String address, int port, bool reuseAddr, bool ipv6Only) {
     Lock lock(this->mutex);
     auto sockaddr = (struct sockaddr*) &this->addr;
-    int flags = 0;
     int err = 0;
 
-    this->options.udp.reuseAddr = reuseAddr;
+    // cached destinations depend on the family of the bound socket
+    for (auto& entry : this->addressCache) {
+      entry.port = -1;
+    }
 
-    if (reuseAddr) {
-      flags |= UV_UDP_REUSEADDR;
+    if ((err = parseSocketAddress(address, port, &this->addr))) {
+      return err;
     }
 
     if (this->isUDP()) {
-      if ((err = uv_ip4_addr((char *) address.c_str(), port, &this->addr))) {
-        return err;
+      int flags = 0;
+
+      this->options.udp.reuseAddr = reuseAddr;
+      this->options.udp.ipv6Only = ipv6Only;
+
+      if (reuseAddr) {
+        flags |= UV_UDP_REUSEADDR;
+      }
+
+      // binding `::` without this flag accepts IPv4 traffic too (dual-stack)
+      if (ipv6Only) {
+        flags |= UV_UDP_IPV6ONLY;
       }
 
-      // @TODO(jwerle): support flags in `bind()`
       if ((err = uv_udp_bind((uv_udp_t *) &this->handle, sockaddr, flags))) {
         return err;
       }
@@ -351,7 +836,13 @@ namespace SSC {
     }
 
     if (this->isTCP()) {
-      // @TODO: `bind()` + `listen()?`
+      this->options.tcp.ipv6Only = ipv6Only;
+
+      if ((err = uv_tcp_bind((uv_tcp_t *) &this->handle, sockaddr, ipv6Only ? UV_TCP_IPV6ONLY : 0))) {
+        return err;
+      }
+
+      this->addState(PEER_STATE_TCP_BOUND);
     }
 
     return this->initLocalPeerInfo();
@@ -367,7 +858,7 @@ namespace SSC {
     }
 
     Lock lock(this->mutex);
-    memset((void *) &this->addr, 0, sizeof(struct sockaddr_in));
+    memset((void *) &this->addr, 0, sizeof(struct sockaddr_storage));
 
     if ((err = this->bind())) {
       return err;
@@ -387,7 +878,7 @@ namespace SSC {
     auto sockaddr = (struct sockaddr*) &this->addr;
     int err = 0;
 
-    if ((err = uv_ip4_addr((char *) address.c_str(), port, &this->addr))) {
+    if ((err = this->resolveAddress(address, port, &this->addr))) {
       return err;
     }
 
@@ -421,6 +912,60 @@ namespace SSC {
     return err;
   }
 
+  int Peer::resolveAddress (
+    const String& address,
+    int port,
+    struct sockaddr_storage *addr
+  ) {
+    int err = 0;
+
+    if ((err = parseSocketAddress(address, port, addr))) {
+      return err;
+    }
+
+    // a dual-stack socket bound to an IPv6 address reaches IPv4 endpoints
+    // through their IPv4-mapped IPv6 address (`::ffff:a.b.c.d`)
+    if (
+      addr->ss_family == AF_INET &&
+      this->isBound() &&
+      this->local.addr.ss_family == AF_INET6
+    ) {
+      auto in = *(struct sockaddr_in *) addr;
+      auto in6 = (struct sockaddr_in6 *) addr;
+
+      memset((void *) addr, 0, sizeof(struct sockaddr_storage));
+      in6->sin6_family = AF_INET6;
+      in6->sin6_port = in.sin_port;
+      in6->sin6_addr.s6_addr[10] = 0xff;
+      in6->sin6_addr.s6_addr[11] = 0xff;
+      memcpy(&in6->sin6_addr.s6_addr[12], &in.sin_addr, sizeof(in.sin_addr));
+    }
+
+    return 0;
+  }
+
+  const struct sockaddr* Peer::getCachedAddress (
+    const String& address,
+    int port,
+    int *err
+  ) {
+    auto hash = std::hash<String>{}(address) ^ (size_t) port;
+    auto& entry = this->addressCache[hash % Peer::ADDRESS_CACHE_SIZE];
+
+    if (entry.port != port || entry.address != address) {
+      if ((*err = this->resolveAddress(address, port, &entry.addr))) {
+        entry.port = -1;
+        return nullptr;
+      }
+
+      entry.address = address;
+      entry.port = port;
+    }
+
+    *err = 0;
+    return (const struct sockaddr *) &entry.addr;
+  }
+
   void Peer::send (
     char *buf,
     size_t size,
@@ -431,11 +976,12 @@ namespace SSC {
     Lock lock(this->mutex);
     int err = 0;
 
-    struct sockaddr *sockaddr = nullptr;
+    const struct sockaddr *sockaddr = nullptr;
 
+    // `uv_udp_send()` copies the destination, so the cache entry may be
+    // reused by the next send
     if (!this->isConnected()) {
-      sockaddr = (struct sockaddr *) &this->addr;
-      err = uv_ip4_addr((char *) address.c_str(), port, &this->addr);
+      sockaddr = this->getCachedAddress(address, port, &err);
 
       if (err) {
         return cb(err, Post{});
@@ -456,7 +1002,7 @@ namespace SSC {
       ctx->cb(status, Post{});
 
       if (peer->isEphemeral()) {
-        peer->close();
+        peer->release();
       }
 
       delete ctx;
@@ -467,7 +1013,7 @@ namespace SSC {
       ctx->cb(err, Post{});
 
       if (this->isEphemeral()) {
-        this->close();
+        this->release();
       }
 
       delete ctx;
@@ -475,50 +1021,226 @@ namespace SSC {
     }
   }
 
-  int Peer::recvstart () {
-    if (this->receiveCallback != nullptr) {
-      return this->recvstart(this->receiveCallback);
-    }
-
-    return UV_EINVAL;
-  }
-
-  int Peer::recvstart (Peer::UDPReceiveCallback receiveCallback) {
+  void Peer::sendSegments (
+    char *buf,
+    size_t size,
+    size_t segmentSize,
+    int port,
+    const String address,
+    Peer::RequestContext::Callback cb
+  ) {
     Lock lock(this->mutex);
+    const struct sockaddr *sockaddr = nullptr;
+    size_t offset = 0;
+    int err = 0;
 
-    if (this->hasState(PEER_STATE_UDP_RECV_STARTED)) {
-      return UV_EALREADY;
+    if (segmentSize == 0 || size <= segmentSize) {
+      return this->send(buf, size, port, address, cb);
     }
 
-    this->addState(PEER_STATE_UDP_RECV_STARTED);
-    this->receiveCallback = receiveCallback;
+    if (!this->isConnected()) {
+      sockaddr = this->getCachedAddress(address, port, &err);
 
-    auto allocate = [](uv_handle_t *handle, size_t size, uv_buf_t *buf) {
-      if (size > 0) {
-        buf->base = (char *) new char[size]{0};
-        buf->len = size;
+      if (err) {
+        return cb(err, Post{});
       }
-    };
+    }
 
-    auto receive = [](
-      uv_udp_t *handle,
-      ssize_t nread,
-      const uv_buf_t *buf,
-      const struct sockaddr *addr,
-      unsigned flags
+    #if defined(__linux__)
+    uv_os_fd_t fd;
+
+    // writing to the socket directly is only ordered with respect to earlier
+    // sends when nothing is queued in libuv
+    if (
+      !this->segmentationUnsupported &&
+      segmentSize <= Peer::UDP_MAX_SEGMENTED_PAYLOAD &&
+      this->handle.udp.send_queue_count == 0 &&
+      uv_fileno((uv_handle_t *) &this->handle, &fd) == 0
     ) {
-      auto peer = (Peer *) handle->data;
+      auto segments = std::min(
+        Peer::UDP_MAX_SEGMENTS,
+        Peer::UDP_MAX_SEGMENTED_PAYLOAD / segmentSize
+      );
+
+      auto gso = (uint16_t) segmentSize;
+      char control[CMSG_SPACE(sizeof(uint16_t))] = {0};
+
+      while (offset < size) {
+        auto length = std::min(segments * segmentSize, size - offset);
+        struct iovec iov = { buf + offset, length };
+        struct msghdr message = {};
+        ssize_t written = 0;
+
+        if (sockaddr != nullptr) {
+          message.msg_name = (void *) sockaddr;
+          message.msg_namelen = sockaddr->sa_family == AF_INET6
+            ? sizeof(struct sockaddr_in6)
+            : sizeof(struct sockaddr_in);
+        }
 
-      if (nread == UV_ENOTCONN) {
-        peer->recvstop();
-        return;
-      }
+        message.msg_iov = &iov;
+        message.msg_iovlen = 1;
 
-      peer->receiveCallback(nread, buf, addr);
-    };
+        if (length > segmentSize) {
+          message.msg_control = control;
+          message.msg_controllen = sizeof(control);
 
-    return uv_udp_recv_start((uv_udp_t *) &this->handle, allocate, receive);
-  }
+          auto cmsg = CMSG_FIRSTHDR(&message);
+          cmsg->cmsg_level = IPPROTO_UDP;
+          cmsg->cmsg_type = UDP_SEGMENT;
+          cmsg->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+          memcpy(CMSG_DATA(cmsg), &gso, sizeof(gso));
+        }
+
+        do {
+          written = sendmsg(fd, &message, 0);
+        } while (written < 0 && errno == EINTR);
+
+        if (written < 0) {
+          // kernels without `UDP_SEGMENT` fail with `EINVAL` or `ENOPROTOOPT`
+          // and routes without checksum offload with `EIO`. anything else,
+          // like `EAGAIN`, leaves the rest to libuv which reports real errors
+          if (errno == EINVAL || errno == ENOPROTOOPT || errno == EIO) {
+            this->segmentationUnsupported = true;
+          }
+
+          break;
+        }
+
+        offset += length;
+      }
+    }
+    #endif
+
+    if (offset == size) {
+      cb(0, Post{});
+
+      if (this->isEphemeral()) {
+        this->release();
+      }
+
+      return;
+    }
+
+    // the IPC message buffer is released once the route returns, so
+    // datagrams queued in libuv need their own copy
+    auto ctx = new SegmentedSendContext;
+    ctx->cb = cb;
+    ctx->peer = this;
+    ctx->bytes = new char[size - offset];
+    memcpy(ctx->bytes, buf + offset, size - offset);
+
+    for (size_t i = 0; offset + i < size; i += segmentSize) {
+      auto length = std::min(segmentSize, size - offset - i);
+      auto buffer = uv_buf_init(ctx->bytes + i, (unsigned int) length);
+      auto req = new uv_udp_send_t;
+
+      req->data = (void *) ctx;
+      ctx->pending++;
+
+      err = uv_udp_send(req, (uv_udp_t *) &this->handle, &buffer, 1, sockaddr, [](uv_udp_send_t *req, int status) {
+        auto ctx = reinterpret_cast<SegmentedSendContext*>(req->data);
+
+        if (status < 0 && ctx->status == 0) {
+          ctx->status = status;
+        }
+
+        delete req;
+
+        if (--ctx->pending == 0) {
+          auto peer = ctx->peer;
+
+          ctx->cb(ctx->status, Post{});
+
+          if (peer->isEphemeral()) {
+            peer->release();
+          }
+
+          delete [] ctx->bytes;
+          delete ctx;
+        }
+      });
+
+      if (err < 0) {
+        ctx->pending--;
+        ctx->status = err;
+        delete req;
+        break;
+      }
+    }
+
+    // nothing was queued, so no send callback will finish the context
+    if (ctx->pending == 0) {
+      cb(ctx->status, Post{});
+
+      if (this->isEphemeral()) {
+        this->release();
+      }
+
+      delete [] ctx->bytes;
+      delete ctx;
+    }
+  }
+
+  int Peer::recvstart () {
+    if (this->receiveCallback != nullptr) {
+      return this->recvstart(this->receiveCallback);
+    }
+
+    return UV_EINVAL;
+  }
+
+  int Peer::recvstart (Peer::UDPReceiveCallback receiveCallback) {
+    Lock lock(this->mutex);
+
+    if (this->hasState(PEER_STATE_UDP_RECV_STARTED)) {
+      return UV_EALREADY;
+    }
+
+    this->addState(PEER_STATE_UDP_RECV_STARTED);
+    this->receiveCallback = receiveCallback;
+
+    auto allocate = [](uv_handle_t *handle, size_t size, uv_buf_t *buf) {
+      if (size > 0) {
+        buf->base = (char *) new char[size]{0};
+        buf->len = size;
+      }
+    };
+
+    auto receive = [](
+      uv_udp_t *handle,
+      ssize_t nread,
+      const uv_buf_t *buf,
+      const struct sockaddr *addr,
+      unsigned flags
+    ) {
+      auto peer = (Peer *) handle->data;
+
+      if (nread == UV_ENOTCONN) {
+        peer->recvstop();
+        return;
+      }
+
+      if (nread > 0) {
+        observeKeepalive(peer, addr);
+      }
+
+      if (peer->receiveFilter != nullptr && peer->receiveFilter(nread, buf, addr)) {
+        return;
+      }
+
+      peer->receiveCallback(nread, buf, addr);
+    };
+
+    #if defined(__linux__)
+    // falls back to `uv_udp_recv_start()` where `UDP_GRO` is unavailable
+    if (this->options.udp.gro && startReceiveOffload(this) == 0) {
+      return 0;
+    }
+    #endif
+
+    return uv_udp_recv_start((uv_udp_t *) &this->handle, allocate, receive);
+  }
 
   int Peer::recvstop () {
     int err = 0;
@@ -526,15 +1248,305 @@ namespace SSC {
     if (this->hasState(PEER_STATE_UDP_RECV_STARTED)) {
       this->removeState(PEER_STATE_UDP_RECV_STARTED);
       Lock lock(this->core->loopMutex);
+
+      #if defined(__linux__)
+      if (this->receiveOffload != nullptr) {
+        stopReceiveOffload(this);
+        return 0;
+      }
+      #endif
+
       err = uv_udp_recv_stop((uv_udp_t *) &this->handle);
     }
 
     return err;
   }
 
+  int Peer::listen (int backlog, Peer::TCPConnectionCallback onconnection) {
+    Lock lock(this->mutex);
+    int err = 0;
+
+    if (!this->isTCP() || !this->isBound()) {
+      return UV_EINVAL;
+    }
+
+    this->connectionCallback = onconnection;
+
+    err = uv_listen((uv_stream_t *) &this->handle, backlog, [](uv_stream_t *stream, int status) {
+      auto server = (Peer *) stream->data;
+
+      if (status < 0) {
+        return server->connectionCallback(nullptr, status);
+      }
+
+      auto client = server->core->createPeer(PEER_TYPE_TCP, rand64());
+      auto err = uv_accept(stream, (uv_stream_t *) &client->handle);
+
+      if (err < 0) {
+        client->close();
+        return server->connectionCallback(nullptr, err);
+      }
+
+      client->options.tcp = server->options.tcp;
+      client->addState(PEER_STATE_TCP_CONNECTED);
+      client->setNoDelay(client->options.tcp.noDelay);
+      client->setKeepAlive(client->options.tcp.keepAlive, client->options.tcp.keepAliveDelay);
+      client->initLocalPeerInfo();
+      client->initRemotePeerInfo();
+
+      server->connectionCallback(client, 0);
+    });
+
+    if (err < 0) {
+      return err;
+    }
+
+    this->addState(PEER_STATE_TCP_LISTENING);
+    return err;
+  }
+
+  void Peer::connect (
+    const String address,
+    int port,
+    Peer::RequestContext::Callback cb
+  ) {
+    Lock lock(this->mutex);
+    auto sockaddr = (struct sockaddr*) &this->addr;
+    int err = 0;
+
+    if (!this->isTCP()) {
+      return cb(UV_EINVAL, Post{});
+    }
+
+    if ((err = this->resolveAddress(address, port, &this->addr))) {
+      return cb(err, Post{});
+    }
+
+    auto ctx = new Peer::RequestContext(cb);
+    auto req = new uv_connect_t;
+
+    req->data = (void *) ctx;
+    ctx->peer = this;
+
+    err = uv_tcp_connect(req, (uv_tcp_t *) &this->handle, sockaddr, [](uv_connect_t *req, int status) {
+      auto ctx = reinterpret_cast<Peer::RequestContext*>(req->data);
+      auto peer = ctx->peer;
+
+      if (status == 0) {
+        peer->addState(PEER_STATE_TCP_CONNECTED);
+        peer->setNoDelay(peer->options.tcp.noDelay);
+        peer->setKeepAlive(peer->options.tcp.keepAlive, peer->options.tcp.keepAliveDelay);
+        peer->initLocalPeerInfo();
+        peer->initRemotePeerInfo();
+      }
+
+      ctx->cb(status, Post{});
+
+      delete ctx;
+      delete req;
+    });
+
+    if (err < 0) {
+      ctx->cb(err, Post{});
+      delete ctx;
+      delete req;
+    }
+  }
+
+  int Peer::readstart () {
+    if (this->readCallback != nullptr) {
+      return this->readstart(this->readCallback);
+    }
+
+    return UV_EINVAL;
+  }
+
+  int Peer::readstart (Peer::TCPReadCallback readCallback) {
+    Lock lock(this->mutex);
+
+    if (this->hasState(PEER_STATE_TCP_READ_STARTED)) {
+      return UV_EALREADY;
+    }
+
+    this->addState(PEER_STATE_TCP_READ_STARTED);
+    this->readCallback = readCallback;
+
+    auto allocate = [](uv_handle_t *handle, size_t size, uv_buf_t *buf) {
+      auto peer = (Peer *) handle->data;
+      buf->base = peer->core->tcp.acquireReadBuffer();
+      buf->len = Core::TCP::READ_BUFFER_SIZE;
+    };
+
+    auto read = [](uv_stream_t *stream, ssize_t nread, const uv_buf_t *buf) {
+      auto peer = (Peer *) stream->data;
+
+      if (nread < 0) {
+        peer->readstop();
+      }
+
+      auto data = *buf;
+
+      if (nread != 0) {
+        peer->readCallback(nread, &data);
+      }
+
+      peer->core->tcp.releaseReadBuffer(data.base);
+    };
+
+    auto err = uv_read_start((uv_stream_t *) &this->handle, allocate, read);
+
+    if (err < 0) {
+      this->removeState(PEER_STATE_TCP_READ_STARTED);
+    }
+
+    return err;
+  }
+
+  int Peer::readstop () {
+    int err = 0;
+
+    if (this->hasState(PEER_STATE_TCP_READ_STARTED)) {
+      this->removeState(PEER_STATE_TCP_READ_STARTED);
+      Lock lock(this->core->loopMutex);
+      err = uv_read_stop((uv_stream_t *) &this->handle);
+    }
+
+    return err;
+  }
+
+  struct PeerWriteRequest {
+    uv_write_t req;
+    Vector<String> chunks;
+    Peer::RequestContext *ctx;
+  };
+
+  int Peer::write (Vector<String> chunks, Peer::RequestContext::Callback cb) {
+    Lock lock(this->mutex);
+
+    if (!this->isTCP() || !this->isConnected()) {
+      return UV_ENOTCONN;
+    }
+
+    // `uv_write()` asserts that it is given at least one buffer
+    if (chunks.size() == 0) {
+      return UV_EINVAL;
+    }
+
+    auto request = new PeerWriteRequest;
+    Vector<uv_buf_t> buffers;
+
+    request->chunks = std::move(chunks);
+    request->ctx = new Peer::RequestContext(cb);
+    request->ctx->peer = this;
+    request->req.data = (void *) request;
+
+    buffers.reserve(request->chunks.size());
+
+    for (auto& chunk : request->chunks) {
+      buffers.push_back(uv_buf_init(chunk.data(), (unsigned int) chunk.size()));
+    }
+
+    auto err = uv_write(
+      &request->req,
+      (uv_stream_t *) &this->handle,
+      buffers.data(),
+      (unsigned int) buffers.size(),
+      [](uv_write_t *req, int status) {
+        auto request = (PeerWriteRequest *) req->data;
+        request->ctx->cb(status, Post{});
+        delete request->ctx;
+        delete request;
+      }
+    );
+
+    if (err < 0) {
+      delete request->ctx;
+      delete request;
+    }
+
+    return err;
+  }
+
+  void Peer::shutdown (Peer::RequestContext::Callback cb) {
+    Lock lock(this->mutex);
+
+    if (!this->isTCP() || !this->isConnected()) {
+      return cb(UV_ENOTCONN, Post{});
+    }
+
+    auto ctx = new Peer::RequestContext(cb);
+    auto req = new uv_shutdown_t;
+
+    req->data = (void *) ctx;
+    ctx->peer = this;
+
+    auto err = uv_shutdown(req, (uv_stream_t *) &this->handle, [](uv_shutdown_t *req, int status) {
+      auto ctx = reinterpret_cast<Peer::RequestContext*>(req->data);
+
+      if (status == 0) {
+        ctx->peer->addState(PEER_STATE_TCP_SHUTDOWN);
+      }
+
+      ctx->cb(status, Post{});
+      delete ctx;
+      delete req;
+    });
+
+    if (err < 0) {
+      ctx->cb(err, Post{});
+      delete ctx;
+      delete req;
+    }
+  }
+
+  int Peer::setNoDelay (bool enable) {
+    Lock lock(this->mutex);
+    this->options.tcp.noDelay = enable;
+
+    if (!this->isConnected()) {
+      return 0;
+    }
+
+    return uv_tcp_nodelay((uv_tcp_t *) &this->handle, enable ? 1 : 0);
+  }
+
+  int Peer::setKeepAlive (bool enable, unsigned int delay) {
+    Lock lock(this->mutex);
+    this->options.tcp.keepAlive = enable;
+    this->options.tcp.keepAliveDelay = delay;
+
+    if (!this->isConnected()) {
+      return 0;
+    }
+
+    return uv_tcp_keepalive((uv_tcp_t *) &this->handle, enable ? 1 : 0, delay);
+  }
+
+  size_t Peer::getWriteQueueSize () {
+    Lock lock(this->mutex);
+
+    if (!this->isTCP()) {
+      return 0;
+    }
+
+    return uv_stream_get_write_queue_size((const uv_stream_t *) &this->handle);
+  }
+
   int Peer::resume () {
     int err = 0;
 
+    // TCP streams cannot be rebound transparently, reading is resumed instead
+    if (this->isTCP()) {
+      if (this->isPaused()) {
+        this->removeState(PEER_STATE_TCP_PAUSED);
+        if (this->readCallback != nullptr) {
+          err = this->readstart(this->readCallback);
+        }
+      }
+
+      return err;
+    }
+
     if (this->isPaused()) {
       if ((err = this->init())) {
         return err;
@@ -557,6 +1569,15 @@ namespace SSC {
   int Peer::pause () {
     int err = 0;
 
+    if (this->isTCP()) {
+      if (!this->isPaused() && this->hasState(PEER_STATE_TCP_READ_STARTED)) {
+        err = this->readstop();
+        this->addState(PEER_STATE_TCP_PAUSED);
+      }
+
+      return err;
+    }
+
     if ((err = this->recvstop())) {
       return err;
     }
@@ -574,6 +1595,142 @@ namespace SSC {
     return err;
   }
 
+  void Peer::release () {
+    if (!this->isEphemeral()) {
+      return;
+    }
+
+    // the last in flight send on this handle releases it
+    if (this->isUDP() && this->handle.udp.send_queue_count > 0) {
+      return;
+    }
+
+    if (
+      !this->isUDP() ||
+      this->isBound() ||
+      this->isConnected() ||
+      this->isClosing() ||
+      this->isClosed() ||
+      this->hasState(PEER_STATE_UDP_RECV_STARTED) ||
+      this->keepalive != nullptr ||
+      !this->core->peers.release(this)
+    ) {
+      this->close();
+    }
+  }
+
+  int Peer::addKeepaliveTargets (
+    const Vector<Peer::KeepaliveTarget>& targets,
+    const String& payload,
+    Peer::KeepaliveCallback onchange
+  ) {
+    Vector<struct sockaddr_storage> addresses;
+    auto loop = this->core->getEventLoop();
+    int err = 0;
+
+    if (!this->isUDP()) {
+      return UV_EINVAL;
+    }
+
+    // resolved up front so an invalid address rejects the whole batch
+    for (const auto& target : targets) {
+      struct sockaddr_storage addr;
+
+      if ((err = this->resolveAddress(target.address, target.port, &addr))) {
+        return err;
+      }
+
+      addresses.push_back(addr);
+    }
+
+    if (this->keepalive == nullptr) {
+      auto keepalive = new Peer::Keepalive;
+
+      if ((err = uv_timer_init(loop, &keepalive->timer))) {
+        delete keepalive;
+        return err;
+      }
+
+      keepalive->peer = this;
+      keepalive->timer.data = (void *) keepalive;
+      this->keepalive = keepalive;
+    }
+
+    auto now = uv_now(loop);
+
+    this->keepalive->payload = payload;
+    this->keepalive->onchange = onchange;
+
+    for (size_t i = 0; i < targets.size(); ++i) {
+      auto key = getKeepaliveKey((const struct sockaddr *) &addresses[i]);
+      auto existing = this->keepalive->entries.find(key);
+      auto target = targets[i];
+
+      if (existing != this->keepalive->entries.end()) {
+        auto& entry = existing->second;
+
+        target.reachable = entry.target.reachable;
+        target.lastSeen = entry.target.lastSeen;
+        target.sent = entry.target.sent;
+        target.received = entry.target.received;
+
+        entry.target = target;
+        entry.deadline = std::min(entry.deadline, now + target.interval);
+        continue;
+      }
+
+      // new targets are punched right away
+      target.reachable = false;
+      target.lastSeen = 0;
+      target.sent = 0;
+      target.received = 0;
+
+      this->keepalive->entries[key] = Peer::Keepalive::Entry {
+        target,
+        addresses[i],
+        now,
+        0
+      };
+    }
+
+    scheduleKeepalive(this->keepalive);
+    return 0;
+  }
+
+  int Peer::removeKeepaliveTargets (const Vector<Peer::KeepaliveTarget>& targets) {
+    if (this->keepalive == nullptr) {
+      return 0;
+    }
+
+    for (const auto& target : targets) {
+      struct sockaddr_storage addr;
+
+      if (this->resolveAddress(target.address, target.port, &addr) == 0) {
+        this->keepalive->entries.erase(getKeepaliveKey((const struct sockaddr *) &addr));
+      }
+    }
+
+    if (targets.size() == 0 || this->keepalive->entries.size() == 0) {
+      stopKeepalive(this);
+      return 0;
+    }
+
+    scheduleKeepalive(this->keepalive);
+    return (int) this->keepalive->entries.size();
+  }
+
+  Vector<Peer::KeepaliveTarget> Peer::getKeepaliveTargets () {
+    Vector<Peer::KeepaliveTarget> targets;
+
+    if (this->keepalive != nullptr) {
+      for (const auto& tuple : this->keepalive->entries) {
+        targets.push_back(tuple.second.target);
+      }
+    }
+
+    return targets;
+  }
+
   void Peer::close () {
     return this->close(nullptr);
   }
@@ -594,8 +1751,15 @@ namespace SSC {
       return;
     }
 
-    if (this->type == PEER_TYPE_UDP) {
+    if (this->type == PEER_TYPE_UDP || this->type == PEER_TYPE_TCP) {
       Lock lock(this->mutex);
+
+      stopKeepalive(this);
+
+      #if defined(__linux__)
+      stopReceiveOffload(this);
+      #endif
+
       // reset state and set to CLOSED
       uv_close((uv_handle_t*) &this->handle, [](uv_handle_t *handle) {
         auto peer = (Peer *) handle->data;
@@ -603,7 +1767,11 @@ namespace SSC {
           peer->removeState((peer_state_t) (
             PEER_STATE_UDP_BOUND |
             PEER_STATE_UDP_CONNECTED |
-            PEER_STATE_UDP_RECV_STARTED
+            PEER_STATE_UDP_RECV_STARTED |
+            PEER_STATE_TCP_BOUND |
+            PEER_STATE_TCP_CONNECTED |
+            PEER_STATE_TCP_READ_STARTED |
+            PEER_STATE_TCP_LISTENING
           ));
 
           for (const auto &onclose : peer->onclose) {
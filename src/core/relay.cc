@@ -0,0 +1,885 @@
+#include "core.hh"
+#include <cstring>
+#include <random>
+
+namespace SSC {
+  static JSON::Object::Entries ERR_RELAY_NOT_RUNNING (
+    const String& source,
+    uint64_t id
+  ) {
+    return JSON::Object::Entries {
+      {"source", source},
+      {"err", JSON::Object::Entries {
+        {"id", std::to_string(id)},
+        {"type", "NotFoundError"},
+        {"code", "ERR_RELAY_NOT_RUNNING"},
+        {"message", "No relay is running on the socket"}
+      }}
+    };
+  }
+
+  static uint32_t readUInt32BE (const char* bytes) {
+    auto b = (const unsigned char*) bytes;
+    return (uint32_t) b[0] << 24 | (uint32_t) b[1] << 16 | (uint32_t) b[2] << 8 | b[3];
+  }
+
+  static void writeUInt32BE (char* bytes, uint32_t value) {
+    bytes[0] = (char) (value >> 24);
+    bytes[1] = (char) (value >> 16);
+    bytes[2] = (char) (value >> 8);
+    bytes[3] = (char) value;
+  }
+
+  // identifiers are hex encoded like the JavaScript packet decoder, where
+  // an identifier of all zero bytes is the empty string
+  static String toHex (const char* bytes, size_t size) {
+    static const char digits[] = "0123456789abcdef";
+    String output;
+
+    if (std::all_of(bytes, bytes + size, [](char c) { return c == 0; })) {
+      return output;
+    }
+
+    output.reserve(size * 2);
+
+    for (size_t i = 0; i < size; ++i) {
+      auto c = (unsigned char) bytes[i];
+      output += digits[c >> 4];
+      output += digits[c & 0xf];
+    }
+
+    return output;
+  }
+
+  bool Core::Relay::Packet::decode (const char* bytes, size_t size, Packet& packet) {
+    if (bytes == nullptr || size < FRAME_SIZE) {
+      return false;
+    }
+
+    // the first two bytes are a known packet type and the protocol version
+    if (bytes[0] < 1 || bytes[0] > 8 || bytes[1] != VERSION) {
+      return false;
+    }
+
+    size_t offset = 0;
+
+    packet.type = (uint8_t) bytes[offset]; offset += 1;
+    packet.version = (uint8_t) bytes[offset]; offset += 1;
+    packet.hops = readUInt32BE(bytes + offset); offset += 4;
+    packet.clock = readUInt32BE(bytes + offset); offset += 4;
+    packet.index = (int32_t) readUInt32BE(bytes + offset); offset += 4;
+
+    packet.packetId = toHex(bytes + offset, ID_SIZE); offset += ID_SIZE;
+    packet.clusterId = toHex(bytes + offset, ID_SIZE); offset += ID_SIZE;
+    packet.previousId = toHex(bytes + offset, ID_SIZE); offset += ID_SIZE;
+    packet.nextId = toHex(bytes + offset, ID_SIZE); offset += ID_SIZE;
+    packet.to = String(bytes + offset, ID_SIZE); offset += ID_SIZE;
+
+    auto usr1 = bytes + offset;
+    packet.usr1 = String(usr1, strnlen(usr1, ID_SIZE)); offset += ID_SIZE;
+
+    auto length = (size_t) ((unsigned char) bytes[offset] << 8 | (unsigned char) bytes[offset + 1]);
+    offset += 2;
+
+    length = std::min(length, std::min(MESSAGE_SIZE, size - offset));
+    packet.message = String(bytes + offset, length);
+
+    return true;
+  }
+
+  bool Core::Relay::Cache::insert (
+    const Packet& packet,
+    const char* bytes,
+    size_t size,
+    uint64_t now
+  ) {
+    this->expire(now);
+
+    if (packet.packetId.size() == 0) {
+      return true;
+    }
+
+    if (this->entries.contains(packet.packetId)) {
+      return false;
+    }
+
+    if (this->entries.size() >= this->maxSize && this->order.size() > 0) {
+      this->remove(this->order.front());
+    }
+
+    auto& entry = this->entries[packet.packetId];
+
+    entry.packetId = packet.packetId;
+    entry.clusterId = packet.clusterId;
+    entry.previousId = packet.previousId;
+    entry.index = packet.index;
+    entry.bytes = String(bytes, size);
+    entry.timestamp = now;
+    entry.position = this->order.insert(this->order.end(), packet.packetId);
+
+    this->clusters[entry.clusterId].insert(entry.packetId);
+
+    if (entry.previousId.size() > 0) {
+      this->children[entry.previousId].insert(entry.packetId);
+    }
+
+    return true;
+  }
+
+  bool Core::Relay::Cache::has (const String& packetId) const {
+    return this->entries.contains(packetId);
+  }
+
+  const Core::Relay::Cache::Entry* Core::Relay::Cache::get (const String& packetId) const {
+    auto it = this->entries.find(packetId);
+    return it != this->entries.end() ? &it->second : nullptr;
+  }
+
+  void Core::Relay::Cache::remove (const String& packetId) {
+    auto it = this->entries.find(packetId);
+
+    if (it == this->entries.end()) {
+      return;
+    }
+
+    auto& entry = it->second;
+    auto cluster = this->clusters.find(entry.clusterId);
+
+    if (cluster != this->clusters.end()) {
+      cluster->second.erase(packetId);
+      if (cluster->second.size() == 0) {
+        this->clusters.erase(cluster);
+      }
+    }
+
+    auto siblings = this->children.find(entry.previousId);
+
+    if (siblings != this->children.end()) {
+      siblings->second.erase(packetId);
+      if (siblings->second.size() == 0) {
+        this->children.erase(siblings);
+      }
+    }
+
+    this->order.erase(entry.position);
+    this->entries.erase(it);
+  }
+
+  void Core::Relay::Cache::expire (uint64_t now) {
+    // entries are in insertion order, so expired entries are at the front
+    while (this->order.size() > 0) {
+      auto entry = this->get(this->order.front());
+
+      if (entry->timestamp + this->timeout > now) {
+        break;
+      }
+
+      this->remove(entry->packetId);
+      this->expired++;
+    }
+  }
+
+  size_t Core::Relay::Cache::size () const {
+    return this->entries.size();
+  }
+
+  size_t Core::Relay::Cache::size (const String& clusterId) const {
+    auto it = this->clusters.find(clusterId);
+    return it != this->clusters.end() ? it->second.size() : 0;
+  }
+
+  // Reads the fragment count from the `{"indexes": n}` message of the head
+  // of a split publish, or returns 0 when `message` does not have one.
+  static int32_t getRelayPacketIndexes (const String& message) {
+    auto position = message.find("\"indexes\"");
+
+    if (position == String::npos) {
+      return 0;
+    }
+
+    position = message.find_first_not_of(" \t\r\n:", position + 9);
+
+    if (position == String::npos || !std::isdigit((unsigned char) message[position])) {
+      return 0;
+    }
+
+    int64_t indexes = 0;
+    while (position < message.size() && std::isdigit((unsigned char) message[position])) {
+      indexes = indexes * 10 + (message[position++] - '0');
+      if (indexes > INT32_MAX) return 0;
+    }
+
+    return (int32_t) indexes;
+  }
+
+  // Collects the fragments of the split publish `packetId` belongs to (the
+  // direct children of its head with an index in `1..indexes`) ordered by
+  // index. Returns nothing until every fragment is cached. Later publishes
+  // chained off the head or a fragment are not part of the message.
+  Vector<const Core::Relay::Cache::Entry*> Core::Relay::Cache::compose (
+    const String& packetId
+  ) const {
+    Vector<const Entry*> chain;
+    auto head = this->get(packetId);
+
+    if (head != nullptr && head->index > 0) {
+      head = this->get(head->previousId);
+    }
+
+    if (head == nullptr) {
+      return chain;
+    }
+
+    Packet packet;
+    if (!Packet::decode(head->bytes.data(), head->bytes.size(), packet)) {
+      return chain;
+    }
+
+    auto indexes = getRelayPacketIndexes(packet.message);
+    auto it = this->children.find(head->packetId);
+
+    if (indexes == 0 || it == this->children.end()) {
+      return chain;
+    }
+
+    chain.resize(indexes, nullptr);
+
+    for (const auto& childId : it->second) {
+      auto child = this->get(childId);
+
+      if (child != nullptr && child->index > 0 && child->index <= indexes) {
+        chain[child->index - 1] = child;
+      }
+    }
+
+    if (std::find(chain.begin(), chain.end(), nullptr) != chain.end()) {
+      chain.clear();
+    }
+
+    return chain;
+  }
+
+  // Layout (integers are little endian):
+  //   header: magic (8 bytes), version (u32), entry count (u32)
+  //   entries: age in milliseconds (u64), size (u32), packet bytes
+  bool Core::Relay::Cache::snapshot (const Path& path, uint64_t now) const {
+    std::error_code ec;
+    String output(MAGIC, sizeof(MAGIC));
+
+    putUInt(output, VERSION, 4);
+    putUInt(output, this->entries.size(), 4);
+
+    for (const auto& packetId : this->order) {
+      auto entry = this->get(packetId);
+      putUInt(output, now > entry->timestamp ? now - entry->timestamp : 0, 8);
+      putUInt(output, entry->bytes.size(), 4);
+      output += entry->bytes;
+    }
+
+    auto temporary = Path(path.string() + ".tmp");
+    std::ofstream stream(temporary, std::ios::binary | std::ios::trunc);
+
+    if (!stream.is_open()) {
+      return false;
+    }
+
+    stream.write(output.data(), output.size());
+    stream.close();
+
+    if (!stream) {
+      fs::remove(temporary, ec);
+      return false;
+    }
+
+    fs::rename(temporary, path, ec);
+    return !ec;
+  }
+
+  // Returns the number of restored packets or -1 if `path` is not a snapshot
+  int Core::Relay::Cache::restore (const Path& path, uint64_t now) {
+    std::ifstream stream(path, std::ios::binary);
+    std::stringstream buffer;
+
+    if (!stream.is_open()) {
+      return -1;
+    }
+
+    buffer << stream.rdbuf();
+
+    auto input = buffer.str();
+    auto bytes = input.data();
+    size_t offset = sizeof(MAGIC) + 8;
+    int restored = 0;
+
+    if (
+      input.size() < offset ||
+      memcmp(bytes, MAGIC, sizeof(MAGIC)) != 0 ||
+      getUInt(bytes + sizeof(MAGIC), 4) != VERSION
+    ) {
+      return -1;
+    }
+
+    auto count = getUInt(bytes + sizeof(MAGIC) + 4, 4);
+
+    for (uint64_t i = 0; i < count && offset + 12 <= input.size(); ++i) {
+      auto age = getUInt(bytes + offset, 8);
+      auto size = getUInt(bytes + offset + 8, 4);
+      offset += 12;
+
+      if (offset + size > input.size()) {
+        break;
+      }
+
+      Packet packet;
+
+      if (
+        age < this->timeout &&
+        Packet::decode(bytes + offset, size, packet) &&
+        this->insert(packet, bytes + offset, size, now > age ? now - age : 0)
+      ) {
+        restored++;
+      }
+
+      offset += size;
+    }
+
+    return restored;
+  }
+
+  void Core::Relay::State::forward (
+    Peer* peer,
+    const char* bytes,
+    size_t size,
+    uint32_t hops,
+    const String& from,
+    uint64_t now
+  ) {
+    Vector<RemotePeer> candidates;
+
+    for (auto it = this->peers.begin(); it != this->peers.end();) {
+      if (it->second.lastSeen + this->options.peerTimeout < now) {
+        it = this->peers.erase(it);
+        continue;
+      }
+
+      if (it->first != from) {
+        candidates.push_back(it->second);
+      }
+
+      ++it;
+    }
+
+    std::shuffle(candidates.begin(), candidates.end(), std::mt19937_64(rand64()));
+
+    if (candidates.size() > this->options.fanout) {
+      candidates.resize(this->options.fanout);
+    }
+
+    for (const auto& candidate : candidates) {
+      auto data = new char[size]{0};
+      memcpy(data, bytes, size);
+      writeUInt32BE(data + HOPS_OFFSET, hops);
+
+      peer->send(data, size, candidate.port, candidate.address, [data](auto status, auto post) {
+        delete [] data;
+      });
+
+      this->stats.forwarded++;
+    }
+  }
+
+  bool Core::Relay::State::receive (
+    Peer* peer,
+    ssize_t nread,
+    const uv_buf_t* buf,
+    const struct sockaddr* addr
+  ) {
+    Packet packet;
+
+    // anything that is not a relay frame is left to the socket's listeners
+    if (nread <= 0 || addr == nullptr || !Packet::decode(buf->base, nread, packet)) {
+      return false;
+    }
+
+    char address[INET6_ADDRSTRLEN] = {0};
+    int port;
+
+    parseAddress((struct sockaddr *) addr, &port, address);
+
+    auto now = uv_now(peer->core->getEventLoop());
+    auto from = String(address) + ":" + std::to_string(port);
+    auto& remote = this->peers[from];
+
+    remote.address = address;
+    remote.port = port;
+    remote.lastSeen = now;
+
+    this->stats.received++;
+
+    // pings, intros, joins and queries drive the JavaScript peer state
+    if (packet.type != PACKET_TYPE_PUBLISH) {
+      this->stats.delivered++;
+      return false;
+    }
+
+    if (!this->cache.insert(packet, buf->base, nread, now)) {
+      this->stats.duplicates++;
+      delete [] buf->base;
+      return true;
+    }
+
+    if (this->clusters.contains(packet.clusterId)) {
+      this->stats.delivered++;
+      return false;
+    }
+
+    // same accounting as `onPub()` followed by a taxed `mcast()`, one hop
+    // for receiving the packet and one for sending it on
+    auto hops = packet.hops + 1;
+
+    if (hops <= this->options.maxHops) {
+      this->forward(peer, buf->base, nread, hops + 1, from, now);
+    }
+
+    delete [] buf->base;
+    return true;
+  }
+
+  void Core::Relay::start (
+    const String seq,
+    uint64_t peerId,
+    StartOptions options,
+    Module::Callback cb
+  ) {
+    this->core->dispatchEventLoop([=, this]() {
+      if (!this->core->hasPeer(peerId) || !this->core->getPeer(peerId)->isUDP()) {
+        auto json = JSON::Object::Entries {
+          {"source", "relay.start"},
+          {"err", JSON::Object::Entries {
+            {"id", std::to_string(peerId)},
+            {"type", "InternalError"},
+            {"code", "ERR_SOCKET_DGRAM_NOT_RUNNING"},
+            {"message", "Not running"}
+          }}
+        };
+
+        return cb(seq, json, Post{});
+      }
+
+      auto peer = this->core->getPeer(peerId);
+      auto state = std::make_shared<State>();
+
+      state->id = peerId;
+      state->options = options;
+      state->cache.maxSize = options.cacheSize;
+      state->cache.timeout = options.cacheTimeout;
+      state->clusters.insert(options.clusters.begin(), options.clusters.end());
+
+      {
+        Lock lock(this->mutex);
+        this->states[peerId] = state;
+      }
+
+      peer->receiveFilter = [state, peer](auto nread, auto buf, auto addr) {
+        return state->receive(peer, nread, buf, addr);
+      };
+
+      peer->onclose.push_back([=, this]() {
+        Lock lock(this->mutex);
+        auto it = this->states.find(peerId);
+        if (it != this->states.end() && it->second == state) {
+          this->states.erase(it);
+        }
+      });
+
+      auto json = JSON::Object::Entries {
+        {"source", "relay.start"},
+        {"data", JSON::Object::Entries {
+          {"id", std::to_string(peerId)}
+        }}
+      };
+
+      cb(seq, json, Post{});
+    });
+  }
+
+  void Core::Relay::stop (const String seq, uint64_t peerId, Module::Callback cb) {
+    this->core->dispatchEventLoop([=, this]() {
+      {
+        Lock lock(this->mutex);
+        if (!this->states.contains(peerId)) {
+          return cb(seq, ERR_RELAY_NOT_RUNNING("relay.stop", peerId), Post{});
+        }
+
+        this->states.erase(peerId);
+      }
+
+      if (this->core->hasPeer(peerId)) {
+        this->core->getPeer(peerId)->receiveFilter = nullptr;
+      }
+
+      auto json = JSON::Object::Entries {
+        {"source", "relay.stop"},
+        {"data", JSON::Object::Entries {
+          {"id", std::to_string(peerId)}
+        }}
+      };
+
+      cb(seq, json, Post{});
+    });
+  }
+
+  void Core::Relay::subscribe (
+    const String seq,
+    uint64_t peerId,
+    const String clusterId,
+    Module::Callback cb
+  ) {
+    this->core->dispatchEventLoop([=, this]() {
+      Lock lock(this->mutex);
+
+      if (!this->states.contains(peerId)) {
+        return cb(seq, ERR_RELAY_NOT_RUNNING("relay.subscribe", peerId), Post{});
+      }
+
+      this->states[peerId]->clusters.insert(clusterId);
+
+      auto json = JSON::Object::Entries {
+        {"source", "relay.subscribe"},
+        {"data", JSON::Object::Entries {
+          {"id", std::to_string(peerId)},
+          {"clusterId", clusterId}
+        }}
+      };
+
+      cb(seq, json, Post{});
+    });
+  }
+
+  void Core::Relay::unsubscribe (
+    const String seq,
+    uint64_t peerId,
+    const String clusterId,
+    Module::Callback cb
+  ) {
+    this->core->dispatchEventLoop([=, this]() {
+      Lock lock(this->mutex);
+
+      if (!this->states.contains(peerId)) {
+        return cb(seq, ERR_RELAY_NOT_RUNNING("relay.unsubscribe", peerId), Post{});
+      }
+
+      this->states[peerId]->clusters.erase(clusterId);
+
+      auto json = JSON::Object::Entries {
+        {"source", "relay.unsubscribe"},
+        {"data", JSON::Object::Entries {
+          {"id", std::to_string(peerId)},
+          {"clusterId", clusterId}
+        }}
+      };
+
+      cb(seq, json, Post{});
+    });
+  }
+
+  void Core::Relay::addPeer (
+    const String seq,
+    uint64_t peerId,
+    const String address,
+    int port,
+    Module::Callback cb
+  ) {
+    this->core->dispatchEventLoop([=, this]() {
+      Lock lock(this->mutex);
+
+      if (!this->states.contains(peerId)) {
+        return cb(seq, ERR_RELAY_NOT_RUNNING("relay.addPeer", peerId), Post{});
+      }
+
+      auto now = uv_now(this->core->getEventLoop());
+      auto& remote = this->states[peerId]->peers[address + ":" + std::to_string(port)];
+
+      remote.address = address;
+      remote.port = port;
+      remote.lastSeen = now;
+
+      auto json = JSON::Object::Entries {
+        {"source", "relay.addPeer"},
+        {"data", JSON::Object::Entries {
+          {"id", std::to_string(peerId)},
+          {"address", address},
+          {"port", port}
+        }}
+      };
+
+      cb(seq, json, Post{});
+    });
+  }
+
+  void Core::Relay::getState (const String seq, uint64_t peerId, Module::Callback cb) {
+    this->core->dispatchEventLoop([=, this]() {
+      Lock lock(this->mutex);
+
+      if (!this->states.contains(peerId)) {
+        return cb(seq, ERR_RELAY_NOT_RUNNING("relay.getState", peerId), Post{});
+      }
+
+      auto state = this->states[peerId];
+      auto json = JSON::Object::Entries {
+        {"source", "relay.getState"},
+        {"data", JSON::Object::Entries {
+          {"id", std::to_string(peerId)},
+          {"clusters", (uint64_t) state->clusters.size()},
+          {"peers", (uint64_t) state->peers.size()},
+          {"cached", (uint64_t) state->cache.size()},
+          {"received", state->stats.received},
+          {"delivered", state->stats.delivered},
+          {"forwarded", state->stats.forwarded},
+          {"duplicates", state->stats.duplicates},
+          {"expired", state->cache.expired}
+        }}
+      };
+
+      cb(seq, json, Post{});
+    });
+  }
+
+  void Core::Relay::cacheInsert (
+    const String seq,
+    uint64_t peerId,
+    const char* bytes,
+    size_t size,
+    Module::Callback cb
+  ) {
+    // `bytes` belong to the IPC message, copy them before leaving this thread
+    auto packet = String(bytes != nullptr ? bytes : "", bytes != nullptr ? size : 0);
+
+    this->core->dispatchEventLoop([=, this]() {
+      Lock lock(this->mutex);
+      Packet decoded;
+
+      if (!this->states.contains(peerId)) {
+        return cb(seq, ERR_RELAY_NOT_RUNNING("relay.cacheInsert", peerId), Post{});
+      }
+
+      if (!Packet::decode(packet.data(), packet.size(), decoded)) {
+        auto json = JSON::Object::Entries {
+          {"source", "relay.cacheInsert"},
+          {"err", JSON::Object::Entries {
+            {"id", std::to_string(peerId)},
+            {"message", "Invalid packet"}
+          }}
+        };
+
+        return cb(seq, json, Post{});
+      }
+
+      auto now = uv_now(this->core->getEventLoop());
+      auto inserted = this->states[peerId]->cache.insert(decoded, packet.data(), packet.size(), now);
+      auto json = JSON::Object::Entries {
+        {"source", "relay.cacheInsert"},
+        {"data", JSON::Object::Entries {
+          {"id", std::to_string(peerId)},
+          {"packetId", decoded.packetId},
+          {"inserted", inserted}
+        }}
+      };
+
+      cb(seq, json, Post{});
+    });
+  }
+
+  void Core::Relay::cacheHas (
+    const String seq,
+    uint64_t peerId,
+    const String packetId,
+    Module::Callback cb
+  ) {
+    this->core->dispatchEventLoop([=, this]() {
+      Lock lock(this->mutex);
+
+      if (!this->states.contains(peerId)) {
+        return cb(seq, ERR_RELAY_NOT_RUNNING("relay.cacheHas", peerId), Post{});
+      }
+
+      auto json = JSON::Object::Entries {
+        {"source", "relay.cacheHas"},
+        {"data", JSON::Object::Entries {
+          {"id", std::to_string(peerId)},
+          {"packetId", packetId},
+          {"has", this->states[peerId]->cache.has(packetId)}
+        }}
+      };
+
+      cb(seq, json, Post{});
+    });
+  }
+
+  static Post createPacketPost (const String& bytes) {
+    Post post;
+    auto headers = Headers {{
+      {"content-type" ,"application/octet-stream"},
+      {"content-length", (uint64_t) bytes.size()}
+    }};
+
+    post.id = rand64();
+    post.body = new char[bytes.size()]{0};
+    post.length = bytes.size();
+    post.headers = headers.str();
+    memcpy(post.body, bytes.data(), bytes.size());
+    return post;
+  }
+
+  void Core::Relay::cacheGet (
+    const String seq,
+    uint64_t peerId,
+    const String packetId,
+    Module::Callback cb
+  ) {
+    this->core->dispatchEventLoop([=, this]() {
+      Lock lock(this->mutex);
+
+      if (!this->states.contains(peerId)) {
+        return cb(seq, ERR_RELAY_NOT_RUNNING("relay.cacheGet", peerId), Post{});
+      }
+
+      auto entry = this->states[peerId]->cache.get(packetId);
+
+      if (entry == nullptr) {
+        auto json = JSON::Object::Entries {
+          {"source", "relay.cacheGet"},
+          {"err", JSON::Object::Entries {
+            {"id", std::to_string(peerId)},
+            {"type", "NotFoundError"},
+            {"message", "Packet is not cached"}
+          }}
+        };
+
+        return cb(seq, json, Post{});
+      }
+
+      cb(seq, JSON::Object{}, createPacketPost(entry->bytes));
+    });
+  }
+
+  void Core::Relay::cacheCompose (
+    const String seq,
+    uint64_t peerId,
+    const String packetId,
+    Module::Callback cb
+  ) {
+    this->core->dispatchEventLoop([=, this]() {
+      Lock lock(this->mutex);
+
+      if (!this->states.contains(peerId)) {
+        return cb(seq, ERR_RELAY_NOT_RUNNING("relay.cacheCompose", peerId), Post{});
+      }
+
+      auto chain = this->states[peerId]->cache.compose(packetId);
+
+      if (chain.size() == 0) {
+        auto json = JSON::Object::Entries {
+          {"source", "relay.cacheCompose"},
+          {"err", JSON::Object::Entries {
+            {"id", std::to_string(peerId)},
+            {"type", "NotFoundError"},
+            {"message", "Packet chain is not cached"}
+          }}
+        };
+
+        return cb(seq, json, Post{});
+      }
+
+      String message;
+
+      for (const auto& entry : chain) {
+        Packet packet;
+        if (Packet::decode(entry->bytes.data(), entry->bytes.size(), packet)) {
+          message += packet.message;
+        }
+      }
+
+      cb(seq, JSON::Object{}, createPacketPost(message));
+    });
+  }
+
+  void Core::Relay::cacheSnapshot (
+    const String seq,
+    uint64_t peerId,
+    const String path,
+    Module::Callback cb
+  ) {
+    this->core->dispatchEventLoop([=, this]() {
+      Lock lock(this->mutex);
+
+      if (!this->states.contains(peerId)) {
+        return cb(seq, ERR_RELAY_NOT_RUNNING("relay.cacheSnapshot", peerId), Post{});
+      }
+
+      auto& cache = this->states[peerId]->cache;
+
+      if (!cache.snapshot(path, uv_now(this->core->getEventLoop()))) {
+        auto json = JSON::Object::Entries {
+          {"source", "relay.cacheSnapshot"},
+          {"err", JSON::Object::Entries {
+            {"id", std::to_string(peerId)},
+            {"message", "Unable to write snapshot"}
+          }}
+        };
+
+        return cb(seq, json, Post{});
+      }
+
+      auto json = JSON::Object::Entries {
+        {"source", "relay.cacheSnapshot"},
+        {"data", JSON::Object::Entries {
+          {"id", std::to_string(peerId)},
+          {"packets", (uint64_t) cache.size()}
+        }}
+      };
+
+      cb(seq, json, Post{});
+    });
+  }
+
+  void Core::Relay::cacheRestore (
+    const String seq,
+    uint64_t peerId,
+    const String path,
+    Module::Callback cb
+  ) {
+    this->core->dispatchEventLoop([=, this]() {
+      Lock lock(this->mutex);
+
+      if (!this->states.contains(peerId)) {
+        return cb(seq, ERR_RELAY_NOT_RUNNING("relay.cacheRestore", peerId), Post{});
+      }
+
+      auto now = uv_now(this->core->getEventLoop());
+      auto restored = this->states[peerId]->cache.restore(path, now);
+
+      if (restored < 0) {
+        auto json = JSON::Object::Entries {
+          {"source", "relay.cacheRestore"},
+          {"err", JSON::Object::Entries {
+            {"id", std::to_string(peerId)},
+            {"message", "Unable to read snapshot"}
+          }}
+        };
+
+        return cb(seq, json, Post{});
+      }
+
+      auto json = JSON::Object::Entries {
+        {"source", "relay.cacheRestore"},
+        {"data", JSON::Object::Entries {
+          {"id", std::to_string(peerId)},
+          {"packets", restored}
+        }}
+      };
+
+      cb(seq, json, Post{});
+    });
+  }
+}
@@ -0,0 +1,708 @@
+#include "core.hh"
+#include <cstring>
+
+namespace SSC {
+  static JSON::Object::Entries ERR_SOCKET_TCP_IS_CONNECTED (
+    const String& source,
+    uint64_t id
+  ) {
+    return JSON::Object::Entries {
+      {"source", source},
+      {"err", JSON::Object::Entries {
+        {"id", std::to_string(id)},
+        {"type", "InternalError"},
+        {"code", "ERR_SOCKET_TCP_IS_CONNECTED"},
+        {"message", "Already connected"}
+      }}
+    };
+  }
+
+  static JSON::Object::Entries ERR_SOCKET_TCP_NOT_CONNECTED (
+    const String& source,
+    uint64_t id
+  ) {
+    return JSON::Object::Entries {
+      {"source", source},
+      {"err", JSON::Object::Entries {
+        {"id", std::to_string(id)},
+        {"type", "InternalError"},
+        {"code", "ERR_SOCKET_TCP_NOT_CONNECTED"},
+        {"message", "Not connected"}
+      }}
+    };
+  }
+
+  static JSON::Object::Entries ERR_SOCKET_TCP_CLOSED (
+    const String& source,
+    uint64_t id
+  ) {
+    return JSON::Object::Entries {
+      {"source", source},
+      {"err", JSON::Object::Entries {
+        {"id", std::to_string(id)},
+        {"type", "InternalError"},
+        {"code", "ERR_SOCKET_TCP_CLOSED"},
+        {"message", "Socket is closed"}
+      }}
+    };
+  }
+
+  static JSON::Object::Entries ERR_SOCKET_TCP_CLOSING (
+    const String& source,
+    uint64_t id
+  ) {
+    return JSON::Object::Entries {
+      {"source", source},
+      {"err", JSON::Object::Entries {
+        {"id", std::to_string(id)},
+        {"type", "NotFoundError"},
+        {"code", "ERR_SOCKET_TCP_CLOSING"},
+        {"message", "Socket is closing"}
+      }}
+    };
+  }
+
+  static JSON::Object::Entries ERR_SOCKET_TCP_NOT_RUNNING (
+    const String& source,
+    uint64_t id
+  ) {
+    return JSON::Object::Entries {
+      {"source", source},
+      {"err", JSON::Object::Entries {
+        {"id", std::to_string(id)},
+        {"type", "NotFoundError"},
+        {"code", "ERR_SOCKET_TCP_NOT_RUNNING"},
+        {"message", "Not running"}
+      }}
+    };
+  }
+
+  static JSON::Object::Entries ERR_SOCKET_TCP (
+    const String& source,
+    uint64_t id,
+    int err
+  ) {
+    return JSON::Object::Entries {
+      {"source", source},
+      {"err", JSON::Object::Entries {
+        {"id", std::to_string(id)},
+        {"code", String(uv_err_name(err))},
+        {"message", String(uv_strerror(err))}
+      }}
+    };
+  }
+
+  // an empty result means `peer` is an open TCP peer
+  static JSON::Object::Entries validatePeer (
+    const String& source,
+    uint64_t id,
+    Peer* peer
+  ) {
+    if (peer == nullptr || !peer->isTCP()) {
+      return ERR_SOCKET_TCP_NOT_RUNNING(source, id);
+    }
+
+    if (peer->isClosed()) {
+      return ERR_SOCKET_TCP_CLOSED(source, id);
+    }
+
+    if (peer->isClosing()) {
+      return ERR_SOCKET_TCP_CLOSING(source, id);
+    }
+
+    return JSON::Object::Entries {};
+  }
+
+  char * Core::TCP::acquireReadBuffer () {
+    Lock lock(this->mutex);
+
+    if (this->buffers.size() > 0) {
+      auto buffer = this->buffers.back();
+      this->buffers.pop_back();
+      return buffer;
+    }
+
+    return new char[READ_BUFFER_SIZE];
+  }
+
+  void Core::TCP::releaseReadBuffer (char *buffer) {
+    if (buffer == nullptr) {
+      return;
+    }
+
+    Lock lock(this->mutex);
+
+    if (this->buffers.size() < MAX_POOLED_READ_BUFFERS) {
+      this->buffers.push_back(buffer);
+    } else {
+      delete [] buffer;
+    }
+  }
+
+  void Core::TCP::listen (
+    const String seq,
+    uint64_t peerId,
+    TCP::ListenOptions options,
+    Module::Callback cb
+  ) {
+    this->core->dispatchEventLoop([=, this]() {
+      if (this->core->hasPeer(peerId)) {
+        if (this->core->getPeer(peerId)->isBound()) {
+          auto json = ERR_SOCKET_ALREADY_BOUND("tcp.listen", peerId);
+          return cb(seq, json, Post{});
+        }
+      }
+
+      auto peer = this->core->createPeer(PEER_TYPE_TCP, peerId);
+      auto json = validatePeer("tcp.listen", peerId, peer);
+
+      if (json.size() > 0) {
+        return cb(seq, json, Post{});
+      }
+
+      auto err = peer->bind(options.address, options.port, false, options.ipv6Only);
+
+      if (err < 0) {
+        return cb(seq, ERR_SOCKET_TCP("tcp.listen", peerId, err), Post{});
+      }
+
+      err = peer->listen(options.backlog, [=](auto client, auto status) {
+        if (status < 0) {
+          return cb("-1", ERR_SOCKET_TCP("tcp.listen", peerId, status), Post{});
+        }
+
+        auto info = client->getRemotePeerInfo();
+        auto json = JSON::Object::Entries {
+          {"source", "tcp.listen"},
+          {"data", JSON::Object::Entries {
+            {"id", std::to_string(peerId)},
+            {"event", "connection"},
+            {"connection", std::to_string(client->id)},
+            {"address", info->address},
+            {"family", info->family},
+            {"port", (int) info->port}
+          }}
+        };
+
+        cb("-1", json, Post{});
+      });
+
+      if (err < 0) {
+        return cb(seq, ERR_SOCKET_TCP("tcp.listen", peerId, err), Post{});
+      }
+
+      auto info = peer->getLocalPeerInfo();
+
+      json = JSON::Object::Entries {
+        {"source", "tcp.listen"},
+        {"data", JSON::Object::Entries {
+          {"id", std::to_string(peerId)},
+          {"port", (int) info->port},
+          {"event" , "listening"},
+          {"family", info->family},
+          {"address", info->address}
+        }}
+      };
+
+      cb(seq, json, Post{});
+    });
+  }
+
+  void Core::TCP::connect (
+    const String seq,
+    uint64_t peerId,
+    TCP::ConnectOptions options,
+    Module::Callback cb
+  ) {
+    this->core->dispatchEventLoop([=, this]() {
+      auto peer = this->core->createPeer(PEER_TYPE_TCP, peerId);
+      auto json = validatePeer("tcp.connect", peerId, peer);
+
+      if (json.size() > 0) {
+        return cb(seq, json, Post{});
+      }
+
+      if (peer->isConnected()) {
+        auto json = ERR_SOCKET_TCP_IS_CONNECTED("tcp.connect", peerId);
+        return cb(seq, json, Post{});
+      }
+
+      peer->connect(options.address, options.port, [=](auto status, auto post) {
+        if (status < 0) {
+          return cb(seq, ERR_SOCKET_TCP("tcp.connect", peerId, status), Post{});
+        }
+
+        auto remote = peer->getRemotePeerInfo();
+        auto local = peer->getLocalPeerInfo();
+        auto json = JSON::Object::Entries {
+          {"source", "tcp.connect"},
+          {"data", JSON::Object::Entries {
+            {"id", std::to_string(peerId)},
+            {"address", remote->address},
+            {"family", remote->family},
+            {"port", (int) remote->port},
+            {"localAddress", local->address},
+            {"localPort", (int) local->port}
+          }}
+        };
+
+        cb(seq, json, Post{});
+      });
+    });
+  }
+
+  void Core::TCP::getPeerName (
+    const String seq,
+    uint64_t peerId,
+    Module::Callback cb
+  ) {
+    this->core->dispatchEventLoop([=, this]() {
+      auto peer = this->core->getPeer(peerId);
+      auto json = validatePeer("tcp.getPeerName", peerId, peer);
+
+      if (json.size() > 0) {
+        return cb(seq, json, Post{});
+      }
+
+      if (!peer->isConnected()) {
+        auto json = ERR_SOCKET_TCP_NOT_CONNECTED("tcp.getPeerName", peerId);
+        return cb(seq, json, Post{});
+      }
+
+      auto info = peer->getRemotePeerInfo();
+
+      if (info->err < 0) {
+        return cb(seq, ERR_SOCKET_TCP("tcp.getPeerName", peerId, info->err), Post{});
+      }
+
+      json = JSON::Object::Entries {
+        {"source", "tcp.getPeerName"},
+        {"data", JSON::Object::Entries {
+          {"address", info->address},
+          {"family", info->family},
+          {"port", (int) info->port},
+          {"id", std::to_string(peerId)}
+        }}
+      };
+
+      cb(seq, json, Post{});
+    });
+  }
+
+  void Core::TCP::getSockName (
+    const String seq,
+    uint64_t peerId,
+    Module::Callback cb
+  ) {
+    this->core->dispatchEventLoop([=, this]() {
+      auto peer = this->core->getPeer(peerId);
+      auto json = validatePeer("tcp.getSockName", peerId, peer);
+
+      if (json.size() > 0) {
+        return cb(seq, json, Post{});
+      }
+
+      auto info = peer->getLocalPeerInfo();
+
+      if (info->err < 0) {
+        return cb(seq, ERR_SOCKET_TCP("tcp.getSockName", peerId, info->err), Post{});
+      }
+
+      json = JSON::Object::Entries {
+        {"source", "tcp.getSockName"},
+        {"data", JSON::Object::Entries {
+          {"address", info->address},
+          {"family", info->family},
+          {"port", (int) info->port},
+          {"id", std::to_string(peerId)}
+        }}
+      };
+
+      cb(seq, json, Post{});
+    });
+  }
+
+  void Core::TCP::getState (
+    const String seq,
+    uint64_t peerId,
+    Module::Callback cb
+  ) {
+    this->core->dispatchEventLoop([=, this]() {
+      auto peer = this->core->getPeer(peerId);
+
+      if (peer == nullptr || !peer->isTCP()) {
+        auto json = ERR_SOCKET_TCP_NOT_RUNNING("tcp.getState", peerId);
+        return cb(seq, json, Post{});
+      }
+
+      auto json = JSON::Object::Entries {
+        {"source", "tcp.getState"},
+        {"data", JSON::Object::Entries {
+          {"id", std::to_string(peerId)},
+          {"type", "tcp"},
+          {"bound", peer->isBound()},
+          {"listening", peer->hasState(PEER_STATE_TCP_LISTENING)},
+          {"connected", peer->isConnected()},
+          {"reading", peer->hasState(PEER_STATE_TCP_READ_STARTED)},
+          {"shutdown", peer->hasState(PEER_STATE_TCP_SHUTDOWN)},
+          {"active", peer->isActive()},
+          {"closed", peer->isClosed()},
+          {"closing", peer->isClosing()},
+          {"noDelay", peer->options.tcp.noDelay},
+          {"keepAlive", peer->options.tcp.keepAlive},
+          {"writeQueueSize", (uint64_t) peer->getWriteQueueSize()}
+        }}
+      };
+
+      cb(seq, json, Post{});
+    });
+  }
+
+  void Core::TCP::readStart (
+    const String seq,
+    uint64_t peerId,
+    Module::Callback cb
+  ) {
+    this->core->dispatchEventLoop([=, this]() {
+      auto peer = this->core->getPeer(peerId);
+      auto json = validatePeer("tcp.readStart", peerId, peer);
+
+      if (json.size() > 0) {
+        return cb(seq, json, Post{});
+      }
+
+      if (!peer->isConnected()) {
+        auto json = ERR_SOCKET_TCP_NOT_CONNECTED("tcp.readStart", peerId);
+        return cb(seq, json, Post{});
+      }
+
+      auto err = peer->readstart([=](auto nread, auto buf) {
+        if (nread == UV_EOF) {
+          auto json = JSON::Object::Entries {
+            {"source", "tcp.readStart"},
+            {"data", JSON::Object::Entries {
+              {"id", std::to_string(peerId)},
+              {"EOF", true}
+            }}
+          };
+
+          return cb("-1", json, Post{});
+        }
+
+        if (nread < 0) {
+          return cb("-1", ERR_SOCKET_TCP("tcp.readStart", peerId, (int) nread), Post{});
+        }
+
+        Post post;
+        auto headers = Headers {{
+          {"content-type" ,"application/octet-stream"},
+          {"content-length", nread}
+        }};
+
+        post.id = rand64();
+        post.length = (int) nread;
+        post.headers = headers.str();
+
+        // a large read keeps its pooled buffer, which the post then owns,
+        // a small one is copied and its buffer goes back to the pool
+        if ((size_t) nread >= TCP::READ_BUFFER_SIZE / 2) {
+          post.body = buf->base;
+          buf->base = nullptr;
+        } else {
+          post.body = new char[nread];
+          memcpy(post.body, buf->base, nread);
+        }
+
+        auto json = JSON::Object::Entries {
+          {"source", "tcp.readStart"},
+          {"data", JSON::Object::Entries {
+            {"id", std::to_string(peerId)},
+            {"bytes", std::to_string(post.length)}
+          }}
+        };
+
+        cb("-1", json, post);
+      });
+
+      if (err < 0 && err != UV_EALREADY) {
+        return cb(seq, ERR_SOCKET_TCP("tcp.readStart", peerId, err), Post{});
+      }
+
+      json = JSON::Object::Entries {
+        {"source", "tcp.readStart"},
+        {"data", JSON::Object::Entries {
+          {"id", std::to_string(peerId)}
+        }}
+      };
+
+      cb(seq, json, Post{});
+    });
+  }
+
+  void Core::TCP::readStop (
+    const String seq,
+    uint64_t peerId,
+    Module::Callback cb
+  ) {
+    this->core->dispatchEventLoop([=, this]() {
+      auto peer = this->core->getPeer(peerId);
+      auto json = validatePeer("tcp.readStop", peerId, peer);
+
+      if (json.size() > 0) {
+        return cb(seq, json, Post{});
+      }
+
+      auto err = peer->readstop();
+
+      if (err < 0) {
+        return cb(seq, ERR_SOCKET_TCP("tcp.readStop", peerId, err), Post{});
+      }
+
+      json = JSON::Object::Entries {
+        {"source", "tcp.readStop"},
+        {"data", JSON::Object::Entries {
+          {"id", std::to_string(peerId)}
+        }}
+      };
+
+      cb(seq, json, Post{});
+    });
+  }
+
+  void Core::TCP::setKeepAlive (
+    const String seq,
+    uint64_t peerId,
+    bool enable,
+    unsigned int delay,
+    Module::Callback cb
+  ) {
+    this->core->dispatchEventLoop([=, this]() {
+      auto peer = this->core->createPeer(PEER_TYPE_TCP, peerId);
+      auto json = validatePeer("tcp.setKeepAlive", peerId, peer);
+
+      if (json.size() > 0) {
+        return cb(seq, json, Post{});
+      }
+
+      auto err = peer->setKeepAlive(enable, delay);
+
+      if (err < 0) {
+        return cb(seq, ERR_SOCKET_TCP("tcp.setKeepAlive", peerId, err), Post{});
+      }
+
+      json = JSON::Object::Entries {
+        {"source", "tcp.setKeepAlive"},
+        {"data", JSON::Object::Entries {
+          {"id", std::to_string(peerId)},
+          {"enable", enable},
+          {"delay", (int) delay}
+        }}
+      };
+
+      cb(seq, json, Post{});
+    });
+  }
+
+  void Core::TCP::setNoDelay (
+    const String seq,
+    uint64_t peerId,
+    bool enable,
+    Module::Callback cb
+  ) {
+    this->core->dispatchEventLoop([=, this]() {
+      auto peer = this->core->createPeer(PEER_TYPE_TCP, peerId);
+      auto json = validatePeer("tcp.setNoDelay", peerId, peer);
+
+      if (json.size() > 0) {
+        return cb(seq, json, Post{});
+      }
+
+      auto err = peer->setNoDelay(enable);
+
+      if (err < 0) {
+        return cb(seq, ERR_SOCKET_TCP("tcp.setNoDelay", peerId, err), Post{});
+      }
+
+      json = JSON::Object::Entries {
+        {"source", "tcp.setNoDelay"},
+        {"data", JSON::Object::Entries {
+          {"id", std::to_string(peerId)},
+          {"enable", enable}
+        }}
+      };
+
+      cb(seq, json, Post{});
+    });
+  }
+
+  void Core::TCP::shutdown (
+    const String seq,
+    uint64_t peerId,
+    Module::Callback cb
+  ) {
+    this->core->dispatchEventLoop([=, this]() {
+      auto peer = this->core->getPeer(peerId);
+      auto json = validatePeer("tcp.shutdown", peerId, peer);
+
+      if (json.size() > 0) {
+        return cb(seq, json, Post{});
+      }
+
+      peer->shutdown([=](auto status, auto post) {
+        if (status < 0) {
+          return cb(seq, ERR_SOCKET_TCP("tcp.shutdown", peerId, status), Post{});
+        }
+
+        auto json = JSON::Object::Entries {
+          {"source", "tcp.shutdown"},
+          {"data", JSON::Object::Entries {
+            {"id", std::to_string(peerId)}
+          }}
+        };
+
+        cb(seq, json, Post{});
+      });
+    });
+  }
+
+  void Core::TCP::write (
+    const String seq,
+    uint64_t peerId,
+    TCP::WriteOptions options,
+    Module::Callback cb
+  ) {
+    Vector<String> chunks;
+    size_t size = 0;
+
+    // `options.bytes` belong to the IPC message, copy them before leaving
+    // this thread
+    if (options.bytes != nullptr && options.batch) {
+      size_t offset = 0;
+
+      while (offset + 4 <= options.size) {
+        uint32_t length = 0;
+        for (int i = 3; i >= 0; --i) {
+          length = (length << 8) | (unsigned char) options.bytes[offset + i];
+        }
+
+        offset += 4;
+
+        if (offset + length > options.size) {
+          break;
+        }
+
+        if (length > 0) {
+          chunks.push_back(String(options.bytes + offset, length));
+          size += length;
+        }
+
+        offset += length;
+      }
+    } else if (options.bytes != nullptr && options.size > 0) {
+      chunks.push_back(String(options.bytes, options.size));
+      size = options.size;
+    }
+
+    this->core->dispatchEventLoop([=, this, chunks = std::move(chunks)]() mutable {
+      auto peer = this->core->getPeer(peerId);
+      auto json = validatePeer("tcp.write", peerId, peer);
+
+      if (json.size() > 0) {
+        return cb(seq, json, Post{});
+      }
+
+      if (!peer->isConnected()) {
+        auto json = ERR_SOCKET_TCP_NOT_CONNECTED("tcp.write", peerId);
+        return cb(seq, json, Post{});
+      }
+
+      // a zero length write, like `socket.write(Buffer.alloc(0))`, has
+      // nothing to queue and succeeds right away
+      if (chunks.size() == 0) {
+        auto json = JSON::Object::Entries {
+          {"source", "tcp.write"},
+          {"data", JSON::Object::Entries {
+            {"id", std::to_string(peerId)},
+            {"bytes", (uint64_t) 0},
+            {"writeQueueSize", (uint64_t) peer->getWriteQueueSize()},
+            {"backpressure", false}
+          }}
+        };
+
+        return cb(seq, json, Post{});
+      }
+
+      auto err = peer->write(std::move(chunks), [=, this](auto status, auto post) {
+        if (status < 0) {
+          return cb("-1", ERR_SOCKET_TCP("tcp.write", peerId, status), Post{});
+        }
+
+        auto peer = this->core->getPeer(peerId);
+
+        if (peer != nullptr && peer->needsDrain && peer->getWriteQueueSize() == 0) {
+          peer->needsDrain = false;
+
+          auto json = JSON::Object::Entries {
+            {"source", "tcp.drain"},
+            {"data", JSON::Object::Entries {
+              {"id", std::to_string(peerId)}
+            }}
+          };
+
+          cb("-1", json, Post{});
+        }
+      });
+
+      if (err < 0) {
+        return cb(seq, ERR_SOCKET_TCP("tcp.write", peerId, err), Post{});
+      }
+
+      // the reply is sent once the bytes are queued, callers should wait
+      // for `tcp.drain` when `backpressure` is reported
+      auto queued = peer->getWriteQueueSize();
+      auto backpressure = queued >= options.highWaterMark;
+
+      if (backpressure) {
+        peer->needsDrain = true;
+      }
+
+      json = JSON::Object::Entries {
+        {"source", "tcp.write"},
+        {"data", JSON::Object::Entries {
+          {"id", std::to_string(peerId)},
+          {"bytes", (uint64_t) size},
+          {"writeQueueSize", (uint64_t) queued},
+          {"backpressure", backpressure}
+        }}
+      };
+
+      cb(seq, json, Post{});
+    });
+  }
+
+  void Core::TCP::close (
+    const String seq,
+    uint64_t peerId,
+    Module::Callback cb
+  ) {
+    this->core->dispatchEventLoop([=, this]() {
+      auto peer = this->core->getPeer(peerId);
+      auto json = validatePeer("tcp.close", peerId, peer);
+
+      if (json.size() > 0) {
+        return cb(seq, json, Post{});
+      }
+
+      peer->close([=, this]() {
+        auto json = JSON::Object::Entries {
+          {"source", "tcp.close"},
+          {"data", JSON::Object::Entries {
+            {"id", std::to_string(peerId)}
+          }}
+        };
+
+        cb(seq, json, Post{});
+      });
+    });
+  }
+}
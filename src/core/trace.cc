@@ -0,0 +1,129 @@
+#include "trace.hh"
+#include "json.hh"
+
+#if defined(_WIN32)
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace SSC {
+  using Clock = std::chrono::steady_clock;
+
+  struct StartupTraceEvent {
+    String name;
+    String phase;
+    int64_t timestamp;
+    size_t thread;
+  };
+
+  // initialized while the runtime is loaded, before `main` runs
+  static const auto startupTraceOrigin = Clock::now();
+
+  static struct {
+    Mutex mutex;
+    Vector<StartupTraceEvent> events;
+    StartupTrace::CompletionCallback callback = nullptr;
+    bool completed = false;
+  } startupTrace;
+
+  static const String& getStartupTracePath () {
+    static const auto path = getEnv("SSC_STARTUP_TRACE");
+    return path;
+  }
+
+  static void record (const String& name, const String& phase) {
+    if (!StartupTrace::isEnabled()) return;
+
+    auto timestamp = std::chrono::duration_cast<std::chrono::microseconds>(
+      Clock::now() - startupTraceOrigin
+    ).count();
+
+    auto thread = std::hash<std::thread::id>{}(std::this_thread::get_id());
+
+    Lock lock(startupTrace.mutex);
+    if (startupTrace.completed) return;
+    startupTrace.events.push_back({ name, phase, timestamp, thread });
+  }
+
+  bool StartupTrace::isEnabled () {
+    return getStartupTracePath().size() > 0;
+  }
+
+  void StartupTrace::begin (const String& name) {
+    record(name, "B");
+  }
+
+  void StartupTrace::end (const String& name) {
+    record(name, "E");
+  }
+
+  void StartupTrace::instant (const String& name) {
+    record(name, "i");
+  }
+
+  void StartupTrace::complete (const String& name) {
+    if (!isEnabled()) return;
+
+    record(name, "i");
+
+    CompletionCallback callback = nullptr;
+    JSON::Array::Entries events;
+
+    {
+      Lock lock(startupTrace.mutex);
+      if (startupTrace.completed) return;
+      startupTrace.completed = true;
+      callback = startupTrace.callback;
+
+    #if defined(_WIN32)
+      auto pid = _getpid();
+    #else
+      auto pid = getpid();
+    #endif
+
+      // thread ids are numbered in order of appearance, the first is `main`
+      std::map<size_t, int> threads;
+
+      for (const auto& event : startupTrace.events) {
+        if (threads.count(event.thread) == 0) {
+          auto index = (int) threads.size();
+          threads[event.thread] = index;
+        }
+
+        auto entry = JSON::Object::Entries {
+          {"name", event.name},
+          {"cat", "startup"},
+          {"ph", event.phase},
+          {"ts", (double) event.timestamp},
+          {"pid", (double) pid},
+          {"tid", (double) threads[event.thread]}
+        };
+
+        if (event.phase == "i") {
+          entry["s"] = "p";
+        }
+
+        events.push_back(entry);
+      }
+    }
+
+    auto trace = JSON::Object(JSON::Object::Entries {
+      {"traceEvents", events},
+      {"displayTimeUnit", "ms"}
+    });
+
+    std::ofstream stream(getStartupTracePath());
+    stream << trace.str();
+    stream.close();
+
+    if (callback != nullptr) {
+      callback();
+    }
+  }
+
+  void StartupTrace::onComplete (const CompletionCallback callback) {
+    Lock lock(startupTrace.mutex);
+    startupTrace.callback = callback;
+  }
+}
@@ -0,0 +1,26 @@
+#ifndef SSC_CORE_TRACE_H
+#define SSC_CORE_TRACE_H
+
+#include "../common.hh"
+
+namespace SSC {
+  // Records the phases of application startup, from `main` to the first
+  // `domcontentloaded` event, when `SSC_STARTUP_TRACE` names an output file.
+  // The trace is written in the Chrome trace event format, readable by
+  // chrome://tracing and Perfetto, with monotonic timestamps in microseconds
+  // since the runtime was loaded.
+  class StartupTrace {
+    public:
+      using CompletionCallback = std::function<void()>;
+
+      static bool isEnabled ();
+      static void begin (const String& name);
+      static void end (const String& name);
+      static void instant (const String& name);
+      // Records `name`, writes the trace and calls the completion callback.
+      // Only the first call has an effect.
+      static void complete (const String& name);
+      static void onComplete (const CompletionCallback callback);
+  };
+}
+#endif
@@ -1,21 +1,6 @@
 #include "core.hh"
 
 namespace SSC {
-  static JSON::Object::Entries ERR_SOCKET_ALREADY_BOUND (
-    const String& source,
-    uint64_t id
-  ) {
-    return JSON::Object::Entries {
-      {"source", source},
-      {"err", JSON::Object::Entries {
-        {"id", std::to_string(id)},
-        {"type", "InternalError"},
-        {"code", "ERR_SOCKET_ALREADY_BOUND"},
-        {"message", "Socket is already bound"}
-      }}
-    };
-  }
-
   static JSON::Object::Entries ERR_SOCKET_DGRAM_IS_CONNECTED (
     const String &source,
     uint64_t id
@@ -106,7 +91,8 @@ namespace SSC {
       }
 
       auto peer = this->core->createPeer(PEER_TYPE_UDP, peerId);
-      auto err = peer->bind(options.address, options.port, options.reuseAddr);
+      peer->options.udp.gro = options.gro;
+      auto err = peer->bind(options.address, options.port, options.reuseAddr, options.ipv6Only);
 
       if (err < 0) {
         auto json = JSON::Object::Entries {
@@ -344,6 +330,140 @@ namespace SSC {
     cb(seq, json, Post{});
   }
 
+  static JSON::Object::Entries getKeepaliveTargetState (
+    const Peer::KeepaliveTarget& target,
+    uint64_t now
+  ) {
+    return JSON::Object::Entries {
+      {"address", target.address},
+      {"port", target.port},
+      {"interval", target.interval},
+      {"reachable", target.reachable},
+      // milliseconds since the target was last heard from
+      {"idle", target.lastSeen > 0 ? JSON::Any(now - target.lastSeen) : JSON::Any(nullptr)},
+      {"sent", target.sent},
+      {"received", target.received}
+    };
+  }
+
+  void Core::UDP::keepaliveGetState (
+    const String seq,
+    uint64_t peerId,
+    Module::Callback cb
+  ) {
+    this->core->dispatchEventLoop([=, this] {
+      auto peer = this->core->getPeer(peerId);
+
+      if (peer == nullptr || !peer->isUDP()) {
+        auto json = ERR_SOCKET_DGRAM_NOT_RUNNING("udp.keepaliveGetState", peerId);
+        return cb(seq, json, Post{});
+      }
+
+      auto now = uv_now(this->core->getEventLoop());
+      JSON::Array::Entries targets;
+
+      for (const auto& target : peer->getKeepaliveTargets()) {
+        targets.push_back(getKeepaliveTargetState(target, now));
+      }
+
+      auto json = JSON::Object::Entries {
+        {"source", "udp.keepaliveGetState"},
+        {"data", JSON::Object::Entries {
+          {"id", std::to_string(peerId)},
+          {"targets", targets}
+        }}
+      };
+
+      cb(seq, json, Post{});
+    });
+  }
+
+  void Core::UDP::keepaliveStart (
+    const String seq,
+    uint64_t peerId,
+    UDP::KeepaliveOptions options,
+    Module::Callback cb
+  ) {
+    this->core->dispatchEventLoop([=, this] {
+      auto peer = this->core->getPeer(peerId);
+
+      if (peer == nullptr || !peer->isUDP()) {
+        auto json = ERR_SOCKET_DGRAM_NOT_RUNNING("udp.keepaliveStart", peerId);
+        return cb(seq, json, Post{});
+      }
+
+      if (peer->isClosing() || peer->isClosed()) {
+        auto json = ERR_SOCKET_DGRAM_CLOSED("udp.keepaliveStart", peerId);
+        return cb(seq, json, Post{});
+      }
+
+      auto loop = this->core->getEventLoop();
+      auto err = peer->addKeepaliveTargets(options.targets, options.payload, [=](auto target) {
+        auto json = JSON::Object::Entries {
+          {"source", "udp.keepalive"},
+          {"data", JSON::Object::Entries {
+            {"id", std::to_string(peerId)},
+            {"address", target.address},
+            {"port", target.port},
+            {"reachable", target.reachable},
+            {"idle", target.lastSeen > 0 ? JSON::Any(uv_now(loop) - target.lastSeen) : JSON::Any(nullptr)}
+          }}
+        };
+
+        cb("-1", json, Post{});
+      });
+
+      if (err < 0) {
+        auto json = JSON::Object::Entries {
+          {"source", "udp.keepaliveStart"},
+          {"err", JSON::Object::Entries {
+            {"id", std::to_string(peerId)},
+            {"message", String(uv_strerror(err))}
+          }}
+        };
+
+        return cb(seq, json, Post{});
+      }
+
+      auto json = JSON::Object::Entries {
+        {"source", "udp.keepaliveStart"},
+        {"data", JSON::Object::Entries {
+          {"id", std::to_string(peerId)},
+          {"targets", (uint64_t) peer->getKeepaliveTargets().size()}
+        }}
+      };
+
+      cb(seq, json, Post{});
+    });
+  }
+
+  void Core::UDP::keepaliveStop (
+    const String seq,
+    uint64_t peerId,
+    Vector<Peer::KeepaliveTarget> targets,
+    Module::Callback cb
+  ) {
+    this->core->dispatchEventLoop([=, this] {
+      auto peer = this->core->getPeer(peerId);
+
+      if (peer == nullptr || !peer->isUDP()) {
+        auto json = ERR_SOCKET_DGRAM_NOT_RUNNING("udp.keepaliveStop", peerId);
+        return cb(seq, json, Post{});
+      }
+
+      auto remaining = peer->removeKeepaliveTargets(targets);
+      auto json = JSON::Object::Entries {
+        {"source", "udp.keepaliveStop"},
+        {"data", JSON::Object::Entries {
+          {"id", std::to_string(peerId)},
+          {"targets", remaining}
+        }}
+      };
+
+      cb(seq, json, Post{});
+    });
+  }
+
   void Core::UDP::send (
     String seq,
     uint64_t peerId,
@@ -351,12 +471,18 @@ namespace SSC {
     Module::Callback cb
   ) {
     this->core->dispatchEventLoop([=, this] {
-      auto peer = this->core->createPeer(PEER_TYPE_UDP, peerId, options.ephemeral);
+      struct sockaddr_storage addr;
+      auto family = parseSocketAddress(options.address, options.port, &addr) == 0
+        ? addr.ss_family
+        : AF_UNSPEC;
+
+      auto peer = this->core->createPeer(PEER_TYPE_UDP, peerId, options.ephemeral, family);
       auto size = options.size; // @TODO(jwerle): validate MTU
       auto port = options.port;
       auto bytes = options.bytes;
       auto address = options.address;
-      peer->send(bytes, size, port, address, [=](auto status, auto post) {
+      auto segmentSize = options.segmentSize;
+      peer->sendSegments(bytes, size, segmentSize, port, address, [=](auto status, auto post) {
         if (status < 0) {
           auto json = JSON::Object::Entries {
             {"source", "udp.send"},
@@ -437,7 +563,7 @@ namespace SSC {
       }
 
       if (nread > 0) {
-        char address[17] = {0};
+        char address[INET6_ADDRSTRLEN] = {0};
         Post post;
         int port;
 
@@ -453,14 +579,23 @@ namespace SSC {
         post.length = (int) nread;
         post.headers = headers.str();
 
+        auto data = JSON::Object::Entries {
+          {"id", std::to_string(peerId)},
+          {"port", port},
+          {"bytes", std::to_string(post.length)},
+          {"address", address},
+          {"family", getAddressFamily(addr)}
+        };
+
+        // a `UDP_GRO` super-packet of `segmentSize` datagrams, the last of
+        // which may be shorter
+        if (peer->receiveSegmentSize > 0) {
+          data["segmentSize"] = (uint64_t) peer->receiveSegmentSize;
+        }
+
         auto json = JSON::Object::Entries {
           {"source", "udp.readStart"},
-          {"data", JSON::Object::Entries {
-            {"id", std::to_string(peerId)},
-            {"port", port},
-            {"bytes", std::to_string(post.length)},
-            {"address", address}
-          }}
+          {"data", data}
         };
 
         cb("-1", json, post);
@@ -3,6 +3,88 @@
 #include "../window/window.hh"
 #include "../ipc/ipc.hh"
 
+//
+// Connects back to `ssc build --watch` on the dev host and port. The CLI
+// sends a `reload <id>` line after each rebuild and windows acknowledge it
+// with `reloaded <id>` once the reloaded page is on screen.
+//
+class DevServerConnection {
+  public:
+    using LineCallback = std::function<void(const SSC::String&)>;
+
+    DevServerConnection (Core *core, SSC::String host, int port, LineCallback onLine) {
+      this->core = core;
+      this->onLine = onLine;
+
+      core->dispatchEventLoop([=, this]() {
+        struct sockaddr_in addr;
+        uv_ip4_addr(host == "localhost" ? "127.0.0.1" : host.c_str(), port, &addr);
+        uv_tcp_init(this->core->getEventLoop(), &this->handle);
+        this->handle.data = this;
+        this->request.data = this;
+
+        uv_tcp_connect(&this->request, &this->handle, (const struct sockaddr *) &addr, [](uv_connect_t *request, int status) {
+          auto connection = reinterpret_cast<DevServerConnection *>(request->data);
+
+          if (status != 0) {
+            debug("Unable to connect to the dev server: %s", uv_strerror(status));
+            return;
+          }
+
+          uv_read_start(
+            request->handle,
+            [](uv_handle_t *handle, size_t size, uv_buf_t *buf) {
+              *buf = uv_buf_init(new char[size], size);
+            },
+            [](uv_stream_t *stream, ssize_t nread, const uv_buf_t *buf) {
+              auto connection = reinterpret_cast<DevServerConnection *>(stream->data);
+
+              if (nread > 0) {
+                connection->buffer.append(buf->base, nread);
+                size_t offset = 0;
+
+                while ((offset = connection->buffer.find('\n')) != SSC::String::npos) {
+                  connection->onLine(connection->buffer.substr(0, offset));
+                  connection->buffer.erase(0, offset + 1);
+                }
+              } else if (nread < 0) {
+                uv_read_stop(stream);
+              }
+
+              delete [] buf->base;
+            }
+          );
+
+          connection->connected = true;
+        });
+      });
+    }
+
+    void send (const SSC::String& line) {
+      this->core->dispatchEventLoop([=, this]() {
+        if (!this->connected) return;
+
+        auto bytes = new SSC::String(line + "\n");
+        auto request = new uv_write_t;
+        auto buf = uv_buf_init(bytes->data(), bytes->size());
+        request->data = bytes;
+
+        uv_write(request, (uv_stream_t *) &this->handle, &buf, 1, [](uv_write_t *request, int) {
+          delete reinterpret_cast<SSC::String *>(request->data);
+          delete request;
+        });
+      });
+    }
+
+  private:
+    Core *core;
+    LineCallback onLine;
+    uv_tcp_t handle;
+    uv_connect_t request;
+    SSC::String buffer;
+    bool connected = false;
+};
+
 //
 // A cross platform MAIN macro that
 // magically gives us argc and argv.
@@ -63,6 +145,14 @@ SSC::String getNavigationError (const String &cwd, const String &value) {
 // which on windows is hInstance, on mac and linux this is just an int.
 //
 MAIN {
+  StartupTrace::instant("main");
+
+  // the first `getUserConfig()` call parses the compiled in settings, it is
+  // made before `App` and `Core` read them so the span times the real load
+  StartupTrace::begin("config");
+  SSC::getUserConfig();
+  StartupTrace::end("config");
+
   // Singletons should be static to remove some possible race conditions in
   // their instantiation and destruction.
   static App app(instanceId);
@@ -211,6 +301,7 @@ MAIN {
 
   static Process* process = nullptr;
   static std::function<void(bool)> createProcess;
+  static DevServerConnection* devServer = nullptr;
 
   auto killProcess = [&](Process* processToKill) {
     if (processToKill != nullptr) {
@@ -383,6 +474,68 @@ MAIN {
     });
   };
 
+  //
+  // ## Framed
+  // With `backend_protocol = "framed"` in the `[core]` section, the backend
+  // process writes binary `ProcessFrame`s to stdout. Message frames are
+  // routed like lines above, data frames are put in the post store and
+  // dispatched directly to the target window.
+  //
+  auto onStdOutFrame = [&](const ProcessFrame& frame) {
+    if (frame.type == ProcessFrame::Type::message) {
+      onStdOut(SSC::String(frame.bytes, frame.size));
+      return;
+    }
+
+    if (frame.type != ProcessFrame::Type::data || frame.index >= SSC_MAX_WINDOWS) {
+      // @TODO: print warning
+      return;
+    }
+
+    // `frame.bytes` is only valid during this callback
+    Post post;
+    post.id = rand64();
+    post.body = new char[frame.size];
+    post.length = frame.size;
+    post.headers = Headers {{
+      {"content-type", "application/octet-stream"},
+      {"content-length", (uint64_t) frame.size}
+    }}.str();
+
+    memcpy(post.body, frame.bytes, frame.size);
+
+    auto index = frame.index < 0 ? 0 : frame.index;
+
+    app.dispatch([&, post, index] {
+      auto window = windowManager.getWindow(index);
+
+      if (!window) {
+        delete [] post.body;
+        return;
+      }
+
+      const JSON::Object params = JSON::Object::Entries {
+        {"source", "process.stdout"},
+        {"index", index}
+      };
+
+      window->eval(app.core->createPost("-1", params.str(), post));
+    });
+  };
+
+  auto processConfig = ProcessConfig {};
+
+  if (app.appData["core_backend_protocol"] == "framed") {
+    processConfig.read_stdout_frame = onStdOutFrame;
+  }
+
+  if (app.appData["core_backend_event_loop"] == "true") {
+    processConfig.loop = app.core->getEventLoop();
+    processConfig.dispatch = [&](auto callback) {
+      app.core->dispatchEventLoop(callback);
+    };
+  }
+
   createProcess = createProcessTemplate(
     cmd,
     argvForward.str(),
@@ -396,7 +549,9 @@ MAIN {
           window->eval(getEmitToRenderProcessJavaScript("backend-exit", code));
         }
       }
-    }
+    },
+    true,
+    processConfig
   );
 
   //
@@ -515,6 +670,24 @@ MAIN {
       return;
     }
 
+    if (message.name == "application.reloaded") {
+      const auto seq = message.get("seq");
+
+      if (devServer != nullptr) {
+        devServer->send("reloaded " + message.get("id"));
+      }
+
+      window->resolvePromise(seq, OK_STATE, "null");
+      return;
+    }
+
+    if (message.name == "application.getDispatchQueueMetrics") {
+      const auto seq = message.get("seq");
+      const auto json = app.getDispatchQueueMetrics();
+      window->resolvePromise(seq, OK_STATE, json.str());
+      return;
+    }
+
     if (message.name == "application.getWindows") {
       const auto index = message.index;
       const auto window = windowManager.getWindow(index);
@@ -890,6 +1063,7 @@ MAIN {
     .onExit = shutdownHandler
   });
 
+  StartupTrace::begin("window");
   auto defaultWindow = windowManager.createDefaultWindow(WindowOptions {
     .resizable = app.appData["window_resizable"] == "false" ? false : true,
     .frameless = app.appData["window_frameless"] == "true" ? true : false,
@@ -897,6 +1071,18 @@ MAIN {
   });
 
   defaultWindow->show(EMPTY_SEQ);
+  StartupTrace::end("window");
+
+  // used by the startup benchmark to exit once the trace is written
+  if (getEnv("SSC_STARTUP_TRACE_EXIT") == "1") {
+    StartupTrace::onComplete([defaultWindow]() {
+      app.dispatch([defaultWindow]() {
+        defaultWindow->exit(0);
+      });
+    });
+  }
+
+  StartupTrace::instant("navigate");
 
   if (_port > 0) {
     defaultWindow->navigate(EMPTY_SEQ, "http://localhost:" + std::to_string(_port));
@@ -906,6 +1092,11 @@ MAIN {
       "  Quit: q + CommandOrControl\n"
       ";"
     ));
+  } else if (
+    IPC::getResourcesArchive() != nullptr &&
+    IPC::getResourcesArchive()->find("index.html") != nullptr
+  ) {
+    defaultWindow->navigate(EMPTY_SEQ, "resources:///index.html");
   } else {
     defaultWindow->navigate(EMPTY_SEQ, "file://" + (fs::path(cwd) / "index.html").string());
   }
@@ -939,6 +1130,48 @@ MAIN {
     t.detach();
   }
 
+  //
+  // # Dev Server
+  // `ssc build --watch` sets the dev host and port to ask for reloads.
+  //
+  auto devPort = 0;
+
+  try {
+    devPort = std::stoi(getEnv("SSC_DEV_PORT"));
+  } catch (...) {}
+
+  if (isDebugEnabled() && devPort > 0 && devPort <= 65535) {
+    auto devHost = getEnv("SSC_DEV_HOST");
+
+    devServer = new DevServerConnection(
+      app.core,
+      devHost.size() > 0 ? devHost : getDevHost(),
+      devPort,
+      [&](SSC::String const &line) {
+        if (!line.starts_with("reload ")) return;
+
+        auto id = line.substr(7);
+
+        if (id.size() == 0 || !std::all_of(id.begin(), id.end(), ::isdigit)) {
+          return;
+        }
+
+        auto script = (
+          "globalThis.sessionStorage?.setItem('__ssc_dev_reload', '" + id + "');"
+          "globalThis.location.reload();"
+        );
+
+        app.dispatch([&, script] {
+          for (auto w : windowManager.windows) {
+            if (w != nullptr) {
+              windowManager.getWindow(w->opts.index)->eval(script);
+            }
+          }
+        });
+      }
+    );
+  }
+
   //
   // # Event Loop
   // start the platform specific event loop for the main
@@ -6,12 +6,35 @@ namespace SSC {
     return DEBUG == 1;
   }
 
-  const Map getUserConfig () {
-    #include "user-config-bytes.hh" // NOLINT
-    return parseINI(std::string(
-      (const char*) __ssc_config_bytes,
-      sizeof(__ssc_config_bytes)
-    ));
+  const Map& getUserConfig () {
+    static const Map config = []() {
+      #include "user-config-bytes.hh" // NOLINT
+      auto config = parseINI(std::string(
+        (const char*) __ssc_config_bytes,
+        sizeof(__ssc_config_bytes)
+      ));
+
+      // in debug builds, a sidecar file overrides the compiled in settings
+      // without a rebuild
+      auto path = isDebugEnabled() ? getEnv("SSC_SETTINGS_FILE") : "";
+      if (path.size() > 0) {
+        std::ifstream stream(path);
+        if (stream.is_open()) {
+          StringStream source;
+          source << stream.rdbuf();
+          extendMap(config, parseINI(source.str()));
+        }
+      }
+
+      return config;
+    }();
+
+    return config;
+  }
+
+  const SettingsTable& getUserSettings () {
+    static const SettingsTable settings(getUserConfig());
+    return settings;
   }
 
   const char* getDevHost () {
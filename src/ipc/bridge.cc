@@ -4,8 +4,6 @@
 #define IPC_BINARY_CONTENT_TYPE "application/octet-stream"
 #define IPC_JSON_CONTENT_TYPE "text/json"
 
-extern const SSC::Map SSC::getUserConfig ();
-
 using namespace SSC;
 using namespace SSC::IPC;
 
@@ -92,6 +90,47 @@ static String getcwd () {
   return cwd;
 }
 
+// parses comma separated `address:port` endpoints, IPv6 addresses in
+// brackets (`[::1]:9000`)
+static bool parseKeepaliveTargets (
+  const String& value,
+  Vector<Peer::KeepaliveTarget>& targets
+) {
+  for (const auto& entry : split(value, ',')) {
+    auto endpoint = trim(entry);
+    auto separator = endpoint.rfind(':');
+    Peer::KeepaliveTarget target;
+
+    if (endpoint.size() == 0) {
+      continue;
+    }
+
+    if (separator == String::npos || separator == 0) {
+      return false;
+    }
+
+    target.address = endpoint.substr(0, separator);
+
+    if (target.address.starts_with("[") && target.address.ends_with("]")) {
+      target.address = target.address.substr(1, target.address.size() - 2);
+    }
+
+    try {
+      target.port = std::stoi(endpoint.substr(separator + 1));
+    } catch (...) {
+      return false;
+    }
+
+    if (target.port <= 0 || target.port > 65535) {
+      return false;
+    }
+
+    targets.push_back(target);
+  }
+
+  return true;
+}
+
 #define RESULT_CALLBACK_FROM_CORE_CALLBACK(message, reply)                     \
   [=](auto seq, auto json, auto post) {                                        \
     reply(Result { seq, message, json, post });                                \
@@ -123,8 +162,7 @@ static String getcwd () {
 
 void initFunctionsTable (Router *router) {
 #if defined(__APPLE__)
-  static auto userConfig = SSC::getUserConfig();
-  static auto bundleIdentifier = userConfig["meta_bundle_identifier"];
+  static auto bundleIdentifier = SSC::getUserSettings().get("meta_bundle_identifier");
   static auto SSC_OS_LOG_BUNDLE = os_log_create(bundleIdentifier.c_str(),
   #if TARGET_OS_IPHONE || TARGET_IPHONE_SIMULATOR
     "socket.runtime.mobile"
@@ -228,10 +266,173 @@ void initFunctionsTable (Router *router) {
     reply(Result { message.seq, message });
   });
 
+  /**
+   * Seals each record in `message.buffer` for `publicKey` with an anonymous
+   * sealed box. Records are a little-endian `uint32` length followed by bytes.
+   * @param publicKey Hex encoded curve25519 public key
+   * @see crypto_box_seal(3)
+   */
+  router->map("crypto.seal", [=](auto message, auto router, auto reply) {
+    auto err = validateMessageParameters(message, {"publicKey"});
+
+    if (err.type != JSON::Type::Null) {
+      return reply(Result::Err { message, err });
+    }
+
+    router->core->crypto.seal(
+      message.seq,
+      message.get("publicKey"),
+      message.buffer.bytes,
+      message.buffer.size,
+      RESULT_CALLBACK_FROM_CORE_CALLBACK(message, reply)
+    );
+  });
+
+  /**
+   * Opens each sealed box record in `message.buffer`. Records that fail to
+   * open are returned empty.
+   * @param publicKey Hex encoded curve25519 public key
+   * @param secretKey Hex encoded curve25519 secret key
+   * @see crypto_box_seal_open(3)
+   */
+  router->map("crypto.open", [=](auto message, auto router, auto reply) {
+    auto err = validateMessageParameters(message, {"publicKey", "secretKey"});
+
+    if (err.type != JSON::Type::Null) {
+      return reply(Result::Err { message, err });
+    }
+
+    router->core->crypto.open(
+      message.seq,
+      message.get("publicKey"),
+      message.get("secretKey"),
+      message.buffer.bytes,
+      message.buffer.size,
+      RESULT_CALLBACK_FROM_CORE_CALLBACK(message, reply)
+    );
+  });
+
+  /**
+   * Computes a detached ed25519 signature for each record in `message.buffer`.
+   * @param secretKey Hex encoded ed25519 secret key
+   * @see crypto_sign_detached(3)
+   */
+  router->map("crypto.sign", [=](auto message, auto router, auto reply) {
+    auto err = validateMessageParameters(message, {"secretKey"});
+
+    if (err.type != JSON::Type::Null) {
+      return reply(Result::Err { message, err });
+    }
+
+    router->core->crypto.sign(
+      message.seq,
+      message.get("secretKey"),
+      message.buffer.bytes,
+      message.buffer.size,
+      RESULT_CALLBACK_FROM_CORE_CALLBACK(message, reply)
+    );
+  });
+
+  /**
+   * Verifies each record in `message.buffer`, a detached signature followed
+   * by the signed message. Each result record is a single `0` or `1` byte.
+   * @param publicKey Hex encoded ed25519 public key
+   * @see crypto_sign_verify_detached(3)
+   */
+  router->map("crypto.verify", [=](auto message, auto router, auto reply) {
+    auto err = validateMessageParameters(message, {"publicKey"});
+
+    if (err.type != JSON::Type::Null) {
+      return reply(Result::Err { message, err });
+    }
+
+    router->core->crypto.verify(
+      message.seq,
+      message.get("publicKey"),
+      message.buffer.bytes,
+      message.buffer.size,
+      RESULT_CALLBACK_FROM_CORE_CALLBACK(message, reply)
+    );
+  });
+
+  /**
+   * Converts each ed25519 public key record in `message.buffer` to curve25519.
+   * @see crypto_sign_ed25519_pk_to_curve25519(3)
+   */
+  router->map("crypto.ed25519PublicKeyToCurve25519", [=](auto message, auto router, auto reply) {
+    router->core->crypto.ed25519PublicKeyToCurve25519(
+      message.seq,
+      message.buffer.bytes,
+      message.buffer.size,
+      RESULT_CALLBACK_FROM_CORE_CALLBACK(message, reply)
+    );
+  });
+
+  /**
+   * Converts each ed25519 secret key record in `message.buffer` to curve25519.
+   * @see crypto_sign_ed25519_sk_to_curve25519(3)
+   */
+  router->map("crypto.ed25519SecretKeyToCurve25519", [=](auto message, auto router, auto reply) {
+    router->core->crypto.ed25519SecretKeyToCurve25519(
+      message.seq,
+      message.buffer.bytes,
+      message.buffer.size,
+      RESULT_CALLBACK_FROM_CORE_CALLBACK(message, reply)
+    );
+  });
+
+  /**
+   * Hashes each record in `message.buffer` in a single call.
+   * @param algorithm "sha256" or "blake2b" [default = "sha256"]
+   * @param size BLAKE2b digest size in bytes [default = 32]
+   */
+  router->map("crypto.hash", [=](auto message, auto router, auto reply) {
+    size_t size = 32;
+    REQUIRE_AND_GET_MESSAGE_VALUE(size, "size", std::stoull, "32");
+
+    router->core->crypto.hash(
+      message.seq,
+      message.get("algorithm", "sha256"),
+      size,
+      message.buffer.bytes,
+      message.buffer.size,
+      RESULT_CALLBACK_FROM_CORE_CALLBACK(message, reply)
+    );
+  });
+
+  /**
+   * Hashes the file behind an open file descriptor without reading it into
+   * the webview. The descriptor offset is not changed.
+   * @param id Handle ID for an open file descriptor
+   * @param algorithm "sha256" or "blake2b" [default = "sha256"]
+   * @param size BLAKE2b digest size in bytes [default = 32]
+   */
+  router->map("crypto.hashDescriptor", [=](auto message, auto router, auto reply) {
+    auto err = validateMessageParameters(message, {"id"});
+
+    if (err.type != JSON::Type::Null) {
+      return reply(Result::Err { message, err });
+    }
+
+    uint64_t id;
+    size_t size = 32;
+    REQUIRE_AND_GET_MESSAGE_VALUE(id, "id", std::stoull);
+    REQUIRE_AND_GET_MESSAGE_VALUE(size, "size", std::stoull, "32");
+
+    router->core->crypto.hashDescriptor(
+      message.seq,
+      message.get("algorithm", "sha256"),
+      size,
+      id,
+      RESULT_CALLBACK_FROM_CORE_CALLBACK(message, reply)
+    );
+  });
+
   /**
    * Look up an IP address by `hostname`.
    * @param hostname Host name to lookup
    * @param family IP address family to resolve [default = 0 (AF_UNSPEC)]
+   * @param all Return every resolved address in `addresses` [default = false]
    * @see getaddrinfo(3)
    */
   router->map("dns.lookup", [=](auto message, auto router, auto reply) {
@@ -246,11 +447,69 @@ void initFunctionsTable (Router *router) {
 
     router->core->dns.lookup(
       message.seq,
-      Core::DNS::LookupOptions { message.get("hostname"), family },
+      Core::DNS::LookupOptions {
+        message.get("hostname"),
+        family,
+        message.get("all") == "true"
+      },
+      RESULT_CALLBACK_FROM_CORE_CALLBACK(message, reply)
+    );
+  });
+
+  /**
+   * Drops every cached `dns.lookup` answer.
+   */
+  router->map("dns.clearCache", [=](auto message, auto router, auto reply) {
+    router->core->dns.clearCache(
+      message.seq,
+      RESULT_CALLBACK_FROM_CORE_CALLBACK(message, reply)
+    );
+  });
+
+  /**
+   * Returns `dns.lookup` cache counters and the hit ratio.
+   */
+  router->map("dns.getStats", [=](auto message, auto router, auto reply) {
+    router->core->dns.getStats(
+      message.seq,
       RESULT_CALLBACK_FROM_CORE_CALLBACK(message, reply)
     );
   });
 
+  // pages of a release build can not redirect host names, the native
+  // `Core::DNS::setResolver()` hook is available to embedders in every build
+  if (isDebugEnabled()) {
+    /**
+     * Answers lookups of `hostname` from a local table instead of the
+     * system resolver. Only available in debug builds.
+     * @param hostname Host name to answer for
+     * @param addresses Comma separated IP addresses, empty to remove the entry
+     */
+    router->map("dns.setLocalAddresses", [=](auto message, auto router, auto reply) {
+      auto err = validateMessageParameters(message, {"hostname"});
+
+      if (err.type != JSON::Type::Null) {
+        return reply(Result::Err { message, err });
+      }
+
+      Vector<String> addresses;
+
+      for (const auto& address : split(message.get("addresses"), ',')) {
+        auto value = trim(address);
+        if (value.size() > 0) {
+          addresses.push_back(value);
+        }
+      }
+
+      router->core->dns.setLocalAddresses(
+        message.seq,
+        message.get("hostname"),
+        addresses,
+        RESULT_CALLBACK_FROM_CORE_CALLBACK(message, reply)
+      );
+    });
+  }
+
   /**
    * Checks if current user can access file at `path` with `mode`.
    * @param path
@@ -955,49 +1214,34 @@ void initFunctionsTable (Router *router) {
   });
 
   /**
-   * Prints incoming message value to stdout.
-   */
-  router->map("stdout", [=](auto message, auto router, auto reply) {
-  #if defined(__APPLE__)
-    os_log_with_type(SSC_OS_LOG_BUNDLE, OS_LOG_TYPE_INFO, "%{public}s", message.value.c_str());
-  #endif
-    stdWrite(message.value, false);
-  });
-
-  /**
-   * Prints incoming message value to stderr.
-   */
-  router->map("stderr", [=](auto message, auto router, auto reply) {
-  #if defined(__APPLE__)
-    os_log_with_type(SSC_OS_LOG_BUNDLE, OS_LOG_TYPE_ERROR, "%{public}s", message.value.c_str());
-  #endif
-    stdWrite(message.value, true);
-  });
-
-  /**
-   * Binds an UDP socket to a specified port, and optionally a host
-   * address (default: 0.0.0.0).
+   * Starts the native stream-relay engine on a bound UDP socket. Publish
+   * packets are decoded, deduplicated, cached and forwarded on the event
+   * loop, only packets for subscribed clusters reach the socket listeners.
    * @param id Handle ID of underlying socket
-   * @param port Port to bind the UDP socket to
-   * @param address The address to bind the UDP socket to (default: 0.0.0.0)
-   * @param reuseAddr Reuse underlying UDP socket address (default: false)
+   * @param clusters Comma separated hex encoded cluster IDs to deliver
+   * @param maxHops Packets are not forwarded past this many hops (default: 16)
+   * @param fanout Number of peers a packet is forwarded to (default: 3)
    */
-  router->map("udp.bind", [=](auto message, auto router, auto reply) {
-    Core::UDP::BindOptions options;
-    auto err = validateMessageParameters(message, {"id", "port"});
+  router->map("relay.start", [=](auto message, auto router, auto reply) {
+    auto err = validateMessageParameters(message, {"id"});
 
     if (err.type != JSON::Type::Null) {
       return reply(Result::Err { message, err });
     }
 
+    Core::Relay::StartOptions options;
     uint64_t id;
     REQUIRE_AND_GET_MESSAGE_VALUE(id, "id", std::stoull);
-    REQUIRE_AND_GET_MESSAGE_VALUE(options.port, "port", std::stoi);
+    REQUIRE_AND_GET_MESSAGE_VALUE(options.maxHops, "maxHops", std::stoul, "16");
+    REQUIRE_AND_GET_MESSAGE_VALUE(options.fanout, "fanout", std::stoul, "3");
 
-    options.reuseAddr = message.get("reuseAddr") == "true";
-    options.address = message.get("address", "0.0.0.0");
+    for (const auto& clusterId : split(message.get("clusters"), ',')) {
+      if (clusterId.size() > 0) {
+        options.clusters.push_back(clusterId);
+      }
+    }
 
-    router->core->udp.bind(
+    router->core->relay.start(
       message.seq,
       id,
       options,
@@ -1006,10 +1250,10 @@ void initFunctionsTable (Router *router) {
   });
 
   /**
-   * Close socket handle and underlying UDP socket.
+   * Stops the native stream-relay engine on a socket.
    * @param id Handle ID of underlying socket
    */
-  router->map("udp.close", [=](auto message, auto router, auto reply) {
+  router->map("relay.stop", [=](auto message, auto router, auto reply) {
     auto err = validateMessageParameters(message, {"id"});
 
     if (err.type != JSON::Type::Null) {
@@ -1019,44 +1263,39 @@ void initFunctionsTable (Router *router) {
     uint64_t id;
     REQUIRE_AND_GET_MESSAGE_VALUE(id, "id", std::stoull);
 
-    router->core->udp.close(message.seq, id, RESULT_CALLBACK_FROM_CORE_CALLBACK(message, reply));
+    router->core->relay.stop(message.seq, id, RESULT_CALLBACK_FROM_CORE_CALLBACK(message, reply));
   });
 
   /**
-   * Connects an UDP socket to a specified port, and optionally a host
-   * address (default: 0.0.0.0).
+   * Delivers packets for a cluster to the socket listeners.
    * @param id Handle ID of underlying socket
-   * @param port Port to connect the UDP socket to
-   * @param address The address to connect the UDP socket to (default: 0.0.0.0)
+   * @param clusterId Hex encoded cluster ID
    */
-  router->map("udp.connect", [=](auto message, auto router, auto reply) {
-    auto err = validateMessageParameters(message, {"id", "port"});
+  router->map("relay.subscribe", [=](auto message, auto router, auto reply) {
+    auto err = validateMessageParameters(message, {"id", "clusterId"});
 
     if (err.type != JSON::Type::Null) {
       return reply(Result::Err { message, err });
     }
 
-    Core::UDP::ConnectOptions options;
     uint64_t id;
     REQUIRE_AND_GET_MESSAGE_VALUE(id, "id", std::stoull);
-    REQUIRE_AND_GET_MESSAGE_VALUE(options.port, "port", std::stoi);
-
-    options.address = message.get("address", "0.0.0.0");
 
-    router->core->udp.connect(
+    router->core->relay.subscribe(
       message.seq,
       id,
-      options,
+      message.get("clusterId"),
       RESULT_CALLBACK_FROM_CORE_CALLBACK(message, reply)
     );
   });
 
   /**
-   * Disconnects a connected socket handle and underlying UDP socket.
+   * Stops delivering packets for a cluster, they are relayed natively.
    * @param id Handle ID of underlying socket
+   * @param clusterId Hex encoded cluster ID
    */
-  router->map("udp.disconnect", [=](auto message, auto router, auto reply) {
-    auto err = validateMessageParameters(message, {"id"});
+  router->map("relay.unsubscribe", [=](auto message, auto router, auto reply) {
+    auto err = validateMessageParameters(message, {"id", "clusterId"});
 
     if (err.type != JSON::Type::Null) {
       return reply(Result::Err { message, err });
@@ -1065,39 +1304,47 @@ void initFunctionsTable (Router *router) {
     uint64_t id;
     REQUIRE_AND_GET_MESSAGE_VALUE(id, "id", std::stoull);
 
-    router->core->udp.disconnect(
+    router->core->relay.unsubscribe(
       message.seq,
       id,
+      message.get("clusterId"),
       RESULT_CALLBACK_FROM_CORE_CALLBACK(message, reply)
     );
   });
 
   /**
-   * Returns connected peer socket address information.
+   * Adds a peer packets may be forwarded to. Peers are also learned from
+   * received packets and expire when they stop sending.
    * @param id Handle ID of underlying socket
+   * @param address The address of the peer
+   * @param port The port of the peer
    */
-  router->map("udp.getPeerName", [=](auto message, auto router, auto reply) {
-    auto err = validateMessageParameters(message, {"id"});
+  router->map("relay.addPeer", [=](auto message, auto router, auto reply) {
+    auto err = validateMessageParameters(message, {"id", "address", "port"});
 
     if (err.type != JSON::Type::Null) {
       return reply(Result::Err { message, err });
     }
 
     uint64_t id;
+    int port;
     REQUIRE_AND_GET_MESSAGE_VALUE(id, "id", std::stoull);
+    REQUIRE_AND_GET_MESSAGE_VALUE(port, "port", std::stoi);
 
-    router->core->udp.getPeerName(
+    router->core->relay.addPeer(
       message.seq,
       id,
+      message.get("address"),
+      port,
       RESULT_CALLBACK_FROM_CORE_CALLBACK(message, reply)
     );
   });
 
   /**
-   * Returns local socket address information.
+   * Gets the packet counters of the native stream-relay engine on a socket.
    * @param id Handle ID of underlying socket
    */
-  router->map("udp.getSockName", [=](auto message, auto router, auto reply) {
+  router->map("relay.getState", [=](auto message, auto router, auto reply) {
     auto err = validateMessageParameters(message, {"id"});
 
     if (err.type != JSON::Type::Null) {
@@ -1107,18 +1354,15 @@ void initFunctionsTable (Router *router) {
     uint64_t id;
     REQUIRE_AND_GET_MESSAGE_VALUE(id, "id", std::stoull);
 
-    router->core->udp.getSockName(
-      message.seq,
-      id,
-      RESULT_CALLBACK_FROM_CORE_CALLBACK(message, reply)
-    );
+    router->core->relay.getState(message.seq, id, RESULT_CALLBACK_FROM_CORE_CALLBACK(message, reply));
   });
 
   /**
-   * Returns socket state information.
+   * Inserts an encoded packet into the relay packet cache.
    * @param id Handle ID of underlying socket
+   * @param bytes The encoded packet
    */
-  router->map("udp.getState", [=](auto message, auto router, auto reply) {
+  router->map("relay.cacheInsert", [=](auto message, auto router, auto reply) {
     auto err = validateMessageParameters(message, {"id"});
 
     if (err.type != JSON::Type::Null) {
@@ -1128,20 +1372,22 @@ void initFunctionsTable (Router *router) {
     uint64_t id;
     REQUIRE_AND_GET_MESSAGE_VALUE(id, "id", std::stoull);
 
-    router->core->udp.getState(
+    router->core->relay.cacheInsert(
       message.seq,
       id,
+      message.buffer.bytes,
+      message.buffer.size,
       RESULT_CALLBACK_FROM_CORE_CALLBACK(message, reply)
     );
   });
 
   /**
-   * Initializes socket handle to start receiving data from the underlying
-   * socket and route through the IPC bridge to the WebView.
+   * Checks if a packet is in the relay packet cache.
    * @param id Handle ID of underlying socket
+   * @param packetId Hex encoded packet ID
    */
-  router->map("udp.readStart", [=](auto message, auto router, auto reply) {
-    auto err = validateMessageParameters(message, {"id"});
+  router->map("relay.cacheHas", [=](auto message, auto router, auto reply) {
+    auto err = validateMessageParameters(message, {"id", "packetId"});
 
     if (err.type != JSON::Type::Null) {
       return reply(Result::Err { message, err });
@@ -1150,20 +1396,21 @@ void initFunctionsTable (Router *router) {
     uint64_t id;
     REQUIRE_AND_GET_MESSAGE_VALUE(id, "id", std::stoull);
 
-    router->core->udp.readStart(
+    router->core->relay.cacheHas(
       message.seq,
       id,
+      message.get("packetId"),
       RESULT_CALLBACK_FROM_CORE_CALLBACK(message, reply)
     );
   });
 
   /**
-   * Stops socket handle from receiving data from the underlying
-   * socket and routing through the IPC bridge to the WebView.
+   * Gets an encoded packet from the relay packet cache.
    * @param id Handle ID of underlying socket
+   * @param packetId Hex encoded packet ID
    */
-  router->map("udp.readStop", [=](auto message, auto router, auto reply) {
-    auto err = validateMessageParameters(message, {"id"});
+  router->map("relay.cacheGet", [=](auto message, auto router, auto reply) {
+    auto err = validateMessageParameters(message, {"id", "packetId"});
 
     if (err.type != JSON::Type::Null) {
       return reply(Result::Err { message, err });
@@ -1172,58 +1419,830 @@ void initFunctionsTable (Router *router) {
     uint64_t id;
     REQUIRE_AND_GET_MESSAGE_VALUE(id, "id", std::stoull);
 
-    router->core->udp.readStop(
+    router->core->relay.cacheGet(
       message.seq,
       id,
+      message.get("packetId"),
       RESULT_CALLBACK_FROM_CORE_CALLBACK(message, reply)
     );
   });
 
   /**
-   * Broadcasts a datagram on the socket. For connectionless sockets, the
-   * destination port and address must be specified. Connected sockets, on the
-   * other hand, will use their associated remote endpoint, so the port and
-   * address arguments must not be set.
+   * Concatenates the messages of the packets that continue a packet chain,
+   * ordered by index.
    * @param id Handle ID of underlying socket
-   * @param port The port to send data to
-   * @param size The size of the bytes to send
-   * @param bytes A pointer to the bytes to send
-   * @param address The address to send to (default: 0.0.0.0)
-   * @param ephemeral Indicates that the socket handle, if created is ephemeral and should eventually be destroyed
+   * @param packetId Hex encoded ID of the head or any part of the chain
    */
-  router->map("udp.send", [=](auto message, auto router, auto reply) {
-    auto err = validateMessageParameters(message, {"id", "port"});
+  router->map("relay.cacheCompose", [=](auto message, auto router, auto reply) {
+    auto err = validateMessageParameters(message, {"id", "packetId"});
 
     if (err.type != JSON::Type::Null) {
       return reply(Result::Err { message, err });
     }
 
-    Core::UDP::SendOptions options;
     uint64_t id;
     REQUIRE_AND_GET_MESSAGE_VALUE(id, "id", std::stoull);
-    REQUIRE_AND_GET_MESSAGE_VALUE(options.port, "port", std::stoi);
-
-    options.size = message.buffer.size;
-    options.bytes = message.buffer.bytes;
-    options.address = message.get("address", "0.0.0.0");
-    options.ephemeral = message.get("ephemeral") == "true";
 
-    router->core->udp.send(
+    router->core->relay.cacheCompose(
       message.seq,
       id,
-      options,
+      message.get("packetId"),
       RESULT_CALLBACK_FROM_CORE_CALLBACK(message, reply)
     );
   });
-}
 
-static void registerSchemeHandler (Router *router) {
-#if defined(__linux__) && !defined(__ANDROID__)
-  // prevent this function from registering the `ipc://`
-  // URI scheme handler twice
-  static std::atomic<bool> registered = false;
-  if (registered) return;
-  registered = true;
+  /**
+   * Writes the relay packet cache to a file.
+   * @param id Handle ID of underlying socket
+   * @param path The path of the snapshot file
+   */
+  router->map("relay.cacheSnapshot", [=](auto message, auto router, auto reply) {
+    auto err = validateMessageParameters(message, {"id", "path"});
+
+    if (err.type != JSON::Type::Null) {
+      return reply(Result::Err { message, err });
+    }
+
+    uint64_t id;
+    REQUIRE_AND_GET_MESSAGE_VALUE(id, "id", std::stoull);
+
+    router->core->relay.cacheSnapshot(
+      message.seq,
+      id,
+      message.get("path"),
+      RESULT_CALLBACK_FROM_CORE_CALLBACK(message, reply)
+    );
+  });
+
+  /**
+   * Inserts the packets of a snapshot into the relay packet cache.
+   * @param id Handle ID of underlying socket
+   * @param path The path of the snapshot file
+   */
+  router->map("relay.cacheRestore", [=](auto message, auto router, auto reply) {
+    auto err = validateMessageParameters(message, {"id", "path"});
+
+    if (err.type != JSON::Type::Null) {
+      return reply(Result::Err { message, err });
+    }
+
+    uint64_t id;
+    REQUIRE_AND_GET_MESSAGE_VALUE(id, "id", std::stoull);
+
+    router->core->relay.cacheRestore(
+      message.seq,
+      id,
+      message.get("path"),
+      RESULT_CALLBACK_FROM_CORE_CALLBACK(message, reply)
+    );
+  });
+
+  /**
+   * Prints incoming message value to stdout.
+   */
+  router->map("stdout", [=](auto message, auto router, auto reply) {
+  #if defined(__APPLE__)
+    os_log_with_type(SSC_OS_LOG_BUNDLE, OS_LOG_TYPE_INFO, "%{public}s", message.value.c_str());
+  #endif
+    stdWrite(message.value, false);
+  });
+
+  /**
+   * Prints incoming message value to stderr.
+   */
+  router->map("stderr", [=](auto message, auto router, auto reply) {
+  #if defined(__APPLE__)
+    os_log_with_type(SSC_OS_LOG_BUNDLE, OS_LOG_TYPE_ERROR, "%{public}s", message.value.c_str());
+  #endif
+    stdWrite(message.value, true);
+  });
+
+  /**
+   * Close socket handle and underlying TCP socket or server.
+   * @param id Handle ID of underlying socket
+   */
+  router->map("tcp.close", [=](auto message, auto router, auto reply) {
+    auto err = validateMessageParameters(message, {"id"});
+
+    if (err.type != JSON::Type::Null) {
+      return reply(Result::Err { message, err });
+    }
+
+    uint64_t id;
+    REQUIRE_AND_GET_MESSAGE_VALUE(id, "id", std::stoull);
+
+    router->core->tcp.close(message.seq, id, RESULT_CALLBACK_FROM_CORE_CALLBACK(message, reply));
+  });
+
+  /**
+   * Connects a TCP socket to a remote `address` and `port`.
+   * @param id Handle ID of underlying socket
+   * @param port The port to connect to
+   * @param address The address to connect to (default: 127.0.0.1)
+   */
+  router->map("tcp.connect", [=](auto message, auto router, auto reply) {
+    auto err = validateMessageParameters(message, {"id", "port"});
+
+    if (err.type != JSON::Type::Null) {
+      return reply(Result::Err { message, err });
+    }
+
+    Core::TCP::ConnectOptions options;
+    uint64_t id;
+    REQUIRE_AND_GET_MESSAGE_VALUE(id, "id", std::stoull);
+    REQUIRE_AND_GET_MESSAGE_VALUE(options.port, "port", std::stoi);
+
+    options.address = message.get("address", "127.0.0.1");
+
+    router->core->tcp.connect(
+      message.seq,
+      id,
+      options,
+      RESULT_CALLBACK_FROM_CORE_CALLBACK(message, reply)
+    );
+  });
+
+  /**
+   * Get the remote peer information of a connected TCP socket.
+   * @param id Handle ID of underlying socket
+   */
+  router->map("tcp.getPeerName", [=](auto message, auto router, auto reply) {
+    auto err = validateMessageParameters(message, {"id"});
+
+    if (err.type != JSON::Type::Null) {
+      return reply(Result::Err { message, err });
+    }
+
+    uint64_t id;
+    REQUIRE_AND_GET_MESSAGE_VALUE(id, "id", std::stoull);
+
+    router->core->tcp.getPeerName(message.seq, id, RESULT_CALLBACK_FROM_CORE_CALLBACK(message, reply));
+  });
+
+  /**
+   * Get the local information of a TCP socket or server.
+   * @param id Handle ID of underlying socket
+   */
+  router->map("tcp.getSockName", [=](auto message, auto router, auto reply) {
+    auto err = validateMessageParameters(message, {"id"});
+
+    if (err.type != JSON::Type::Null) {
+      return reply(Result::Err { message, err });
+    }
+
+    uint64_t id;
+    REQUIRE_AND_GET_MESSAGE_VALUE(id, "id", std::stoull);
+
+    router->core->tcp.getSockName(message.seq, id, RESULT_CALLBACK_FROM_CORE_CALLBACK(message, reply));
+  });
+
+  /**
+   * Get the state of a TCP socket or server.
+   * @param id Handle ID of underlying socket
+   */
+  router->map("tcp.getState", [=](auto message, auto router, auto reply) {
+    auto err = validateMessageParameters(message, {"id"});
+
+    if (err.type != JSON::Type::Null) {
+      return reply(Result::Err { message, err });
+    }
+
+    uint64_t id;
+    REQUIRE_AND_GET_MESSAGE_VALUE(id, "id", std::stoull);
+
+    router->core->tcp.getState(message.seq, id, RESULT_CALLBACK_FROM_CORE_CALLBACK(message, reply));
+  });
+
+  /**
+   * Binds a TCP server to `port` and listens for connections. Accepted
+   * connections are emitted as `tcp.listen` events with a `connection` ID
+   * that is used with the other `tcp.*` routes.
+   * @param id Handle ID of underlying server
+   * @param port Port to listen on
+   * @param address The address to bind the server to (default: 0.0.0.0)
+   * @param backlog Maximum pending connections (default: 511)
+   * @param ipv6Only Disable dual-stack for IPv6 addresses (default: false)
+   */
+  router->map("tcp.listen", [=](auto message, auto router, auto reply) {
+    auto err = validateMessageParameters(message, {"id", "port"});
+
+    if (err.type != JSON::Type::Null) {
+      return reply(Result::Err { message, err });
+    }
+
+    Core::TCP::ListenOptions options;
+    uint64_t id;
+    REQUIRE_AND_GET_MESSAGE_VALUE(id, "id", std::stoull);
+    REQUIRE_AND_GET_MESSAGE_VALUE(options.port, "port", std::stoi);
+    REQUIRE_AND_GET_MESSAGE_VALUE(options.backlog, "backlog", std::stoi, "511");
+
+    options.address = message.get("address", "0.0.0.0");
+    options.ipv6Only = message.get("ipv6Only") == "true";
+
+    router->core->tcp.listen(
+      message.seq,
+      id,
+      options,
+      RESULT_CALLBACK_FROM_CORE_CALLBACK(message, reply)
+    );
+  });
+
+  /**
+   * Starts reading from a connected TCP socket and routes the data through
+   * the IPC bridge to the WebView as `tcp.readStart` events.
+   * @param id Handle ID of underlying socket
+   */
+  router->map("tcp.readStart", [=](auto message, auto router, auto reply) {
+    auto err = validateMessageParameters(message, {"id"});
+
+    if (err.type != JSON::Type::Null) {
+      return reply(Result::Err { message, err });
+    }
+
+    uint64_t id;
+    REQUIRE_AND_GET_MESSAGE_VALUE(id, "id", std::stoull);
+
+    router->core->tcp.readStart(message.seq, id, RESULT_CALLBACK_FROM_CORE_CALLBACK(message, reply));
+  });
+
+  /**
+   * Stops reading from a connected TCP socket.
+   * @param id Handle ID of underlying socket
+   */
+  router->map("tcp.readStop", [=](auto message, auto router, auto reply) {
+    auto err = validateMessageParameters(message, {"id"});
+
+    if (err.type != JSON::Type::Null) {
+      return reply(Result::Err { message, err });
+    }
+
+    uint64_t id;
+    REQUIRE_AND_GET_MESSAGE_VALUE(id, "id", std::stoull);
+
+    router->core->tcp.readStop(message.seq, id, RESULT_CALLBACK_FROM_CORE_CALLBACK(message, reply));
+  });
+
+  /**
+   * Enables or disables TCP keep-alive on the socket.
+   * @param id Handle ID of underlying socket
+   * @param enable Enable keep-alive (default: true)
+   * @param delay Initial delay in seconds (default: 0)
+   */
+  router->map("tcp.setKeepAlive", [=](auto message, auto router, auto reply) {
+    auto err = validateMessageParameters(message, {"id"});
+
+    if (err.type != JSON::Type::Null) {
+      return reply(Result::Err { message, err });
+    }
+
+    uint64_t id;
+    unsigned int delay = 0;
+    REQUIRE_AND_GET_MESSAGE_VALUE(id, "id", std::stoull);
+    REQUIRE_AND_GET_MESSAGE_VALUE(delay, "delay", std::stoul, "0");
+
+    router->core->tcp.setKeepAlive(
+      message.seq,
+      id,
+      message.get("enable", "true") == "true",
+      delay,
+      RESULT_CALLBACK_FROM_CORE_CALLBACK(message, reply)
+    );
+  });
+
+  /**
+   * Enables or disables `TCP_NODELAY` (Nagle's algorithm) on the socket.
+   * @param id Handle ID of underlying socket
+   * @param enable Disable Nagle's algorithm (default: true)
+   */
+  router->map("tcp.setNoDelay", [=](auto message, auto router, auto reply) {
+    auto err = validateMessageParameters(message, {"id"});
+
+    if (err.type != JSON::Type::Null) {
+      return reply(Result::Err { message, err });
+    }
+
+    uint64_t id;
+    REQUIRE_AND_GET_MESSAGE_VALUE(id, "id", std::stoull);
+
+    router->core->tcp.setNoDelay(
+      message.seq,
+      id,
+      message.get("enable", "true") == "true",
+      RESULT_CALLBACK_FROM_CORE_CALLBACK(message, reply)
+    );
+  });
+
+  /**
+   * Shuts down the write side of a connected TCP socket.
+   * @param id Handle ID of underlying socket
+   */
+  router->map("tcp.shutdown", [=](auto message, auto router, auto reply) {
+    auto err = validateMessageParameters(message, {"id"});
+
+    if (err.type != JSON::Type::Null) {
+      return reply(Result::Err { message, err });
+    }
+
+    uint64_t id;
+    REQUIRE_AND_GET_MESSAGE_VALUE(id, "id", std::stoull);
+
+    router->core->tcp.shutdown(message.seq, id, RESULT_CALLBACK_FROM_CORE_CALLBACK(message, reply));
+  });
+
+  /**
+   * Writes `message.buffer` to a connected TCP socket. With `batch`, the
+   * buffer holds records of a little endian `uint32` length followed by
+   * bytes that are written together with a single `writev`. The reply
+   * reports `backpressure` once `writeQueueSize` reaches `highWaterMark`,
+   * a `tcp.drain` event follows when the queue is flushed.
+   * @param id Handle ID of underlying socket
+   * @param batch The buffer holds length prefixed records (default: false)
+   * @param highWaterMark Write queue size in bytes to report backpressure at
+   */
+  router->map("tcp.write", [=](auto message, auto router, auto reply) {
+    auto err = validateMessageParameters(message, {"id"});
+
+    if (err.type != JSON::Type::Null) {
+      return reply(Result::Err { message, err });
+    }
+
+    Core::TCP::WriteOptions options;
+    uint64_t id;
+    REQUIRE_AND_GET_MESSAGE_VALUE(id, "id", std::stoull);
+    REQUIRE_AND_GET_MESSAGE_VALUE(
+      options.highWaterMark,
+      "highWaterMark",
+      std::stoull,
+      std::to_string(Core::TCP::DEFAULT_HIGH_WATER_MARK)
+    );
+
+    options.size = message.buffer.size;
+    options.bytes = message.buffer.bytes;
+    options.batch = message.get("batch") == "true";
+
+    router->core->tcp.write(
+      message.seq,
+      id,
+      options,
+      RESULT_CALLBACK_FROM_CORE_CALLBACK(message, reply)
+    );
+  });
+
+  /**
+   * Binds an UDP socket to a specified port, and optionally a host
+   * address (default: 0.0.0.0).
+   * @param id Handle ID of underlying socket
+   * @param port Port to bind the UDP socket to
+   * @param address The address to bind the UDP socket to (default: 0.0.0.0)
+   * @param reuseAddr Reuse underlying UDP socket address (default: false)
+   * @param ipv6Only Disable dual-stack for IPv6 addresses (default: false)
+   * @param gro Receive coalesced datagrams where supported (default: false)
+   */
+  router->map("udp.bind", [=](auto message, auto router, auto reply) {
+    Core::UDP::BindOptions options;
+    auto err = validateMessageParameters(message, {"id", "port"});
+
+    if (err.type != JSON::Type::Null) {
+      return reply(Result::Err { message, err });
+    }
+
+    uint64_t id;
+    REQUIRE_AND_GET_MESSAGE_VALUE(id, "id", std::stoull);
+    REQUIRE_AND_GET_MESSAGE_VALUE(options.port, "port", std::stoi);
+
+    options.reuseAddr = message.get("reuseAddr") == "true";
+    options.ipv6Only = message.get("ipv6Only") == "true";
+    options.gro = message.get("gro") == "true";
+    options.address = message.get("address", "0.0.0.0");
+
+    router->core->udp.bind(
+      message.seq,
+      id,
+      options,
+      RESULT_CALLBACK_FROM_CORE_CALLBACK(message, reply)
+    );
+  });
+
+  /**
+   * Close socket handle and underlying UDP socket.
+   * @param id Handle ID of underlying socket
+   */
+  router->map("udp.close", [=](auto message, auto router, auto reply) {
+    auto err = validateMessageParameters(message, {"id"});
+
+    if (err.type != JSON::Type::Null) {
+      return reply(Result::Err { message, err });
+    }
+
+    uint64_t id;
+    REQUIRE_AND_GET_MESSAGE_VALUE(id, "id", std::stoull);
+
+    router->core->udp.close(message.seq, id, RESULT_CALLBACK_FROM_CORE_CALLBACK(message, reply));
+  });
+
+  /**
+   * Connects an UDP socket to a specified port, and optionally a host
+   * address (default: 0.0.0.0).
+   * @param id Handle ID of underlying socket
+   * @param port Port to connect the UDP socket to
+   * @param address The address to connect the UDP socket to (default: 0.0.0.0)
+   */
+  router->map("udp.connect", [=](auto message, auto router, auto reply) {
+    auto err = validateMessageParameters(message, {"id", "port"});
+
+    if (err.type != JSON::Type::Null) {
+      return reply(Result::Err { message, err });
+    }
+
+    Core::UDP::ConnectOptions options;
+    uint64_t id;
+    REQUIRE_AND_GET_MESSAGE_VALUE(id, "id", std::stoull);
+    REQUIRE_AND_GET_MESSAGE_VALUE(options.port, "port", std::stoi);
+
+    options.address = message.get("address", "0.0.0.0");
+
+    router->core->udp.connect(
+      message.seq,
+      id,
+      options,
+      RESULT_CALLBACK_FROM_CORE_CALLBACK(message, reply)
+    );
+  });
+
+  /**
+   * Disconnects a connected socket handle and underlying UDP socket.
+   * @param id Handle ID of underlying socket
+   */
+  router->map("udp.disconnect", [=](auto message, auto router, auto reply) {
+    auto err = validateMessageParameters(message, {"id"});
+
+    if (err.type != JSON::Type::Null) {
+      return reply(Result::Err { message, err });
+    }
+
+    uint64_t id;
+    REQUIRE_AND_GET_MESSAGE_VALUE(id, "id", std::stoull);
+
+    router->core->udp.disconnect(
+      message.seq,
+      id,
+      RESULT_CALLBACK_FROM_CORE_CALLBACK(message, reply)
+    );
+  });
+
+  /**
+   * Returns connected peer socket address information.
+   * @param id Handle ID of underlying socket
+   */
+  router->map("udp.getPeerName", [=](auto message, auto router, auto reply) {
+    auto err = validateMessageParameters(message, {"id"});
+
+    if (err.type != JSON::Type::Null) {
+      return reply(Result::Err { message, err });
+    }
+
+    uint64_t id;
+    REQUIRE_AND_GET_MESSAGE_VALUE(id, "id", std::stoull);
+
+    router->core->udp.getPeerName(
+      message.seq,
+      id,
+      RESULT_CALLBACK_FROM_CORE_CALLBACK(message, reply)
+    );
+  });
+
+  /**
+   * Returns local socket address information.
+   * @param id Handle ID of underlying socket
+   */
+  router->map("udp.getSockName", [=](auto message, auto router, auto reply) {
+    auto err = validateMessageParameters(message, {"id"});
+
+    if (err.type != JSON::Type::Null) {
+      return reply(Result::Err { message, err });
+    }
+
+    uint64_t id;
+    REQUIRE_AND_GET_MESSAGE_VALUE(id, "id", std::stoull);
+
+    router->core->udp.getSockName(
+      message.seq,
+      id,
+      RESULT_CALLBACK_FROM_CORE_CALLBACK(message, reply)
+    );
+  });
+
+  /**
+   * Returns socket state information.
+   * @param id Handle ID of underlying socket
+   */
+  router->map("udp.getState", [=](auto message, auto router, auto reply) {
+    auto err = validateMessageParameters(message, {"id"});
+
+    if (err.type != JSON::Type::Null) {
+      return reply(Result::Err { message, err });
+    }
+
+    uint64_t id;
+    REQUIRE_AND_GET_MESSAGE_VALUE(id, "id", std::stoull);
+
+    router->core->udp.getState(
+      message.seq,
+      id,
+      RESULT_CALLBACK_FROM_CORE_CALLBACK(message, reply)
+    );
+  });
+
+  /**
+   * Returns the keepalive targets of a socket and their reachability.
+   * @param id Handle ID of underlying socket
+   */
+  router->map("udp.keepaliveGetState", [=](auto message, auto router, auto reply) {
+    auto err = validateMessageParameters(message, {"id"});
+
+    if (err.type != JSON::Type::Null) {
+      return reply(Result::Err { message, err });
+    }
+
+    uint64_t id;
+    REQUIRE_AND_GET_MESSAGE_VALUE(id, "id", std::stoull);
+
+    router->core->udp.keepaliveGetState(
+      message.seq,
+      id,
+      RESULT_CALLBACK_FROM_CORE_CALLBACK(message, reply)
+    );
+  });
+
+  /**
+   * Sends keepalive datagrams from a bound socket to a batch of endpoints on
+   * native timers. Unreachable endpoints are probed every `punchInterval`
+   * for up to `punchAttempts` times (hole punching), then every `interval`.
+   * Reachability changes are emitted as `udp.keepalive` events. The message
+   * body, if any, is the keepalive payload.
+   * @param id Handle ID of underlying socket
+   * @param targets Comma separated `address:port` endpoints
+   * @param interval Keepalive interval in milliseconds (default: 25000)
+   * @param timeout Milliseconds without a datagram from an endpoint before it is unreachable (default: 3 intervals)
+   * @param punchAttempts Probes sent while an endpoint is unreachable (default: 8)
+   * @param punchInterval Milliseconds between probes (default: 500)
+   */
+  router->map("udp.keepaliveStart", [=](auto message, auto router, auto reply) {
+    auto err = validateMessageParameters(message, {"id", "targets"});
+
+    if (err.type != JSON::Type::Null) {
+      return reply(Result::Err { message, err });
+    }
+
+    Core::UDP::KeepaliveOptions options;
+    uint64_t id;
+    uint64_t interval;
+    uint64_t timeout;
+    unsigned int punchAttempts;
+    uint64_t punchInterval;
+
+    REQUIRE_AND_GET_MESSAGE_VALUE(id, "id", std::stoull);
+    REQUIRE_AND_GET_MESSAGE_VALUE(interval, "interval", std::stoull, "25000");
+    REQUIRE_AND_GET_MESSAGE_VALUE(timeout, "timeout", std::stoull, "0");
+    REQUIRE_AND_GET_MESSAGE_VALUE(punchAttempts, "punchAttempts", std::stoul, "8");
+    REQUIRE_AND_GET_MESSAGE_VALUE(punchInterval, "punchInterval", std::stoull, "500");
+
+    if (!parseKeepaliveTargets(message.get("targets"), options.targets)) {
+      return reply(Result::Err { message, JSON::Object::Entries {
+        {"message", "Invalid 'targets' given, expecting 'address:port' entries"}
+      }});
+    }
+
+    if (interval == 0 || punchInterval == 0) {
+      return reply(Result::Err { message, JSON::Object::Entries {
+        {"message", "Keepalive intervals must be greater than 0"}
+      }});
+    }
+
+    for (auto& target : options.targets) {
+      target.interval = interval;
+      target.timeout = timeout;
+      target.punchAttempts = punchAttempts;
+      target.punchInterval = punchInterval;
+    }
+
+    if (message.buffer.bytes != nullptr && message.buffer.size > 0) {
+      options.payload = String(message.buffer.bytes, message.buffer.size);
+    }
+
+    router->core->udp.keepaliveStart(
+      message.seq,
+      id,
+      options,
+      RESULT_CALLBACK_FROM_CORE_CALLBACK(message, reply)
+    );
+  });
+
+  /**
+   * Stops keepalives to some or all endpoints of a socket.
+   * @param id Handle ID of underlying socket
+   * @param targets Comma separated `address:port` endpoints (default: all)
+   */
+  router->map("udp.keepaliveStop", [=](auto message, auto router, auto reply) {
+    auto err = validateMessageParameters(message, {"id"});
+
+    if (err.type != JSON::Type::Null) {
+      return reply(Result::Err { message, err });
+    }
+
+    Vector<Peer::KeepaliveTarget> targets;
+    uint64_t id;
+    REQUIRE_AND_GET_MESSAGE_VALUE(id, "id", std::stoull);
+
+    if (!parseKeepaliveTargets(message.get("targets"), targets)) {
+      return reply(Result::Err { message, JSON::Object::Entries {
+        {"message", "Invalid 'targets' given, expecting 'address:port' entries"}
+      }});
+    }
+
+    router->core->udp.keepaliveStop(
+      message.seq,
+      id,
+      targets,
+      RESULT_CALLBACK_FROM_CORE_CALLBACK(message, reply)
+    );
+  });
+
+  /**
+   * Initializes socket handle to start receiving data from the underlying
+   * socket and route through the IPC bridge to the WebView.
+   * @param id Handle ID of underlying socket
+   */
+  router->map("udp.readStart", [=](auto message, auto router, auto reply) {
+    auto err = validateMessageParameters(message, {"id"});
+
+    if (err.type != JSON::Type::Null) {
+      return reply(Result::Err { message, err });
+    }
+
+    uint64_t id;
+    REQUIRE_AND_GET_MESSAGE_VALUE(id, "id", std::stoull);
+
+    router->core->udp.readStart(
+      message.seq,
+      id,
+      RESULT_CALLBACK_FROM_CORE_CALLBACK(message, reply)
+    );
+  });
+
+  /**
+   * Stops socket handle from receiving data from the underlying
+   * socket and routing through the IPC bridge to the WebView.
+   * @param id Handle ID of underlying socket
+   */
+  router->map("udp.readStop", [=](auto message, auto router, auto reply) {
+    auto err = validateMessageParameters(message, {"id"});
+
+    if (err.type != JSON::Type::Null) {
+      return reply(Result::Err { message, err });
+    }
+
+    uint64_t id;
+    REQUIRE_AND_GET_MESSAGE_VALUE(id, "id", std::stoull);
+
+    router->core->udp.readStop(
+      message.seq,
+      id,
+      RESULT_CALLBACK_FROM_CORE_CALLBACK(message, reply)
+    );
+  });
+
+  /**
+   * Broadcasts a datagram on the socket. For connectionless sockets, the
+   * destination port and address must be specified. Connected sockets, on the
+   * other hand, will use their associated remote endpoint, so the port and
+   * address arguments must not be set.
+   * @param id Handle ID of underlying socket
+   * @param port The port to send data to
+   * @param size The size of the bytes to send
+   * @param bytes A pointer to the bytes to send
+   * @param address The address to send to (default: 0.0.0.0)
+   * @param ephemeral Indicates that the socket handle, if created is ephemeral and should eventually be destroyed
+   * @param segmentSize Split the bytes into datagrams of this size, offloaded to the kernel where supported (default: 0)
+   */
+  router->map("udp.send", [=](auto message, auto router, auto reply) {
+    auto err = validateMessageParameters(message, {"id", "port"});
+
+    if (err.type != JSON::Type::Null) {
+      return reply(Result::Err { message, err });
+    }
+
+    Core::UDP::SendOptions options;
+    uint64_t id;
+    REQUIRE_AND_GET_MESSAGE_VALUE(id, "id", std::stoull);
+    REQUIRE_AND_GET_MESSAGE_VALUE(options.port, "port", std::stoi);
+    REQUIRE_AND_GET_MESSAGE_VALUE(options.segmentSize, "segmentSize", std::stoull, "0");
+
+    options.size = message.buffer.size;
+    options.bytes = message.buffer.bytes;
+    options.address = message.get("address", "0.0.0.0");
+    options.ephemeral = message.get("ephemeral") == "true";
+
+    router->core->udp.send(
+      message.seq,
+      id,
+      options,
+      RESULT_CALLBACK_FROM_CORE_CALLBACK(message, reply)
+    );
+  });
+}
+
+#if defined(__linux__) && !defined(__ANDROID__)
+// `socket:` module proxies keyed by module path. The proxy body does not
+// depend on the query, so cache busting imports like `?t=...` share one
+// entry and the map is bounded by the number of modules. Entries are
+// rendered once and never removed, so their bytes can be handed to WebKit
+// as is.
+static struct { Mutex mutex; std::map<String, String> sources; } moduleProxies;
+
+// The URL a `socket:` module path, like `fs/promises.js`, is loaded from.
+static String getModuleURL (const String& path) {
+  static auto root = fs::path(getcwd()) / "socket";
+  auto archive = getResourcesArchive();
+
+  if (archive != nullptr && archive->find("socket/" + path) != nullptr) {
+    return "resources:///socket/" + path;
+  }
+
+  return "file://" + (root / path).string();
+}
+
+// The paths of all modules in the `socket/` resources directory, packed or
+// on disk.
+static std::set<String> getModulePaths () {
+  auto root = fs::path(getcwd()) / "socket";
+  auto archive = getResourcesArchive();
+  std::set<String> paths;
+  std::error_code ec;
+
+  if (archive != nullptr) {
+    for (const auto& tuple : archive->getEntries()) {
+      auto path = String(tuple.first);
+      if (path.starts_with("socket/") && path.ends_with(".js")) {
+        paths.insert(path.substr(7));
+      }
+    }
+  }
+
+  for (const auto& entry : fs::recursive_directory_iterator(root, ec)) {
+    auto path = entry.path();
+    if (entry.is_regular_file(ec) && path.extension() == ".js") {
+      paths.insert(fs::relative(path, root).generic_string());
+    }
+  }
+
+  return paths;
+}
+
+static const String& getModuleProxySource (const String& uri) {
+  auto specifier = uri.substr(0, uri.find_first_of('#'));
+  specifier = specifier.substr(0, specifier.find('?'));
+
+  if (specifier.starts_with("socket:///")) {
+    specifier = specifier.substr(10);
+  } else if (specifier.starts_with("socket://")) {
+    specifier = specifier.substr(9);
+  } else if (specifier.starts_with("socket:")) {
+    specifier = specifier.substr(7);
+  }
+
+  if (!specifier.ends_with(".js")) {
+    specifier += ".js";
+  }
+
+  Lock lock(moduleProxies.mutex);
+  auto cached = moduleProxies.sources.find(specifier);
+
+  if (cached != moduleProxies.sources.end()) {
+    return cached->second;
+  }
+
+  auto url = getModuleURL(specifier);
+  auto source = trim(tmpl(moduleTemplate, Map { {"url", url} }));
+  return moduleProxies.sources.emplace(specifier, source).first->second;
+}
+
+// Renders the proxy of every module in the `socket/` resources directory
+// ahead of the first import.
+static void preloadModuleProxies () {
+  for (const auto& path : getModulePaths()) {
+    getModuleProxySource("socket:" + path);
+  }
+}
+#endif
+
+static void registerSchemeHandler (Router *router) {
+#if defined(__linux__) && !defined(__ANDROID__)
+  // prevent this function from registering the `ipc://`
+  // URI scheme handler twice
+  static std::atomic<bool> registered = false;
+  if (registered) return;
+  registered = true;
 
   auto ctx = webkit_web_context_get_default();
   auto security = webkit_web_context_get_security_manager(ctx);
@@ -1301,32 +2320,108 @@ static void registerSchemeHandler (Router *router) {
 
   webkit_web_context_register_uri_scheme(ctx, "socket", [](auto request, auto ptr) {
     auto uri = String(webkit_uri_scheme_request_get_uri(request));
-    auto cwd = getcwd();
+    auto& moduleSource = getModuleProxySource(uri);
+
+    // the cache owns the bytes for the lifetime of the process
+    auto size = moduleSource.size();
+    auto bytes = moduleSource.data();
+    auto stream = g_memory_input_stream_new_from_data(bytes, size, nullptr);
+    auto response = webkit_uri_scheme_response_new(stream, size);
+
+    webkit_uri_scheme_response_set_content_type(response, SOCKET_MODULE_CONTENT_TYPE);
+    webkit_uri_scheme_request_finish_with_response(request, response);
+    g_object_unref(stream);
+  },
+  router,
+  0);
+
+  if (getUserSettings().getBool("core_preload_modules")) {
+    std::thread(preloadModuleProxies).detach();
+  }
+
+  // serves resources packed by `ssc build` when `[build] archive` is set
+  // straight from the memory mapped archive, and anything else, like files
+  // written after the build, from the resources directory
+  webkit_web_context_register_uri_scheme(ctx, "resources", [](auto request, auto ptr) {
+    auto uri = String(webkit_uri_scheme_request_get_uri(request));
+    auto archive = getResourcesArchive();
+    auto path = uri.substr(String("resources:").size());
+
+    path = path.substr(0, path.find_first_of("?#"));
+    path = path.substr(std::min(path.find_first_not_of('/'), path.size()));
 
-    if (uri.starts_with("socket:///")) {
-      uri = uri.substr(10);
-    } else if (uri.starts_with("socket://")) {
-      uri = uri.substr(9);
-    } else if (uri.starts_with("socket:")) {
-      uri = uri.substr(7);
+    if (path.size() == 0 || path.ends_with("/")) {
+      path += "index.html";
     }
 
-    auto ext = uri.ends_with(".js") ? "" : ".js";
-    auto path = fs::path(cwd) / "socket" / (uri + ext);
+    auto unescaped = g_uri_unescape_string(path.c_str(), nullptr);
+    if (unescaped != nullptr) {
+      path = unescaped;
+      g_free(unescaped);
+    }
 
-    uri = "file://" + path.string();
-    auto moduleSource = trim(tmpl(
-      moduleTemplate,
-      Map { {"url", String(uri)} }
-    ));
+    auto entry = archive != nullptr ? archive->find(path) : nullptr;
+
+    if (entry == nullptr) {
+      auto file = fs::path(path).lexically_normal();
+      auto filename = fs::path(getcwd()) / file;
+      std::error_code ec;
+
+      if (
+        file.is_relative() &&
+        !file.string().starts_with("..") &&
+        fs::is_regular_file(filename, ec)
+      ) {
+        auto handle = g_file_new_for_path(filename.c_str());
+        auto stream = g_file_read(handle, nullptr, nullptr);
+        g_object_unref(handle);
+
+        if (stream != nullptr) {
+          auto response = webkit_uri_scheme_response_new(
+            G_INPUT_STREAM(stream),
+            (gint64) fs::file_size(filename, ec)
+          );
+
+          auto mimeType = Archive::getMimeType(path);
+          webkit_uri_scheme_response_set_content_type(response, mimeType.c_str());
+          webkit_uri_scheme_request_finish_with_response(request, response);
+          g_object_unref(response);
+          g_object_unref(stream);
+          return;
+        }
+      }
+
+      auto error = g_error_new(
+        G_IO_ERROR,
+        G_IO_ERROR_NOT_FOUND,
+        "Resource not found: %s",
+        uri.c_str()
+      );
+
+      webkit_uri_scheme_request_finish_error(request, error);
+      g_error_free(error);
+      return;
+    }
+
+    // the mapping outlives every request, so the bytes are not copied
+    auto stream = g_memory_input_stream_new_from_data(entry->bytes, entry->size, nullptr);
+    auto size = (gint64) entry->size;
+
+    if (entry->encoding == Archive::Encoding::Gzip) {
+      auto decompressor = g_zlib_decompressor_new(G_ZLIB_COMPRESSOR_FORMAT_GZIP);
+      auto decoded = g_converter_input_stream_new(stream, G_CONVERTER(decompressor));
+      g_object_unref(decompressor);
+      g_object_unref(stream);
+      stream = decoded;
+      size = (gint64) entry->decodedSize;
+    }
 
-    auto size = moduleSource.size();
-    auto bytes = moduleSource.data();
-    auto stream = g_memory_input_stream_new_from_data(bytes, size, 0);
     auto response = webkit_uri_scheme_response_new(stream, size);
+    auto mimeType = String(entry->mimeType);
 
-    webkit_uri_scheme_response_set_content_type(response, SOCKET_MODULE_CONTENT_TYPE);
+    webkit_uri_scheme_response_set_content_type(response, mimeType.c_str());
     webkit_uri_scheme_request_finish_with_response(request, response);
+    g_object_unref(response);
     g_object_unref(stream);
   },
   router,
@@ -1341,6 +2436,10 @@ static void registerSchemeHandler (Router *router) {
   webkit_security_manager_register_uri_scheme_as_cors_enabled(security, "socket");
   webkit_security_manager_register_uri_scheme_as_secure(security, "socket");
   webkit_security_manager_register_uri_scheme_as_local(security, "socket");
+
+  webkit_security_manager_register_uri_scheme_as_cors_enabled(security, "resources");
+  webkit_security_manager_register_uri_scheme_as_secure(security, "resources");
+  webkit_security_manager_register_uri_scheme_as_local(security, "resources");
 #endif
 }
 
@@ -1573,6 +2672,51 @@ static void registerSchemeHandler (Router *router) {
 #endif
 
 namespace SSC::IPC {
+  String getModuleImportMap () {
+  #if defined(__linux__) && !defined(__ANDROID__)
+    static String importMap;
+    static std::once_flag once;
+
+    std::call_once(once, [] {
+      if (!getUserSettings().getBool("core_preload_modules")) {
+        return;
+      }
+
+      JSON::Object::Entries imports;
+
+      // both `socket:fs` and `socket:fs.js` name the same module
+      for (const auto& path : getModulePaths()) {
+        auto url = getModuleURL(path);
+        imports["socket:" + path] = url;
+        imports["socket:" + path.substr(0, path.size() - 3)] = url;
+      }
+
+      importMap = JSON::Object(JSON::Object::Entries {
+        {"imports", imports}
+      }).str();
+    });
+
+    return importMap;
+  #else
+    return "";
+  #endif
+  }
+
+  const Archive* getResourcesArchive () {
+  #if defined(__linux__) && !defined(__ANDROID__)
+    static Archive archive;
+    static std::once_flag once;
+
+    std::call_once(once, [] {
+      archive.open(fs::path(getcwd()) / "resources.pack");
+    });
+
+    return archive.isOpen() ? &archive : nullptr;
+  #else
+    return nullptr;
+  #endif
+  }
+
   Bridge::Bridge (Core *core) : router() {
     this->core = core;
     this->router.core = core;
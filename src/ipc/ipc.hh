@@ -6,6 +6,14 @@
 namespace SSC::IPC {
   class Router;
   class Bridge;
+
+  // the archive written by `ssc build` when `[build] archive` is set,
+  // or `nullptr` if the application resources are not packed
+  const Archive* getResourcesArchive ();
+
+  // an import map resolving every `socket:` module straight to its file
+  // when `[core] preload_modules` is set (Linux only), or an empty string
+  String getModuleImportMap ();
 }
 
 // create a proxy module so imports of the module of concern are imported
@@ -9,6 +9,11 @@
 #define WEXITSTATUS(w) (((w) & 0xff00) >> 8)
 #endif
 
+#include <algorithm>
+#include <cstring>
+#include <future>
+#include <uv.h>
+
 #include "../common.hh"
 
 namespace SSC {
@@ -17,6 +22,140 @@ namespace SSC {
     int exitCode = 0;
   };
 
+  // A frame of the binary stdout/stdin protocol of a process. Each frame
+  // is a header of `HEADER_SIZE` bytes, all fields big endian, followed by
+  // `size` bytes of payload:
+  //
+  //   | size (u32) | type (u8) | reserved (u8) | index (i16) | bytes ... |
+  //
+  // `index` is the target window index, or -1 for any window.
+  struct ProcessFrame {
+    static constexpr std::size_t HEADER_SIZE = 8;
+    static constexpr std::size_t MAX_SIZE = 64 * 1024 * 1024;
+
+    enum class Type : uint8_t {
+      // payload is an `ipc://` message, as a line in the text protocol
+      message = 0,
+      // payload is opaque bytes for the target window
+      data = 1
+    };
+
+    Type type = Type::message;
+    int index = -1;
+    // points into the reader's buffer, only valid during the callback
+    const char *bytes = nullptr;
+    std::size_t size = 0;
+
+    static void encodeHeader (
+      unsigned char *header,
+      Type type,
+      int index,
+      std::size_t size
+    ) {
+      header[0] = (unsigned char) (size >> 24);
+      header[1] = (unsigned char) (size >> 16);
+      header[2] = (unsigned char) (size >> 8);
+      header[3] = (unsigned char) size;
+      header[4] = (unsigned char) type;
+      header[5] = 0;
+      header[6] = (unsigned char) (((int16_t) index) >> 8);
+      header[7] = (unsigned char) ((int16_t) index);
+    }
+  };
+
+  using ProcessFrameCallback = std::function<void(const ProcessFrame&)>;
+
+  // Reads framed stdout into one buffer that is reused across reads. Bytes
+  // are read directly into the free tail of the buffer and complete frames
+  // are handed to the callback in place, without copying. Consumed space is
+  // reclaimed by moving the trailing partial frame to the front, and the
+  // buffer only grows for frames larger than its capacity.
+  class ProcessFrameReader {
+    public:
+      std::unique_ptr<char[]> buffer;
+      std::size_t capacity = 0;
+      std::size_t start = 0;
+      std::size_t end = 0;
+
+      ProcessFrameReader (std::size_t capacity) {
+        this->capacity = capacity;
+        this->buffer = std::unique_ptr<char[]>(new char[capacity]);
+      }
+
+      // The free space to read into, reclaiming consumed space if needed.
+      char* tail () {
+        if (this->start > 0 && this->end == this->capacity) {
+          auto pending = this->end - this->start;
+          memmove(this->buffer.get(), this->buffer.get() + this->start, pending);
+          this->start = 0;
+          this->end = pending;
+        }
+
+        return this->buffer.get() + this->end;
+      }
+
+      std::size_t available () const {
+        return this->capacity - this->end;
+      }
+
+      // Marks `size` bytes at `tail()` as read and emits complete frames.
+      // Returns `false` if the stream is corrupt and was discarded.
+      bool commit (std::size_t size, const ProcessFrameCallback& callback) {
+        this->end += size;
+
+        while (this->end - this->start >= ProcessFrame::HEADER_SIZE) {
+          auto header = (const unsigned char *) this->buffer.get() + this->start;
+          auto length = (
+            ((std::size_t) header[0] << 24) |
+            ((std::size_t) header[1] << 16) |
+            ((std::size_t) header[2] << 8) |
+            ((std::size_t) header[3])
+          );
+
+          if (length > ProcessFrame::MAX_SIZE) {
+            this->start = this->end = 0;
+            return false;
+          }
+
+          auto total = ProcessFrame::HEADER_SIZE + length;
+
+          if (this->end - this->start < total) {
+            if (total > this->capacity) {
+              this->grow(total);
+            }
+
+            break;
+          }
+
+          ProcessFrame frame;
+          frame.type = (ProcessFrame::Type) header[4];
+          frame.index = (int16_t) ((header[6] << 8) | header[7]);
+          frame.bytes = this->buffer.get() + this->start + ProcessFrame::HEADER_SIZE;
+          frame.size = length;
+
+          callback(frame);
+          this->start += total;
+        }
+
+        if (this->start == this->end) {
+          this->start = this->end = 0;
+        }
+
+        return true;
+      }
+
+    private:
+      void grow (std::size_t capacity) {
+        auto pending = this->end - this->start;
+        auto buffer = std::unique_ptr<char[]>(new char[capacity]);
+        memcpy(buffer.get(), this->buffer.get() + this->start, pending);
+        this->buffer = std::move(buffer);
+        this->capacity = capacity;
+        this->start = 0;
+        this->end = pending;
+      }
+  };
+
   // Additional parameters to Process constructors.
   struct ProcessConfig {
     // Buffer size for reading stdout and stderr. Default is 131072 (128 kB).
@@ -45,17 +184,36 @@ namespace SSC {
     };
     // On Windows only: controls how the window is shown.
     ShowWindow show_window{ShowWindow::show_default};
+    // Set to read stdout as binary `ProcessFrame`s instead of lines and to
+    // frame writes to stdin. `read_stdout` is not called when this is set.
+    ProcessFrameCallback read_stdout_frame = nullptr;
+
+    // Unix only: set to spawn the process with `uv_spawn()` and attach its
+    // stdio pipes to this loop instead of a dedicated poll thread. Read and
+    // exit callbacks are then called on the loop thread. Has no effect for
+    // processes started from a function.
+    uv_loop_t *loop = nullptr;
+    // Required with `loop`: schedules a function to run on the loop thread.
+    std::function<void(std::function<void()>)> dispatch = nullptr;
+    // With `loop`, writes are queued and `write()` returns false while more
+    // than this many bytes are waiting to be written. Default is 8 MB.
+    std::size_t write_queue_size_limit = 8 * 1024 * 1024;
   };
 
-  inline ExecOutput exec (SSC::String command) {
+  // Called with output as it is read from a command. Called from a
+  // background thread when the command runs with `execAsync()` or `execAll()`.
+  using ExecOutputCallback = std::function<void(const char *, std::size_t)>;
+
+  constexpr std::size_t EXEC_BUFFER_SIZE = 64 * 1024;
+
+  inline ExecOutput exec (SSC::String command, const ExecOutputCallback& onOutput) {
     command = command + " 2>&1";
 
     ExecOutput eo;
     FILE* pipe;
     size_t count;
     int exitCode = 0;
-    const int bufsize = 128;
-    std::array<char, 128> buffer;
+    auto buffer = std::unique_ptr<char[]>(new char[EXEC_BUFFER_SIZE]);
 
     #ifdef _WIN32
       //
@@ -73,8 +231,12 @@ namespace SSC {
     }
 
     do {
-      if ((count = fread(buffer.data(), 1, bufsize, pipe)) > 0) {
-        eo.output.insert(eo.output.end(), std::begin(buffer), std::next(std::begin(buffer), count));
+      if ((count = fread(buffer.get(), 1, EXEC_BUFFER_SIZE, pipe)) > 0) {
+        eo.output.append(buffer.get(), count);
+
+        if (onOutput != nullptr) {
+          onOutput(buffer.get(), count);
+        }
       }
     } while (count > 0);
 
@@ -96,6 +258,50 @@ namespace SSC {
     return eo;
   }
 
+  inline ExecOutput exec (SSC::String command) {
+    return exec(command, nullptr);
+  }
+
+  // Runs `command` on a background thread. Call `get()` on the returned
+  // future before `exit()`, which does not wait for it.
+  inline std::future<ExecOutput> execAsync (
+    SSC::String command,
+    ExecOutputCallback onOutput = nullptr
+  ) {
+    return std::async(std::launch::async, [command, onOutput]() {
+      return exec(command, onOutput);
+    });
+  }
+
+  // Runs independent `commands` with at most `concurrency` of them at once,
+  // or one per hardware thread if it is 0. Outputs are in command order.
+  inline Vector<ExecOutput> execAll (
+    const Vector<SSC::String>& commands,
+    std::size_t concurrency = 0
+  ) {
+    Vector<ExecOutput> outputs(commands.size());
+    Vector<std::thread> workers;
+    std::atomic<std::size_t> next = 0;
+
+    if (concurrency == 0) {
+      concurrency = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    for (std::size_t i = 0; i < std::min(concurrency, commands.size()); ++i) {
+      workers.emplace_back([&]() {
+        for (auto j = next++; j < commands.size(); j = next++) {
+          outputs[j] = exec(commands[j]);
+        }
+      });
+    }
+
+    for (auto& worker : workers) {
+      worker.join();
+    }
+
+    return outputs;
+  }
+
   // Platform independent class for creating processes.
   // Note on Windows: it seems not possible to specify which pipes to redirect.
   // Thus, at the moment, if read_stdout==nullptr, read_stderr==nullptr and open_stdin==false,
@@ -117,14 +323,15 @@ namespace SSC {
     SSC::String path;
     std::atomic<bool> closed = true;
     std::atomic<int> status = -1;
-    id_type id = 0;
+    // Written on the loop thread for processes spawned with `config.loop`
+    std::atomic<id_type> id = 0;
 
   private:
 
     class Data {
     public:
       Data() noexcept;
-      id_type id;
+      std::atomic<id_type> id;
   #ifdef _WIN32
       void *handle{nullptr};
   #endif
@@ -163,8 +370,10 @@ namespace SSC {
       return data.id;
     }
 
-    // Write to stdin.
+    // Write to stdin. In framed mode, `bytes` are sent as a message frame.
     bool write(const char *bytes, size_t n);
+    // Write a frame to stdin. Only valid in framed mode.
+    bool write_frame(ProcessFrame::Type type, int index, const char *bytes, size_t n);
     // Write to stdin. Convenience function using write(const char *, size_t).
     bool write(const SSC::String &s) {
       return write(s.c_str(), s.size());
@@ -199,6 +408,10 @@ namespace SSC {
     MessageCallback on_exit;
 #ifndef _WIN32
     std::thread stdout_stderr_thread;
+    // State for processes attached to `ProcessConfig::loop`. It is owned by
+    // the loop and outlives the process until all of its handles are closed.
+    struct LoopContext;
+    LoopContext *loop_context = nullptr;
 #else
     std::thread stdout_thread, stderr_thread;
 #endif
@@ -214,6 +427,8 @@ namespace SSC {
     id_type open(const SSC::String &command, const SSC::String &path) noexcept;
 #ifndef _WIN32
     id_type open(const std::function<int()> &function) noexcept;
+    id_type open_on_loop(const SSC::String &command) noexcept;
+    bool queue_write(SSC::String bytes) noexcept;
 #endif
     void read() noexcept;
     void close_fds() noexcept;
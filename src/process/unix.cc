@@ -4,6 +4,7 @@
 #include <cstring>
 #include <fcntl.h>
 #include <iostream>
+#include <mutex>
 #include <poll.h>
 #include <set>
 #include <signal.h>
@@ -16,7 +17,236 @@
 
 namespace SSC {
 
-static StringStream initial;
+// Splits `bytes` into lines, carrying a trailing partial line over in `line`.
+static void read_lines(SSC::String &line, const char *bytes, size_t n, const MessageCallback &callback) {
+  size_t offset = 0;
+
+  for (size_t i = 0; i < n; ++i) {
+    if (bytes[i] == '\n') {
+      line.append(bytes + offset, i - offset);
+      callback(line);
+      line.clear();
+      offset = i + 1;
+    }
+  }
+
+  line.append(bytes + offset, n - offset);
+}
+
+static void kill_process_group(pid_t id) {
+  auto r = ::kill(-id, SIGINT);
+
+  if (r != 0) {
+    r = ::kill(-id, SIGTERM);
+
+    if (r != 0) {
+      r = ::kill(-id, SIGKILL);
+
+      if (r != 0) {
+        // @TODO: print warning
+      }
+    }
+  }
+}
+
+// Wraps `command` so that it runs in `path`, without resolving symbolic links.
+static SSC::String shell_command(const SSC::String &command, const SSC::String &path) {
+  if (path.empty()) {
+    return command;
+  }
+
+  auto path_escaped = path;
+  size_t pos = 0;
+
+  // Based on https://www.reddit.com/r/cpp/comments/3vpjqg/a_new_platform_independent_process_library_for_c11/cxsxyb7
+  while((pos = path_escaped.find('\'', pos)) != SSC::String::npos) {
+    path_escaped.replace(pos, 1, "'\\''");
+    pos += 4;
+  }
+
+  return "cd '" + path_escaped + "' && " + command;
+}
+
+// The stdio pipes and process handle of a process spawned on a libuv loop.
+// Everything but `process` and `write_queue_size` is only touched on the
+// loop thread. `process` is cleared under `mutex` when the `Process` is
+// destroyed, after which callbacks are dropped and the handles are closed.
+struct Process::LoopContext {
+  enum { STDIN = 0, STDOUT = 1, STDERR = 2 };
+
+  std::recursive_mutex mutex;
+  Process *process = nullptr;
+  uv_process_t handle;
+  uv_pipe_t pipes[3];
+  bool piped[3] = { false, false, false };
+  bool spawned = false;
+  bool exited = false;
+  bool detached = false;
+  int handles = 0;
+
+  std::size_t buffer_size;
+  std::unique_ptr<char[]> buffer;
+  ProcessFrameReader frames;
+  SSC::String line;
+  std::atomic<std::size_t> write_queue_size = 0;
+
+  LoopContext (Process *process) :
+    process(process),
+    buffer_size(process->config.buffer_size),
+    buffer(new char[process->config.buffer_size]),
+    frames(process->config.read_stdout_frame ? process->config.buffer_size : 0)
+  {}
+
+  struct Write {
+    uv_write_t request;
+    LoopContext *context;
+    SSC::String bytes;
+  };
+
+  static void release (LoopContext *context) {
+    if (context->detached && context->handles == 0) {
+      delete context;
+    }
+  }
+
+  static void close (uv_handle_t *handle) {
+    if (uv_is_closing(handle)) {
+      return;
+    }
+
+    uv_close(handle, [](uv_handle_t *handle) {
+      auto context = reinterpret_cast<LoopContext *>(handle->data);
+      context->handles--;
+      release(context);
+    });
+  }
+
+  static void detach (LoopContext *context) {
+    context->detached = true;
+
+    for (int i = 0; i < 3; ++i) {
+      if (context->piped[i]) {
+        close((uv_handle_t *) &context->pipes[i]);
+      }
+    }
+
+    // a running process keeps its handle until it exits so it is reaped
+    if (context->spawned && context->exited) {
+      close((uv_handle_t *) &context->handle);
+    }
+
+    release(context);
+  }
+
+  static void alloc (uv_handle_t *handle, size_t, uv_buf_t *buf) {
+    auto context = reinterpret_cast<LoopContext *>(handle->data);
+
+    if (handle == (uv_handle_t *) &context->pipes[STDOUT] && context->frames.capacity > 0) {
+      *buf = uv_buf_init(context->frames.tail(), context->frames.available());
+    } else {
+      *buf = uv_buf_init(context->buffer.get(), context->buffer_size);
+    }
+  }
+
+  static void read (uv_stream_t *stream, ssize_t n, const uv_buf_t *buf) {
+    auto context = reinterpret_cast<LoopContext *>(stream->data);
+
+    if (n < 0) {
+      close((uv_handle_t *) stream);
+      return;
+    }
+
+    if (n == 0) {
+      return;
+    }
+
+    std::lock_guard<std::recursive_mutex> lock(context->mutex);
+    auto process = context->process;
+
+    if (process == nullptr) {
+      return;
+    }
+
+    if (stream == (uv_stream_t *) &context->pipes[STDERR]) {
+      process->read_stderr(SSC::String(buf->base, n));
+    } else if (context->frames.capacity > 0) {
+      // a corrupt frame stream cannot be resynchronized, stop reading it
+      if (!context->frames.commit(n, process->config.read_stdout_frame)) {
+        debug("Process: corrupt frame on stdout, closing the stream");
+        close((uv_handle_t *) stream);
+      }
+    } else {
+      read_lines(context->line, buf->base, n, process->read_stdout);
+    }
+  }
+
+  static void exit (uv_process_t *handle, int64_t exit_status, int term_signal) {
+    auto context = reinterpret_cast<LoopContext *>(handle->data);
+    context->exited = true;
+
+    {
+      std::lock_guard<std::recursive_mutex> lock(context->mutex);
+      auto process = context->process;
+
+      if (process != nullptr) {
+        // like a shell, a process killed by a signal exits with 128 + signal
+        process->status = term_signal > 0 ? 128 + term_signal : (int) exit_status;
+        process->closed = true;
+
+        if (process->on_exit != nullptr) {
+          process->on_exit(std::to_string(process->status));
+        }
+      }
+    }
+
+    close((uv_handle_t *) handle);
+  }
+
+  static void write (LoopContext *context, SSC::String bytes) {
+    auto size = bytes.size();
+    auto stream = (uv_stream_t *) &context->pipes[STDIN];
+
+    if (!context->piped[STDIN] || uv_is_closing((uv_handle_t *) stream)) {
+      context->write_queue_size -= size;
+      return;
+    }
+
+    auto write = new Write { {}, context, std::move(bytes) };
+    auto buf = uv_buf_init(write->bytes.data(), size);
+    write->request.data = write;
+
+    auto err = uv_write(&write->request, stream, &buf, 1, [](uv_write_t *request, int) {
+      auto write = reinterpret_cast<Write *>(request->data);
+      write->context->write_queue_size -= write->bytes.size();
+      delete write;
+    });
+
+    if (err != 0) {
+      context->write_queue_size -= size;
+      delete write;
+    }
+  }
+
+  static void close_stdin (LoopContext *context) {
+    auto stream = (uv_stream_t *) &context->pipes[STDIN];
+
+    if (!context->piped[STDIN] || uv_is_closing((uv_handle_t *) stream)) {
+      return;
+    }
+
+    // flush queued writes before closing
+    auto request = new uv_shutdown_t;
+    auto err = uv_shutdown(request, stream, [](uv_shutdown_t *request, int) {
+      close((uv_handle_t *) request->handle);
+      delete request;
+    });
+
+    if (err != 0) {
+      close((uv_handle_t *) stream);
+      delete request;
+    }
+  }
+};
 
 Process::Data::Data() noexcept : id(-1) {}
 Process::Process(
@@ -32,7 +262,8 @@ Process::Process(
   open_stdin(true),
   read_stdout(std::move(read_stdout)),
   read_stderr(std::move(read_stderr)),
-  on_exit(std::move(on_exit))
+  on_exit(std::move(on_exit)),
+  config(config)
 {
   this->command = command;
   this->argv = argv;
@@ -61,7 +292,7 @@ Process::id_type Process::open(const std::function<int()> &function) noexcept {
     stdin_fd = std::unique_ptr<fd_type>(new fd_type);
   }
 
-  if (read_stdout) {
+  if (read_stdout || config.read_stdout_frame) {
     stdout_fd = std::unique_ptr<fd_type>(new fd_type);
   }
 
@@ -128,7 +359,7 @@ Process::id_type Process::open(const std::function<int()> &function) noexcept {
       int code = 0;
       waitpid(this->id, &code, 0);
 
-      this->status = WEXITSTATUS(code);
+      this->status = WIFSIGNALED(code) ? 128 + WTERMSIG(code) : WEXITSTATUS(code);
       this->closed = true;
 
       if (this->on_exit != nullptr) {
@@ -203,30 +434,109 @@ Process::id_type Process::open(const std::function<int()> &function) noexcept {
 }
 
 Process::id_type Process::open(const SSC::String &command, const SSC::String &path) noexcept {
+  if (config.loop != nullptr && config.dispatch != nullptr) {
+    return open_on_loop(shell_command(command, path));
+  }
+
   return open([&command, &path] {
-    auto command_c_str = command.c_str();
-    SSC::String cd_path_and_command;
+    auto shell = shell_command(command, path);
+    return execl("/bin/sh", "/bin/sh", "-c", shell.c_str(), nullptr);
+  });
+}
 
-    if (!path.empty()) {
-      auto path_escaped = path;
-      size_t pos = 0;
+// Spawns the process from the loop thread, so the pid is not known until the
+// dispatched spawn has run. Returns 0 in the meantime.
+Process::id_type Process::open_on_loop(const SSC::String &command) noexcept {
+  auto context = new LoopContext(this);
+
+  loop_context = context;
+  closed = false;
 
-      // Based on https://www.reddit.com/r/cpp/comments/3vpjqg/a_new_platform_independent_process_library_for_c11/cxsxyb7
-      while((pos = path_escaped.find('\'', pos)) != SSC::String::npos) {
-        path_escaped.replace(pos, 1, "'\\''");
-        pos += 4;
+  config.dispatch([=, this]() {
+    std::lock_guard<std::recursive_mutex> lock(context->mutex);
+
+    // destroyed before the spawn ran, `detach()` is queued after this
+    if (context->process == nullptr) {
+      return;
+    }
+
+    auto loop = config.loop;
+    bool piped[3] = {
+      open_stdin,
+      read_stdout != nullptr || config.read_stdout_frame != nullptr,
+      read_stderr != nullptr
+    };
+
+    uv_stdio_container_t stdio[3];
+
+    for (int i = 0; i < 3; ++i) {
+      if (piped[i]) {
+        uv_pipe_init(loop, &context->pipes[i], 0);
+        context->pipes[i].data = context;
+        context->piped[i] = true;
+        context->handles++;
+
+        stdio[i].flags = (uv_stdio_flags) (
+          UV_CREATE_PIPE | (i == LoopContext::STDIN ? UV_READABLE_PIPE : UV_WRITABLE_PIPE)
+        );
+
+        stdio[i].data.stream = (uv_stream_t *) &context->pipes[i];
+      } else {
+        stdio[i].flags = UV_INHERIT_FD;
+        stdio[i].data.fd = i;
+      }
+    }
+
+    char *args[] = {
+      (char *) "/bin/sh",
+      (char *) "-c",
+      (char *) command.c_str(),
+      nullptr
+    };
+
+    uv_process_options_t options = {};
+    options.file = args[0];
+    options.args = args;
+    options.stdio = stdio;
+    options.stdio_count = 3;
+    // own process group, so `kill()` reaches the whole tree
+    options.flags = UV_PROCESS_DETACHED;
+    options.exit_cb = LoopContext::exit;
+
+    context->handle.data = context;
+    context->handles++;
+
+    if (uv_spawn(loop, &context->handle, &options) != 0) {
+      for (int i = 0; i < 3; ++i) {
+        if (context->piped[i]) {
+          LoopContext::close((uv_handle_t *) &context->pipes[i]);
+        }
       }
 
-      cd_path_and_command = "cd '" + path_escaped + "' && " + command; // To avoid resolving symbolic links
-      command_c_str = cd_path_and_command.c_str();
+      LoopContext::close((uv_handle_t *) &context->handle);
+      closed = true;
+      return;
     }
 
-    return execl("/bin/sh", "/bin/sh", "-c", command_c_str, nullptr);
+    context->spawned = true;
+    data.id = id = context->handle.pid;
+
+    for (int i = LoopContext::STDOUT; i <= LoopContext::STDERR; ++i) {
+      if (context->piped[i]) {
+        uv_read_start(
+          (uv_stream_t *) &context->pipes[i],
+          LoopContext::alloc,
+          LoopContext::read
+        );
+      }
+    }
   });
+
+  return 0;
 }
 
 void Process::read() noexcept {
-  if (data.id <= 0 || (!stdout_fd && !stderr_fd)) {
+  if (loop_context || data.id <= 0 || (!stdout_fd && !stderr_fd)) {
     return;
   }
 
@@ -248,8 +558,9 @@ void Process::read() noexcept {
     }
 
     auto buffer = std::unique_ptr<char[]>(new char[config.buffer_size]);
+    auto frames = ProcessFrameReader(config.read_stdout_frame ? config.buffer_size : 0);
     bool any_open = !pollfds.empty();
-    SSC::StringStream ss;
+    SSC::String line;
 
     while (any_open && (poll(pollfds.data(), static_cast<nfds_t>(pollfds.size()), -1) > 0 || errno == EINTR)) {
       any_open = false;
@@ -258,33 +569,27 @@ void Process::read() noexcept {
         if (!(pollfds[i].fd >= 0)) continue;
 
         if (pollfds[i].revents & POLLIN) {
-          memset(buffer.get(), 0, config.buffer_size);
-          const ssize_t n = ::read(pollfds[i].fd, buffer.get(), config.buffer_size);
+          const bool framed = fd_is_stdout[i] && config.read_stdout_frame;
+          auto bytes = framed ? frames.tail() : buffer.get();
+          auto size = framed ? frames.available() : config.buffer_size;
+          const ssize_t n = ::read(pollfds[i].fd, bytes, size);
 
           if (n > 0) {
-            if (fd_is_stdout[i]) {
+            if (framed) {
               std::lock_guard<std::mutex> lock(stdout_mutex);
-              auto b = SSC::String(buffer.get());
-              auto parts = splitc(b, '\n');
-
-              if (parts.size() > 1) {
-                for (int i = 0; i < parts.size() - 1; i++) {
-                  ss << parts[i];
-
-                  SSC::String s(ss.str());
-                  read_stdout(s);
-
-                  ss.str(SSC::String());
-                  ss.clear();
-                  ss.copyfmt(initial);
-                }
-                ss << parts[parts.size() - 1];
-              } else {
-                ss << b;
+
+              // a corrupt frame stream cannot be resynchronized, stop reading it
+              if (!frames.commit(n, config.read_stdout_frame)) {
+                debug("Process: corrupt frame on stdout, closing the stream");
+                pollfds[i].fd = -1;
+                continue;
               }
+            } else if (fd_is_stdout[i]) {
+              std::lock_guard<std::mutex> lock(stdout_mutex);
+              read_lines(line, bytes, n, read_stdout);
             } else {
               std::lock_guard<std::mutex> lock(stderr_mutex);
-              read_stderr(SSC::String(buffer.get()));
+              read_stderr(SSC::String(bytes, n));
             }
           } else if (n < 0 && errno != EINTR && errno != EAGAIN && errno != EWOULDBLOCK) {
             pollfds[i].fd = -1;
@@ -304,6 +609,22 @@ void Process::read() noexcept {
 }
 
 void Process::close_fds() noexcept {
+  if (loop_context) {
+    auto context = loop_context;
+    loop_context = nullptr;
+
+    {
+      std::lock_guard<std::recursive_mutex> lock(context->mutex);
+      context->process = nullptr;
+    }
+
+    config.dispatch([context] {
+      LoopContext::detach(context);
+    });
+
+    return;
+  }
+
   if (stdout_stderr_thread.joinable()) {
     stdout_stderr_thread.join();
   }
@@ -329,29 +650,95 @@ void Process::close_fds() noexcept {
   }
 }
 
+static bool write_all(int fd, const char *bytes, size_t n) {
+  while (n > 0) {
+    auto bytesWritten = ::write(fd, bytes, n);
+
+    if (bytesWritten < 0) {
+      if (errno == EINTR || errno == EAGAIN) continue;
+      return false;
+    }
+
+    bytes += bytesWritten;
+    n -= bytesWritten;
+  }
+
+  return true;
+}
+
+bool Process::queue_write(SSC::String bytes) noexcept {
+  auto context = loop_context;
+  auto size = bytes.size();
+  auto queued = context->write_queue_size.fetch_add(size);
+
+  // always accept a write into an empty queue, however large
+  if (queued > 0 && queued + size > config.write_queue_size_limit) {
+    context->write_queue_size -= size;
+    return false;
+  }
+
+  config.dispatch([context, bytes = std::move(bytes)]() mutable {
+    LoopContext::write(context, std::move(bytes));
+  });
+
+  return true;
+}
+
 bool Process::write(const char *bytes, size_t n) {
+  if (config.read_stdout_frame) {
+    return write_frame(ProcessFrame::Type::message, -1, bytes, n);
+  }
+
+  if (loop_context) {
+    auto line = SSC::String(bytes, n);
+    line += "\n";
+    return queue_write(std::move(line));
+  }
+
   std::lock_guard<std::mutex> lock(stdin_mutex);
 
   if (stdin_fd) {
-    SSC::String b(bytes);
-
-    while (true && (b.size() > 0)) {
-      int bytesWritten = ::write(*stdin_fd, b.c_str(), b.size());
+    return write_all(*stdin_fd, bytes, n) && write_all(*stdin_fd, "\n", 1);
+  }
 
-      if (bytesWritten >= b.size()) {
-        break;
-      }
+  return false;
+}
 
-      b = b.substr(bytesWritten, b.size());
+bool Process::write_frame(ProcessFrame::Type type, int index, const char *bytes, size_t n) {
+  if (loop_context) {
+    if (n > ProcessFrame::MAX_SIZE) {
+      return false;
     }
 
-    int bytesWritten = ::write(*stdin_fd, "\n", 1);
+    SSC::String frame(ProcessFrame::HEADER_SIZE + n, '\0');
+    ProcessFrame::encodeHeader((unsigned char *) frame.data(), type, index, n);
+    memcpy(frame.data() + ProcessFrame::HEADER_SIZE, bytes, n);
+    return queue_write(std::move(frame));
+  }
+
+  std::lock_guard<std::mutex> lock(stdin_mutex);
+
+  if (stdin_fd && n <= ProcessFrame::MAX_SIZE) {
+    unsigned char header[ProcessFrame::HEADER_SIZE];
+    ProcessFrame::encodeHeader(header, type, index, n);
+    return (
+      write_all(*stdin_fd, (const char *) header, sizeof(header)) &&
+      write_all(*stdin_fd, bytes, n)
+    );
   }
 
   return false;
 }
 
 void Process::close_stdin() noexcept {
+  if (loop_context) {
+    auto context = loop_context;
+    config.dispatch([context] {
+      LoopContext::close_stdin(context);
+    });
+    return;
+  }
+
   std::lock_guard<std::mutex> lock(stdin_mutex);
 
   if (stdin_fd) {
@@ -364,24 +751,26 @@ void Process::close_stdin() noexcept {
 }
 
 void Process::kill(id_type id) noexcept {
+  if (loop_context && (id <= 0 || id == data.id)) {
+    // the spawn may still be queued, so signal the process from the loop
+    auto context = loop_context;
+    this->closed = true;
+
+    config.dispatch([context] {
+      if (context->spawned && !context->exited) {
+        kill_process_group(context->handle.pid);
+      }
+    });
+
+    return;
+  }
+
   if (id <= 0) {
     return;
   }
 
   this->closed = true;
-  auto r = ::kill(-id, SIGINT);
-
-  if (r != 0) {
-    r = ::kill(-id, SIGTERM);
-
-    if (r != 0) {
-      r = ::kill(-id, SIGKILL);
-
-      if (r != 0) {
-        // @TODO: print warning
-      }
-    }
-  }
+  kill_process_group(id);
 }
 
 } // namespace SSC
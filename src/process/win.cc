@@ -29,8 +29,6 @@ SSC::String FormatError(DWORD error, SSC::String source) {
   return message.str();
 }
 
-const static SSC::StringStream initial;
-
 Process::Data::Data() noexcept : id(0) {}
 
 Process::Process(
@@ -46,7 +44,8 @@ Process::Process(
   open_stdin(true),
   read_stdout(std::move(read_stdout)),
   read_stderr(std::move(read_stderr)),
-  on_exit(std::move(on_exit))
+  on_exit(std::move(on_exit)),
+  config(config)
 {
   this->command = command;
   this->argv = argv;
@@ -90,7 +89,7 @@ Process::id_type Process::open(const SSC::String &command, const SSC::String &pa
     stdin_fd = std::unique_ptr<fd_type>(new fd_type(nullptr));
   }
 
-  if (read_stdout) {
+  if (read_stdout || config.read_stdout_frame) {
     stdout_fd = std::unique_ptr<fd_type>(new fd_type(nullptr));
   }
 
@@ -249,34 +248,43 @@ void Process::read() noexcept {
       DWORD n;
 
       std::unique_ptr<char[]> buffer(new char[config.buffer_size]);
-      SSC::StringStream ss;
+      auto frames = ProcessFrameReader(config.read_stdout_frame ? config.buffer_size : 0);
+      SSC::String line;
 
       for (;;) {
-        memset(buffer.get(), 0, config.buffer_size);
-        BOOL bSuccess = ReadFile(*stdout_fd, static_cast<CHAR *>(buffer.get()), static_cast<DWORD>(config.buffer_size), &n, nullptr);
+        const bool framed = config.read_stdout_frame != nullptr;
+        auto bytes = framed ? frames.tail() : buffer.get();
+        auto size = framed ? frames.available() : config.buffer_size;
+        BOOL bSuccess = ReadFile(*stdout_fd, static_cast<CHAR *>(bytes), static_cast<DWORD>(size), &n, nullptr);
 
         if (!bSuccess || n == 0) {
           break;
         }
 
-        auto b = SSC::String(buffer.get());
-        auto parts = splitc(b, '\n');
+        std::lock_guard<std::mutex> lock(stdout_mutex);
+
+        if (framed) {
+          // a corrupt frame stream cannot be resynchronized, stop reading it
+          if (!frames.commit(n, config.read_stdout_frame)) {
+            debug("Process: corrupt frame on stdout, closing the stream");
+            break;
+          }
+
+          continue;
+        }
 
-        if (parts.size() > 1) {
-          std::lock_guard<std::mutex> lock(stdout_mutex);
+        size_t offset = 0;
 
-          for (int i = 0; i < parts.size() - 1; i++) {
-            ss << parts[i];
-            SSC::String s(ss.str());
-            read_stdout(s);
-            ss.str(SSC::String());
-            ss.clear();
-            ss.copyfmt(initial);
+        for (size_t i = 0; i < n; ++i) {
+          if (bytes[i] == '\n') {
+            line.append(bytes + offset, i - offset);
+            read_stdout(line);
+            line.clear();
+            offset = i + 1;
           }
-          ss << parts[parts.size() - 1];
-        } else {
-          ss << b;
         }
+
+        line.append(bytes + offset, n - offset);
       }
     });
   }
@@ -290,7 +298,7 @@ void Process::read() noexcept {
         BOOL bSuccess = ReadFile(*stderr_fd, static_cast<CHAR *>(buffer.get()), static_cast<DWORD>(config.buffer_size), &n, nullptr);
         if (!bSuccess || n == 0) break;
         std::lock_guard<std::mutex> lock(stderr_mutex);
-        read_stderr(SSC::String(buffer.get()));
+        read_stderr(SSC::String(buffer.get(), n));
       }
     });
   }
@@ -326,7 +334,33 @@ void Process::close_fds() noexcept {
   }
 }
 
+bool Process::write_frame(ProcessFrame::Type type, int index, const char *bytes, size_t n) {
+  std::lock_guard<std::mutex> lock(stdin_mutex);
+
+  if (!stdin_fd || n > ProcessFrame::MAX_SIZE) {
+    return false;
+  }
+
+  unsigned char header[ProcessFrame::HEADER_SIZE];
+  ProcessFrame::encodeHeader(header, type, index, n);
+
+  DWORD bytesWritten;
+  BOOL bSuccess = WriteFile(*stdin_fd, header, static_cast<DWORD>(sizeof(header)), &bytesWritten, nullptr);
+
+  while (bSuccess && n > 0) {
+    bSuccess = WriteFile(*stdin_fd, bytes, static_cast<DWORD>(n), &bytesWritten, nullptr);
+    bytes += bytesWritten;
+    n -= bytesWritten;
+  }
+
+  return bSuccess;
+}
+
 bool Process::write(const char *bytes, size_t n) {
+  if (config.read_stdout_frame) {
+    return write_frame(ProcessFrame::Type::message, -1, bytes, n);
+  }
+
   if (!open_stdin) {
     throw std::invalid_argument("Can't write to an unopened stdin pipe. Please set open_stdin=true when constructing the process.");
   }
@@ -517,7 +517,9 @@ namespace SSC {
     WKUserContentController* controller = [config userContentController];
 
     // Add preload script, normalizing the interface to be cross-platform.
+    StartupTrace::begin("preload");
     SSC::String preload = ToString(createPreload(opts));
+    StartupTrace::end("preload");
 
     WKUserScript* userScript = [WKUserScript alloc];
 
@@ -202,7 +202,7 @@ namespace SSC {
         auto req = webkit_navigation_action_get_request(action);
         auto uri = String(webkit_uri_request_get_uri(req));
 
-        if (uri.find("file://") != 0 && uri.find("http://localhost") != 0 && uri.find("socket:") != 0) {
+        if (uri.find("file://") != 0 && uri.find("http://localhost") != 0 && uri.find("socket:") != 0 && uri.find("resources:") != 0) {
           webkit_policy_decision_ignore(decision);
           return false;
         }
@@ -556,7 +556,23 @@ namespace SSC {
       this
     );
 
+    StartupTrace::begin("preload");
     String preload = ToString(createPreload(opts));
+    auto importMap = IPC::getModuleImportMap();
+
+    // installed before the preload imports `socket:internal/init`, so
+    // `socket:` imports resolve without a proxy module request
+    if (importMap.size() > 0) {
+      preload = (
+        ";(() => {                                                           \n"
+        "  const script = document.createElement('script');                  \n"
+        "  script.type = 'importmap';                                        \n"
+        "  script.textContent = JSON.stringify(" + importMap + ");           \n"
+        "  document.documentElement.appendChild(script);                     \n"
+        "})();                                                               \n"
+      ) + preload;
+    }
+    StartupTrace::end("preload");
 
     WebKitUserContentManager *manager =
       webkit_web_view_get_user_content_manager(WEBKIT_WEB_VIEW(webview));
@@ -648,7 +648,9 @@ namespace SSC {
     ShowWindow(window, SW_SHOW);
     SetWindowLongPtr(window, GWLP_USERDATA, (LONG_PTR) this);
 
+    StartupTrace::begin("preload");
     SSC::String preload = createPreload(opts);
+    StartupTrace::end("preload");
 
     wchar_t modulefile[MAX_PATH];
     GetModuleFileNameW(NULL, modulefile, MAX_PATH);
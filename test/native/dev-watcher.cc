@@ -0,0 +1,112 @@
+#include "src/cli/watcher.hh"
+#include "test.hh"
+
+#include <future>
+
+#ifndef _WIN32
+#include <poll.h>
+#endif
+
+using namespace SSC;
+
+#ifndef _WIN32
+static void touch (const Path& path, const String& contents) {
+  std::ofstream(path) << contents;
+}
+
+static String readLine (int fd, int timeout) {
+  String line;
+  char byte;
+
+  while (line.size() == 0 || line.back() != '\n') {
+    struct pollfd pfd = { fd, POLLIN, 0 };
+
+    if (poll(&pfd, 1, timeout) <= 0 || ::read(fd, &byte, 1) != 1) {
+      return "";
+    }
+
+    line += byte;
+  }
+
+  return line.substr(0, line.size() - 1);
+}
+#endif
+
+int main () {
+#ifndef _WIN32
+  // a hung watcher fails the test instead of blocking the run
+  alarm(30);
+
+  char tmp[] = "/tmp/ssc-dev-watcher-XXXXXX";
+  auto root = Path(mkdtemp(tmp));
+  fs::create_directories(root / "build");
+
+  // never destroyed, its loop thread runs until the test exits
+  auto watcher = new DevWatcher();
+  std::promise<String> reloaded;
+  watcher->onReloaded = [&](const String& id) { reloaded.set_value(id); };
+
+  auto port = watcher->start(root, { root / "build" }, 0);
+  ok(port > 0, "watcher listens on a free port");
+
+  {
+    touch(root / "a.txt", "a");
+    auto changes = watcher->wait(50);
+    ok(changes.paths.size() == 1 && changes.paths.contains(root / "a.txt"), "a changed file is reported");
+  }
+
+  {
+    touch(root / "build" / "out.txt", "out");
+    touch(root / "b.txt", "b");
+    auto changes = watcher->wait(50);
+    ok(changes.paths.contains(root / "b.txt"), "changes are reported after a quiet period");
+    ok(!changes.paths.contains(root / "build" / "out.txt"), "changes in ignored directories are dropped");
+  }
+
+  {
+    // a save while a rebuild runs, between `wait()` and `rescan()`
+    touch(root / "c.txt", "c");
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    watcher->rescan();
+    auto changes = watcher->wait(50);
+    ok(changes.paths.contains(root / "c.txt"), "changes made during a rebuild are kept");
+  }
+
+  {
+    fs::create_directories(root / "sub");
+    watcher->wait(50);
+    touch(root / "sub" / "d.txt", "d");
+    auto changes = watcher->wait(50);
+    ok(changes.paths.contains(root / "sub" / "d.txt"), "changes in new directories are reported");
+  }
+
+  {
+    auto fd = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr;
+    uv_ip4_addr("127.0.0.1", port, &addr);
+    ok(connect(fd, (struct sockaddr *) &addr, sizeof(addr)) == 0, "app connects to the watcher");
+
+    // the connection is accepted on the watcher thread, so retry until it is
+    String line;
+    for (int i = 0; i < 50 && line.size() == 0; ++i) {
+      watcher->send("reload 7");
+      line = readLine(fd, 100);
+    }
+
+    ok(line == "reload 7", "reload request is sent to the app");
+
+    String ack = "reloaded 7\n";
+    ok(::write(fd, ack.data(), ack.size()) == (ssize_t) ack.size(), "app acknowledges the reload");
+
+    auto future = reloaded.get_future();
+    auto status = future.wait_for(std::chrono::seconds(5));
+    ok(status == std::future_status::ready && future.get() == "7", "reload acknowledgement is reported");
+    ::close(fd);
+  }
+
+  std::error_code ec;
+  fs::remove_all(root, ec);
+#endif
+
+  return done();
+}
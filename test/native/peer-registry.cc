@@ -0,0 +1,182 @@
+// sources: src/core/peer.cc src/core/udp.cc src/core/tcp.cc src/core/json.cc
+#include "src/core/core.hh"
+#include "test.hh"
+
+#include <atomic>
+#include <thread>
+
+using namespace SSC;
+
+// Benchmarks the peer registry with 10k concurrently registered peers, reader
+// threads doing lookups while a writer churns the registry the way ephemeral
+// sends do. Rates are printed as TAP comments so they can be compared across
+// revisions, only correctness is asserted.
+
+static uv_loop_t loop;
+
+// the parts of `Core` and `Headers` not built here
+namespace SSC {
+  void Core::dispatchEventLoop (EventLoopDispatchCallback fn) { fn(); }
+  uv_loop_t* Core::getEventLoop () { return &loop; }
+  void Core::initEventLoop () {}
+  Headers::Headers (const Vector<std::map<String, Value>>&) {}
+  Headers::Headers (const Entries&) {}
+  Headers::Header::Header (const String&, const Value&) {}
+  Headers::Header::Header (const Header&) {}
+  String Headers::str () const { return ""; }
+  const SettingsTable& getUserSettings () { static SettingsTable table; return table; }
+}
+
+constexpr int PEERS = 10000;
+constexpr int READERS = 4;
+constexpr uint64_t DURATION = 1000; // in milliseconds
+
+static double seconds (uint64_t start) {
+  return (uv_hrtime() - start) / 1e9;
+}
+
+int main () {
+  uv_loop_init(&loop);
+
+  auto core = new Core();
+  Vector<uint64_t> ids;
+
+  for (int i = 0; i < PEERS; ++i) {
+    ids.push_back(rand64());
+    core->createPeer(PEER_TYPE_UDP, ids.back());
+  }
+
+  ok(core->peers.size() == PEERS, "10k peers are registered");
+
+  auto found = 0;
+  for (auto id : ids) {
+    if (core->getPeer(id) != nullptr) found++;
+  }
+
+  ok(found == PEERS, "every registered peer is found");
+
+  std::atomic<bool> stop = false;
+  std::atomic<uint64_t> lookups = 0;
+  std::atomic<uint64_t> misses = 0;
+  std::atomic<uint64_t> churn = 0;
+  Vector<std::thread> readers;
+
+  auto start = uv_hrtime();
+
+  for (int t = 0; t < READERS; ++t) {
+    readers.emplace_back([&, t] {
+      uint64_t n = 0;
+      uint64_t missed = 0;
+      uint64_t x = t * 7919;
+
+      while (!stop) {
+        for (int i = 0; i < 1000; ++i, ++n) {
+          auto peer = core->getPeer(ids[(x += 104729) % PEERS]);
+          if (peer == nullptr || peer->isBound() || peer->isConnected()) {
+            missed++;
+          }
+        }
+      }
+
+      lookups += n;
+      misses += missed;
+    });
+  }
+
+  std::thread writer([&] {
+    while (!stop) {
+      auto id = rand64();
+      auto peer = core->createPeer(PEER_TYPE_UDP, id);
+      core->removePeer(id);
+      delete peer;
+      churn++;
+    }
+  });
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(DURATION));
+  stop = true;
+
+  for (auto& reader : readers) {
+    reader.join();
+  }
+
+  writer.join();
+
+  auto elapsed = seconds(start);
+  printf("# %d peers, %d readers + 1 writer\n", PEERS, READERS);
+  printf("# lookups: %.1fM/s\n", lookups / elapsed / 1e6);
+  printf("# churn: %.0fk/s\n", churn / elapsed / 1e3);
+
+  ok(lookups > 0 && misses == 0, "lookups never miss while the registry churns");
+  ok(churn > 0, "the registry churns while it is read");
+  ok(core->peers.size() == PEERS, "churned peers are not left registered");
+
+  // ephemeral sends register a peer for the duration of the send only
+  uv_udp_t receiver;
+  struct sockaddr_in address;
+  uv_udp_init(&loop, &receiver);
+  uv_ip4_addr("127.0.0.1", 0, &address);
+  uv_udp_bind(&receiver, (const struct sockaddr*) &address, 0);
+
+  struct sockaddr_storage bound;
+  int length = sizeof(bound);
+  uv_udp_getsockname(&receiver, (struct sockaddr*) &bound, &length);
+  auto port = ntohs(((struct sockaddr_in*) &bound)->sin_port);
+
+  String message = "x";
+  std::atomic<int> sent = 0;
+  std::atomic<int> failed = 0;
+
+  start = uv_hrtime();
+
+  for (int i = 0; i < PEERS; ++i) {
+    Core::UDP::SendOptions options;
+    options.address = "127.0.0.1";
+    options.port = port;
+    options.bytes = message.data();
+    options.size = message.size();
+    options.ephemeral = true;
+
+    core->udp.send("0", rand64(), options, [&](auto seq, auto json, auto post) {
+      if (json.str().find("\"err\"") != String::npos) failed++;
+      sent++;
+    });
+
+    if (i % 16 == 0) {
+      uv_run(&loop, UV_RUN_NOWAIT);
+    }
+  }
+
+  while (sent < PEERS) {
+    uv_run(&loop, UV_RUN_NOWAIT);
+  }
+
+  printf("# %d ephemeral sends: %.1fms\n", PEERS, seconds(start) * 1e3);
+
+  ok(failed == 0, "ephemeral sends succeed");
+  ok(core->peers.size() == PEERS, "ephemeral peers are not left registered");
+
+  // a pooled handle bound for IPv4 must not be reused for IPv6
+  String result;
+  Core::UDP::SendOptions options;
+  options.address = "::1";
+  options.port = port;
+  options.bytes = message.data();
+  options.size = message.size();
+  options.ephemeral = true;
+
+  core->udp.send("0", rand64(), options, [&](auto seq, auto json, auto post) {
+    result = json.str();
+  });
+
+  while (result.size() == 0) {
+    uv_run(&loop, UV_RUN_NOWAIT);
+  }
+
+  ok(result.find("EINVAL") == String::npos, "an IPv6 send after IPv4 sends is not rejected");
+
+  uv_close((uv_handle_t*) &receiver, nullptr);
+  uv_run(&loop, UV_RUN_NOWAIT);
+
+  return done();
+}
@@ -0,0 +1,116 @@
+// sources: src/process/unix.cc
+#include "src/process/process.hh"
+#include "test.hh"
+
+using namespace SSC;
+
+static String encode (ProcessFrame::Type type, int index, const String& bytes) {
+  unsigned char header[ProcessFrame::HEADER_SIZE];
+  ProcessFrame::encodeHeader(header, type, index, bytes.size());
+  return String((const char *) header, sizeof(header)) + bytes;
+}
+
+// feeds `stream` to `reader` in reads of at most `chunk` bytes
+static bool feed (ProcessFrameReader& reader, const String& stream, size_t chunk, const ProcessFrameCallback& callback) {
+  size_t offset = 0;
+
+  while (offset < stream.size()) {
+    auto bytes = reader.tail();
+    auto size = std::min({ chunk, reader.available(), stream.size() - offset });
+
+    memcpy(bytes, stream.data() + offset, size);
+    offset += size;
+
+    if (!reader.commit(size, callback)) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+int main () {
+  Vector<std::tuple<ProcessFrame::Type, int, String>> frames;
+  auto collect = [&](const ProcessFrame& frame) {
+    frames.push_back({ frame.type, frame.index, String(frame.bytes, frame.size) });
+  };
+
+  auto stream = (
+    encode(ProcessFrame::Type::message, -1, "ipc://send?event=ready") +
+    encode(ProcessFrame::Type::data, 2, String("\0\1\2\n\3", 5)) +
+    encode(ProcessFrame::Type::message, 0, "")
+  );
+
+  {
+    // split: every frame arrives one byte at a time
+    ProcessFrameReader reader(64);
+    frames.clear();
+    ok(feed(reader, stream, 1, collect), "split frames are accepted");
+    ok(frames.size() == 3, "split frames are all emitted");
+    ok(std::get<2>(frames[0]) == "ipc://send?event=ready", "split message frame is intact");
+    ok(std::get<1>(frames[0]) == -1, "negative window index is decoded");
+    ok(std::get<0>(frames[1]) == ProcessFrame::Type::data, "data frame type is decoded");
+    ok(std::get<1>(frames[1]) == 2, "data frame index is decoded");
+    ok(std::get<2>(frames[1]) == String("\0\1\2\n\3", 5), "binary payload keeps NUL and newline bytes");
+    ok(std::get<2>(frames[2]).size() == 0, "empty frame is emitted");
+    ok(reader.start == 0 && reader.end == 0, "buffer is empty after complete frames");
+  }
+
+  {
+    // coalesced: all frames arrive in one read
+    ProcessFrameReader reader(256);
+    frames.clear();
+    ok(feed(reader, stream, stream.size(), collect), "coalesced frames are accepted");
+    ok(frames.size() == 3, "coalesced frames are all emitted");
+  }
+
+  {
+    // a frame larger than the buffer grows it
+    ProcessFrameReader reader(16);
+    auto large = encode(ProcessFrame::Type::data, 1, String(1000, 'x'));
+    frames.clear();
+    ok(feed(reader, large + stream, 7, collect), "frames larger than the buffer are accepted");
+    ok(frames.size() == 4 && std::get<2>(frames[0]) == String(1000, 'x'), "large frame is intact");
+    ok(reader.capacity >= large.size(), "buffer grew to fit the large frame");
+  }
+
+  {
+    // corrupt: a size above `MAX_SIZE` discards the stream
+    ProcessFrameReader reader(64);
+    unsigned char header[ProcessFrame::HEADER_SIZE] = { 0xff, 0xff, 0xff, 0xff, 0, 0, 0, 0 };
+    frames.clear();
+    memcpy(reader.tail(), header, sizeof(header));
+    ok(!reader.commit(sizeof(header), collect), "corrupt header is reported");
+    ok(frames.size() == 0, "corrupt header emits no frame");
+    ok(reader.start == 0 && reader.end == 0, "corrupt stream is discarded");
+  }
+
+  #ifndef _WIN32
+  {
+    // `write_frame()` round trip through a process echoing its stdin
+    std::mutex mutex;
+    ProcessConfig config;
+    frames.clear();
+    config.read_stdout_frame = [&](const ProcessFrame& frame) {
+      std::lock_guard lock(mutex);
+      collect(frame);
+    };
+
+    Process process("cat", "", "", nullptr, nullptr, nullptr, true, config);
+    process.open();
+
+    auto payload = String(300 * 1024, 'y');
+    ok(process.write_frame(ProcessFrame::Type::data, 3, payload.data(), payload.size()), "write_frame() writes a data frame");
+    ok(process.write("ipc://hello"), "write() writes a message frame");
+    process.close_stdin();
+    process.wait();
+
+    std::lock_guard lock(mutex);
+    ok(frames.size() == 2, "framed writes are read back");
+    ok(frames.size() == 2 && std::get<1>(frames[0]) == 3 && std::get<2>(frames[0]) == payload, "data frame survives the round trip");
+    ok(frames.size() == 2 && std::get<0>(frames[1]) == ProcessFrame::Type::message && std::get<2>(frames[1]) == "ipc://hello", "message frame survives the round trip");
+  }
+  #endif
+
+  return done();
+}
@@ -0,0 +1,134 @@
+// sources: src/process/unix.cc
+#include "src/process/process.hh"
+#include "test.hh"
+
+#include <signal.h>
+
+using namespace SSC;
+
+// drives `loop` and the functions given to `config.dispatch` on this thread
+struct Loop {
+  uv_loop_t loop;
+  Vector<std::function<void()>> queue;
+
+  Loop () {
+    uv_loop_init(&loop);
+  }
+
+  ~Loop () {
+    run([] { return false; }, 200);
+    uv_loop_close(&loop);
+  }
+
+  ProcessConfig config () {
+    ProcessConfig config;
+    config.loop = &loop;
+    config.dispatch = [this](std::function<void()> fn) {
+      queue.push_back(std::move(fn));
+    };
+    return config;
+  }
+
+  // runs until `predicate` holds or `timeout` milliseconds have passed
+  bool run (const std::function<bool()>& predicate, uint64_t timeout = 5000) {
+    auto deadline = uv_hrtime() + timeout * 1000000;
+
+    while (uv_hrtime() < deadline) {
+      auto pending = std::move(queue);
+      queue.clear();
+
+      for (auto& fn : pending) {
+        fn();
+      }
+
+      if (predicate()) {
+        return true;
+      }
+
+      uv_run(&loop, UV_RUN_NOWAIT);
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    return false;
+  }
+};
+
+int main () {
+  Loop loop;
+
+  {
+    // output and exit status are delivered on the loop
+    Vector<String> lines;
+    String code;
+    auto process = Process(
+      "printf 'a\\nb\\n'; exit 3",
+      "",
+      "",
+      [&](const String& line) { lines.push_back(line); },
+      [](const String&) {},
+      [&](const String& status) { code = status; },
+      false,
+      loop.config()
+    );
+
+    process.open();
+    ok(process.getPID() == (Process::id_type) -1, "pid is unset until the spawn runs on the loop");
+    ok(loop.run([&] { return process.closed && code.size() > 0; }), "process exits");
+    ok(process.getPID() > 0, "pid is set once spawned");
+    ok(code == "3", "exit status is reported");
+    ok(loop.run([&] { return lines.size() == 2; }), "stdout lines are read");
+    ok(lines.size() == 2 && lines[0] == "a" && lines[1] == "b", "stdout lines are intact");
+  }
+
+  {
+    // a process killed by a signal reports 128 + signal
+    String code;
+    auto process = Process(
+      "exec sleep 10",
+      "",
+      "",
+      nullptr,
+      nullptr,
+      [&](const String& status) { code = status; },
+      false,
+      loop.config()
+    );
+
+    process.open();
+    ok(loop.run([&] { return process.getPID() > 0; }), "process is spawned");
+    process.kill(process.getPID());
+    ok(loop.run([&] { return code.size() > 0; }), "killed process exits");
+    ok(code == std::to_string(128 + SIGINT), "termination signal is reported");
+    ok(process.status == 128 + SIGINT, "status includes the termination signal");
+  }
+
+  {
+    // writes past `write_queue_size_limit` are refused until the queue drains
+    auto config = loop.config();
+    std::size_t read = 0;
+    config.write_queue_size_limit = 4096;
+
+    auto process = Process(
+      "cat",
+      "",
+      "",
+      [&](const String& line) { read += line.size() + 1; },
+      nullptr,
+      nullptr,
+      true,
+      config
+    );
+
+    process.open();
+    auto chunk = String(3000, 'x');
+    ok(process.write(chunk), "a write into an empty queue is accepted");
+    ok(!process.write(chunk), "a write past the limit is refused");
+    ok(loop.run([&] { return read == chunk.size() + 1; }), "queued write is flushed");
+    ok(process.write(chunk), "a write is accepted once the queue drains");
+    ok(loop.run([&] { return read == 2 * (chunk.size() + 1); }), "second write is flushed");
+    process.close_stdin();
+    ok(loop.run([&] { return process.closed.load(); }), "process exits after stdin is closed");
+  }
+
+  return done();
+}
@@ -0,0 +1,32 @@
+#include "src/common.hh"
+#include "test.hh"
+
+using namespace SSC;
+
+int main () {
+  auto settings = SettingsTable(Map {
+    {"build_name", "app"},
+    {"core_preload_modules", "true"},
+    {"window_width", "640"},
+    {"window_height", "not a number"},
+    {"meta_title", ""}
+  });
+
+  ok(settings.has("build_name"), "present key is found");
+  ok(!settings.has("build_output"), "missing key is not found");
+  ok(settings.get("build_name") == "app", "value is returned");
+  ok(settings.get("build_output") == "", "missing key returns an empty string");
+
+  // the fallback is a temporary, the result must not reference it
+  auto title = settings.get("meta_title", String("untitled"));
+  auto name = settings.get("build_name", String("fallback"));
+  ok(title == "untitled", "empty value returns the fallback");
+  ok(name == "app", "value is preferred over the fallback");
+
+  ok(settings.getBool("core_preload_modules"), "boolean is parsed");
+  ok(settings.getBool("build_output", true), "missing boolean returns the fallback");
+  ok(settings.getInt("window_width") == 640, "integer is parsed");
+  ok(settings.getInt("window_height", 480) == 480, "invalid integer returns the fallback");
+
+  return done();
+}
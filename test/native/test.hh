@@ -0,0 +1,26 @@
+#ifndef SSC_TEST_NATIVE_TEST_H
+#define SSC_TEST_NATIVE_TEST_H
+
+#include <cstdio>
+#include <cstdlib>
+
+// Minimal TAP output for the native unit tests, see `test/scripts/test-native.sh`
+static int tests = 0;
+static int failures = 0;
+
+#define ok(condition, message) ({                                              \
+  tests++;                                                                     \
+  if (condition) {                                                             \
+    printf("ok %d - %s\n", tests, message);                                    \
+  } else {                                                                     \
+    failures++;                                                                \
+    printf("not ok %d - %s (%s:%d)\n", tests, message, __FILE__, __LINE__);    \
+  }                                                                            \
+})
+
+#define done() ({                                                              \
+  printf("1..%d\n", tests);                                                    \
+  failures > 0 ? EXIT_FAILURE : EXIT_SUCCESS;                                  \
+})
+
+#endif
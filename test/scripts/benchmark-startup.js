@@ -0,0 +1,83 @@
+import { rmSync as rm, cpSync as cp, readFileSync as readFile } from 'node:fs'
+import { execSync as exec } from 'node:child_process'
+import path from 'node:path'
+import os from 'node:os'
+
+const dirname = path.dirname(import.meta.url.replace('file://', '').replace(/^\/[A-Za-z]:/, ''))
+const root = path.dirname(dirname)
+
+const SOCKET_HOME_API = path.join(root, '..', 'api')
+const {
+  TMP,
+  TMPDIR = TMP || os.tmpdir(),
+  // number of cold starts to measure
+  STARTUP_RUNS = '10',
+  // fail if the p50 time to `domcontentloaded` exceeds this many milliseconds
+  STARTUP_BUDGET_MS = ''
+} = process.env
+
+const env = { SOCKET_HOME_API, ...process.env }
+const trace = path.join(TMPDIR, 'ssc-startup-trace.json')
+const percentile = (samples, p) => samples[Math.min(samples.length - 1, Math.floor(samples.length * p))]
+const format = (samples) => ['p50', 'p90', 'p99']
+  .map((name) => `${name}=${percentile(samples, Number(name.slice(1)) / 100).toFixed(1)}ms`)
+  .join(' ')
+
+try {
+  rm(path.join(TMPDIR, 'ssc-socket-test-fixtures'), {
+    recursive: true,
+    force: true
+  })
+} catch {}
+
+cp(path.join(root, 'fixtures'), path.join(TMPDIR, 'ssc-socket-test-fixtures'), {
+  recursive: true
+})
+
+const wall = []
+const loaded = []
+const config = []
+
+try {
+  exec('ssc build -o --headless --prod', { stdio: 'inherit', env })
+
+  for (let i = 0; i < Number(STARTUP_RUNS); ++i) {
+    rm(trace, { force: true })
+
+    const start = performance.now()
+    exec('ssc run --headless --prod', {
+      stdio: 'ignore',
+      env: { ...env, SSC_STARTUP_TRACE: trace, SSC_STARTUP_TRACE_EXIT: '1' }
+    })
+
+    wall.push(performance.now() - start)
+
+    const { traceEvents } = JSON.parse(readFile(trace, 'utf8'))
+    const event = traceEvents.find((event) => event.name === 'domcontentloaded')
+    loaded.push(event.ts / 1000)
+
+    // loading the user settings, the first `getUserConfig()` call is made
+    // at the top of `main`, before the `App` is constructed
+    const configBegin = traceEvents.find((event) => event.name === 'config' && event.ph === 'B')
+    const configEnd = traceEvents.find((event) => event.name === 'config' && event.ph === 'E')
+    config.push((configEnd.ts - configBegin.ts) / 1000)
+  }
+} catch (err) {
+  console.log({ err })
+  process.exit(err.status || 1)
+}
+
+wall.sort((a, b) => a - b)
+loaded.sort((a, b) => a - b)
+config.sort((a, b) => a - b)
+
+console.log(`# startup: ${wall.length} runs`)
+console.log(`# domcontentloaded ${format(loaded)}`)
+console.log(`# settings load ${format(config)}`)
+console.log(`# process wall time ${format(wall)}`)
+console.log(`# last trace: ${trace}`)
+
+if (STARTUP_BUDGET_MS && percentile(loaded, 0.5) > Number(STARTUP_BUDGET_MS)) {
+  console.log(`not ok - p50 domcontentloaded exceeds ${STARTUP_BUDGET_MS}ms`)
+  process.exit(1)
+}
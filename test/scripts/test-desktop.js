@@ -7,6 +7,9 @@ const dirname = path.dirname(import.meta.url.replace('file://', '').replace(/^\/
 const root = path.dirname(dirname)
 
 const SOCKET_HOME_API = path.join(root, '..', 'api')
+// `--rebuild` relinks the app instead of only running the build script
+// and copy stage when the runtime library changed, like in a PGO build
+const rebuild = process.argv.includes('--rebuild')
 const {
   DEBUG,
   TMP,
@@ -25,7 +28,7 @@ cp(path.join(root, 'fixtures'), path.join(TMPDIR, 'ssc-socket-test-fixtures'), {
 })
 
 try {
-  exec(`ssc build -r -o ${!DEBUG ? '--headless --prod' : ''}`, {
+  exec(`ssc build -r ${rebuild ? '' : '-o'} ${!DEBUG ? '--headless --prod' : ''}`, {
     stdio: 'inherit',
     env: {
       SOCKET_HOME_API,
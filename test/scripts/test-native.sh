@@ -0,0 +1,54 @@
+#!/usr/bin/env bash
+
+# Builds and runs the native unit tests in `test/native`. Each test is a
+# standalone program that prints TAP and exits non zero on failure. Sources
+# a test needs besides headers are listed on a `// sources:` line in it.
+# Set `LIBUV` to link a libuv other than the one built by `bin/install.sh`.
+
+declare root="$(cd "$(dirname "$(dirname "$(dirname "${BASH_SOURCE[0]}")")")" && pwd)"
+declare arch="$(uname -m | sed 's/aarch64/arm64/g')"
+declare output="$root/build/test-native"
+declare cxx="${CXX:-c++}"
+declare failed=0
+
+declare cflags=(-std=c++2a -g -O1 -I"$root" -I"$root/build/uv/include")
+declare ldflags=(-lpthread)
+
+if [ -n "$LIBUV" ]; then
+  ldflags=("$LIBUV" "${ldflags[@]}")
+elif [ -f "$root/build/$arch-desktop/lib/libuv.a" ]; then
+  ldflags=("$root/build/$arch-desktop/lib/libuv.a" "${ldflags[@]}")
+else
+  ldflags=($(pkg-config --cflags --libs libuv 2>/dev/null || echo -luv) "${ldflags[@]}")
+fi
+
+if [[ "$(uname -s)" = "Linux" ]]; then
+  # tests including `src/core/core.hh` need the WebKitGTK headers, not the libraries
+  cflags+=($(pkg-config --cflags gtk+-3.0 webkit2gtk-4.1 2>/dev/null))
+  ldflags+=(-ldl)
+fi
+
+mkdir -p "$output"
+
+for test in "$root"/test/native/*.cc; do
+  declare name="$(basename "$test" .cc)"
+  declare sources=()
+
+  for source in $(sed -n 's|^// sources: ||p' "$test"); do
+    sources+=("$root/$source")
+  done
+
+  echo "# $name"
+
+  if ! "$cxx" "${cflags[@]}" "$test" "${sources[@]}" "${ldflags[@]}" -o "$output/$name"; then
+    echo "not ok - failed to build $name"
+    failed=1
+    continue
+  fi
+
+  if ! "$output/$name"; then
+    failed=1
+  fi
+done
+
+exit $failed
@@ -104,6 +104,13 @@ if (!['android', 'ios'].includes(process.platform)) {
   })
 }
 
+test('application startup time', async (t) => {
+  const init = globalThis.__RUNTIME_INIT_NOW__
+  t.equal(typeof init, 'number', 'runtime init time is recorded')
+  t.ok(init > 0 && init <= performance.now(), 'runtime init time is after navigation start')
+  t.comment(`runtime initialized ${init.toFixed(3)}ms after navigation start`)
+})
+
 // FIXME: make it work on iOS/Windows
 if (!['android', 'ios', 'win32'].includes(process.platform)) {
   test('application.getScreenSize', async (t) => {
@@ -113,6 +120,18 @@ if (!['android', 'ios', 'win32'].includes(process.platform)) {
   })
 }
 
+// FIXME: make it work on iOS/Android
+if (!['android', 'ios'].includes(process.platform)) {
+  test('application.getDispatchQueueMetrics', async (t) => {
+    const metrics = await application.getDispatchQueueMetrics()
+    for (const key of ['depth', 'maxDepth', 'dispatched', 'drains', 'lastDrainTime', 'maxDrainTime']) {
+      t.equal(typeof metrics[key], 'number', `metrics.${key} is a number`)
+    }
+    t.ok(metrics.drains > 0, 'dispatch queue has been drained')
+    t.ok(metrics.maxDepth >= metrics.depth, 'max depth is tracked')
+  })
+}
+
 // FIXME: make it work on iOS/Android
 if (!['android', 'ios'].includes(process.platform)) {
   test('openExternal', async (t) => {
@@ -447,6 +466,28 @@ if (!['android', 'ios', 'win32'].includes(process.platform)) {
     t.equal(mainWindow.getStatus(), ApplicationWindow.constants.WINDOW_SHOWN, 'window options are updated on show')
   })
 
+  test('application.createWindow in an archived build', async (t) => {
+    if (process.platform !== 'linux') {
+      return t.comment('skipping, resource archives are only built on linux')
+    }
+
+    // `[build] archive = true` in socket.ini packs resources.pack next to
+    // the copied resources, secondary windows still load `file:` paths
+    const pack = await readFile('resources.pack').catch(() => null)
+    t.ok(pack?.length > 0, 'resources are archived')
+
+    const newWindow = await application.createWindow({ index: counter, path: 'frontend/index_no_js.html' })
+    counter++
+    t.ok(newWindow instanceof ApplicationWindow, 'opens a second window')
+
+    const { status } = await newWindow.navigate('frontend/index_no_js2.html')
+    t.equal(status, ApplicationWindow.constants.WINDOW_SHOWN, 'navigates to another bundled page')
+
+    const html = await readFile('frontend/index_no_js.html', 'utf8')
+    t.ok(html.length > 0, 'bundled resources are readable with fs')
+    newWindow.close()
+  })
+
   // TODO(@chicoxyzzy): should navigation of main window throw? should navigation of current window throw? should we even allow navigation?
   test('window.navigate', async (t) => {
     const newWindow = await application.createWindow({ index: counter, path: 'frontend/index_no_js.html' })
@@ -1,6 +1,10 @@
 import { test } from 'socket:test'
 import crypto from 'socket:crypto'
 import Buffer from 'socket:buffer'
+import ipc from 'socket:ipc'
+import path from 'socket:path'
+import fs from 'socket:fs/promises'
+import os from 'socket:os'
 
 test('crypto', async (t) => {
   t.equal(crypto.webcrypto, window.crypto, 'crypto.webcrypto is window.crypto')
@@ -28,3 +32,151 @@ test('crypto.rand64', (t) => {
   t.ok(randoms.every(b => typeof b === 'bigint'), 'crypto.rand64 returns a bigint')
   t.ok(randoms.some(b => b !== randoms[9]), 'crypto.rand64 returns a different bigint each time')
 })
+
+// native `crypto.*` routes take and return records framed as a little-endian
+// uint32 length followed by the record bytes
+function encodeRecords (records) {
+  const size = records.reduce((size, record) => size + 4 + record.length, 0)
+  const buffer = Buffer.alloc(size)
+  let offset = 0
+  for (const record of records) {
+    offset = buffer.writeUInt32LE(record.length, offset)
+    offset += Buffer.from(record).copy(buffer, offset)
+  }
+  return buffer
+}
+
+function decodeRecords (data) {
+  const buffer = Buffer.from(data)
+  const records = []
+  let offset = 0
+  while (offset + 4 <= buffer.length) {
+    const length = buffer.readUInt32LE(offset)
+    offset += 4
+    records.push(buffer.subarray(offset, offset + length))
+    offset += length
+  }
+  return records
+}
+
+async function native (command, params, records) {
+  const result = await ipc.write(command, params, encodeRecords(records), {
+    responseType: 'arraybuffer'
+  })
+
+  if (result.err) throw result.err
+  return decodeRecords(result.data)
+}
+
+test('crypto native sealed-box and signature routes', async (t) => {
+  const probe = await ipc.write('crypto.sign', { secretKey: '00' }, Buffer.alloc(0))
+  if (probe.err?.code === 'ERR_NOT_SUPPORTED') {
+    t.comment('skipping, runtime was built without libsodium')
+    return
+  }
+
+  await crypto.ready
+  const { sodium } = crypto
+  const keys = sodium.crypto_sign_keypair()
+  const publicKey = Buffer.from(keys.publicKey)
+  const secretKey = Buffer.from(keys.privateKey)
+
+  const [boxPublicKey] = await native('crypto.ed25519PublicKeyToCurve25519', {}, [publicKey])
+  const [boxSecretKey] = await native('crypto.ed25519SecretKeyToCurve25519', {}, [secretKey])
+  t.ok(boxPublicKey.equals(Buffer.from(sodium.crypto_sign_ed25519_pk_to_curve25519(publicKey))), 'public key conversion matches wasm')
+  t.ok(boxSecretKey.equals(Buffer.from(sodium.crypto_sign_ed25519_sk_to_curve25519(secretKey))), 'secret key conversion matches wasm')
+
+  const messages = Array.from({ length: 64 }, (_, i) => crypto.randomBytes(64 + i))
+  const keyParams = {
+    publicKey: boxPublicKey.toString('hex'),
+    secretKey: boxSecretKey.toString('hex')
+  }
+
+  const sealed = await native('crypto.seal', { publicKey: keyParams.publicKey }, messages)
+  t.equal(sealed.length, messages.length, 'crypto.seal returns a record for each message')
+
+  const opened = await native('crypto.open', keyParams, sealed)
+  t.ok(opened.every((message, i) => message.equals(messages[i])), 'crypto.open round trips crypto.seal')
+
+  const wasmOpened = Buffer.from(sodium.crypto_box_seal_open(sealed[0], boxPublicKey, boxSecretKey))
+  t.ok(wasmOpened.equals(messages[0]), 'wasm opens natively sealed boxes')
+
+  const signatures = await native('crypto.sign', { secretKey: secretKey.toString('hex') }, messages)
+  t.ok(Buffer.from(sodium.crypto_sign_detached(messages[0], secretKey)).equals(signatures[0]), 'crypto.sign matches wasm')
+
+  const signed = signatures.map((signature, i) => Buffer.concat([signature, messages[i]]))
+  signed.push(Buffer.concat([signatures[0], messages[1]]))
+
+  const verified = await native('crypto.verify', { publicKey: publicKey.toString('hex') }, signed)
+  t.ok(verified.slice(0, -1).every((record) => record[0] === 1), 'crypto.verify accepts valid signatures')
+  t.equal(verified.at(-1)[0], 0, 'crypto.verify rejects an invalid signature')
+
+  const result = await ipc.write('crypto.seal', { publicKey: 'zz' }, encodeRecords(messages))
+  t.equal(result.err?.code, 'ERR_INVALID_KEY', 'invalid keys are rejected')
+})
+
+test('crypto native sealed-box throughput', async (t) => {
+  const probe = await ipc.write('crypto.sign', { secretKey: '00' }, Buffer.alloc(0))
+  if (probe.err?.code === 'ERR_NOT_SUPPORTED') return
+
+  await crypto.ready
+  const { sodium } = crypto
+  const keys = sodium.crypto_box_keypair()
+  const publicKey = Buffer.from(keys.publicKey)
+  const messages = Array.from({ length: 1024 }, () => crypto.randomBytes(1024))
+
+  let start = performance.now()
+  for (const message of messages) {
+    sodium.crypto_box_seal(message, publicKey)
+  }
+  const wasmElapsed = performance.now() - start
+
+  start = performance.now()
+  const sealed = await native('crypto.seal', { publicKey: publicKey.toString('hex') }, messages)
+  const elapsed = performance.now() - start
+
+  t.equal(sealed.length, messages.length, 'all messages sealed')
+  t.comment(`crypto.seal throughput: wasm ${(messages.length / wasmElapsed * 1000).toFixed(0)} ops/s, native ${(messages.length / elapsed * 1000).toFixed(0)} ops/s`)
+})
+
+test('crypto native batch and descriptor hashing', async (t) => {
+  const messages = Array.from({ length: 256 }, (_, i) => crypto.randomBytes(i + 1))
+  const expected = await Promise.all(messages.map((message) => crypto.createDigest('SHA-256', message)))
+
+  let start = performance.now()
+  await Promise.all(messages.map((message) => crypto.createDigest('SHA-256', message)))
+  const subtleElapsed = performance.now() - start
+
+  start = performance.now()
+  const digests = await native('crypto.hash', { algorithm: 'sha256' }, messages)
+  const elapsed = performance.now() - start
+
+  t.equal(digests.length, messages.length, 'crypto.hash returns a digest for each record')
+  t.ok(digests.every((digest, i) => digest.equals(expected[i])), 'crypto.hash sha256 matches crypto.subtle')
+  t.comment(`sha256 batch of ${messages.length}: subtle ${subtleElapsed.toFixed(2)}ms, native ${elapsed.toFixed(2)}ms`)
+
+  const filename = path.join(os.tmpdir(), `crypto-hash-${Date.now()}.bin`)
+  const contents = crypto.randomBytes(256 * 1024)
+  await fs.writeFile(filename, contents)
+
+  const handle = await fs.open(filename, 'r')
+  const result = await ipc.send('crypto.hashDescriptor', { id: handle.id })
+  t.equal(result.data?.digest, (await crypto.createDigest('SHA-256', contents)).toString('hex'), 'crypto.hashDescriptor streams the file')
+  t.equal(result.data?.size, contents.length, 'crypto.hashDescriptor hashes the whole file')
+
+  const blake2b = await ipc.send('crypto.hashDescriptor', { id: handle.id, algorithm: 'blake2b', size: 64 })
+  if (blake2b.err?.code !== 'ERR_NOT_SUPPORTED') {
+    const [digest] = await native('crypto.hash', { algorithm: 'blake2b', size: 64 }, [contents])
+    t.equal(blake2b.data?.digest, digest.toString('hex'), 'blake2b descriptor and batch digests agree')
+  }
+
+  // closing while the hash runs on the threadpool does not cut it short
+  const pending = ipc.send('crypto.hashDescriptor', { id: handle.id })
+  await handle.close()
+  const racing = await pending
+  t.equal(racing.data?.size, contents.length, 'crypto.hashDescriptor keeps the file open until it is hashed')
+  await fs.unlink(filename)
+
+  const closed = await ipc.send('crypto.hashDescriptor', { id: handle.id })
+  t.equal(closed.err?.code, 'ENOTOPEN', 'closed descriptors are rejected')
+})
@@ -6,6 +6,7 @@ import crypto from 'socket:crypto'
 import Buffer from 'socket:buffer'
 import dgram from 'socket:dgram'
 import util from 'socket:util'
+import ipc from 'socket:ipc'
 
 // node compat
 /*
@@ -250,6 +251,70 @@ test('udp send callback', async (t) => {
   t.ok(result, 'send callback called')
 })
 
+test('udp6 bind, connect, send over ::1', async (t) => {
+  if (process.env.SSC_ANDROID_CI) return
+
+  const payload = makePayload()
+  const server = dgram.createSocket('udp6')
+  const client = dgram.createSocket('udp6')
+
+  const msg = new Promise((resolve, reject) => {
+    server.on('message', (buf, info) => resolve({ buf, info }))
+    server.on('error', reject)
+  })
+
+  server.on('listening', () => {
+    client.connect(41238, '::1', (err) => {
+      if (err) return t.fail(err.message)
+      t.deepEqual(
+        client.remoteAddress(),
+        { address: '::1', port: 41238, family: 'IPv6' },
+        'client.remoteAddress() returns the IPv6 remote address'
+      )
+      client.send(Buffer.from(payload))
+    })
+  })
+
+  server.bind(41238, '::1')
+
+  try {
+    const { buf, info } = await msg
+    t.ok(Buffer.from(buf).toString() === payload, `${payload.length} bytes match`)
+    t.equal(info.address, '::1', 'rinfo.address is ::1')
+    t.equal(info.family, 'IPv6', 'rinfo.family is IPv6')
+  } catch (err) {
+    t.fail(err, err?.message)
+  }
+
+  server.close()
+  client.close()
+})
+
+test('udp6 dual-stack socket exchanges datagrams with udp4', async (t) => {
+  if (process.env.SSC_ANDROID_CI) return
+
+  const server = dgram.createSocket('udp6')
+  const client = dgram.createSocket('udp4')
+
+  const request = new Promise((resolve) => server.once('message', (buf, info) => resolve(info)))
+  const reply = new Promise((resolve) => client.once('message', resolve))
+
+  await new Promise((resolve) => server.bind(41239, '::', resolve))
+  await new Promise((resolve) => client.bind(41240, '127.0.0.1', resolve))
+
+  client.send(Buffer.from('ping'), 41239, '127.0.0.1')
+
+  const info = await request
+  t.equal(info.address, '::ffff:127.0.0.1', 'IPv4 sender is seen as an IPv4-mapped address')
+
+  // replying to the plain IPv4 address is mapped natively
+  server.send(Buffer.from('pong'), 41240, '127.0.0.1')
+  t.equal(Buffer.from(await reply).toString(), 'pong', 'IPv4 peer receives the reply')
+
+  server.close()
+  client.close()
+})
+
 test('udp createSocket AbortSignal', async (t) => {
   const controller = new AbortController()
   const { signal } = controller
@@ -322,6 +387,218 @@ test('client ~> server (~512 messages)', async (t) => {
   ])
 })
 
+test('udp segmented send with GRO over loopback', async (t) => {
+  if (process.env.SSC_ANDROID_CI) return
+
+  const segmentSize = 1200
+  const segments = 512
+  const server = dgram.createSocket({ type: 'udp4', gro: true, recvBufferSize: 8 * 1024 * 1024 })
+  const client = dgram.createSocket({ type: 'udp4', segmentSize })
+
+  const payload = Buffer.alloc(segmentSize * segments)
+  for (let i = 0; i < payload.length; ++i) {
+    payload[i] = Math.floor(i / segmentSize) & 0xff
+  }
+
+  let received = 0
+  let intact = true
+  const done = new Promise((resolve) => {
+    const timer = setTimeout(resolve, 1000)
+    server.on('message', (message) => {
+      // every datagram carries one byte value, its index in the payload
+      intact = intact && message.length === segmentSize && message.every((b) => b === message[0])
+      if (++received === segments) {
+        clearTimeout(timer)
+        resolve()
+      }
+    })
+  })
+
+  await new Promise((resolve) => server.bind(41241, '127.0.0.1', resolve))
+
+  const start = performance.now()
+  await new Promise((resolve, reject) => {
+    client.send(payload, 41241, '127.0.0.1', (err) => err ? reject(err) : resolve())
+  })
+
+  await done
+  const elapsed = (performance.now() - start) / 1000
+
+  t.ok(received > 0, `${received}/${segments} datagrams received`)
+  t.ok(intact, 'each message is a single datagram of segmentSize bytes')
+  t.comment(`udp segmented send: ${(received * segmentSize / elapsed / 1024 / 1024).toFixed(1)} MiB/s`)
+
+  server.close()
+  client.close()
+})
+
+test('udp ephemeral sends from 10k peers', async (t) => {
+  if (process.env.SSC_ANDROID_CI) return
+
+  const peers = 10000
+  const concurrency = 500
+  const server = dgram.createSocket({ type: 'udp4', recvBufferSize: 4 * 1024 * 1024 })
+  const payload = Buffer.from('ping')
+  let received = 0
+  let failed = 0
+
+  server.on('message', () => received++)
+  await new Promise((resolve) => server.bind(41242, '127.0.0.1', resolve))
+
+  const start = performance.now()
+
+  for (let i = 0; i < peers; i += concurrency) {
+    const sends = []
+
+    // every send uses its own ephemeral peer ID, backed by pooled handles
+    for (let j = 0; j < concurrency; ++j) {
+      sends.push(ipc.write('udp.send', {
+        id: crypto.rand64(),
+        port: 41242,
+        address: '127.0.0.1',
+        ephemeral: true
+      }, payload))
+    }
+
+    for (const { err } of await Promise.all(sends)) {
+      if (err) failed++
+    }
+  }
+
+  const elapsed = (performance.now() - start) / 1000
+  await new Promise((resolve) => setTimeout(resolve, 100))
+
+  t.equal(failed, 0, `${peers} ephemeral sends succeeded`)
+  t.ok(received > 0, `${received}/${peers} datagrams received`)
+  t.comment(`udp ephemeral sends: ${Math.round(peers / elapsed)} sends/s`)
+
+  // the pool now holds handles bound to IPv4, an IPv6 send must not get one
+  const server6 = dgram.createSocket('udp6')
+  const received6 = new Promise((resolve) => server6.once('message', resolve))
+  await new Promise((resolve) => server6.bind(41245, '::1', resolve))
+
+  const { err } = await ipc.write('udp.send', {
+    id: crypto.rand64(),
+    port: 41245,
+    address: '::1',
+    ephemeral: true
+  }, payload)
+
+  t.ok(!err, `ephemeral IPv6 send after IPv4 sends succeeded${err ? ': ' + err.message : ''}`)
+  if (!err) t.equal(String(await received6), 'ping', 'IPv6 datagram received')
+
+  server.close()
+  server6.close()
+})
+
+test('udp native keepalive reports reachability', async (t) => {
+  const client = dgram.createSocket('udp4')
+  const server = dgram.createSocket('udp4')
+  const target = { address: '127.0.0.1', port: 41243 }
+  const pings = []
+
+  server.on('message', (message, rinfo) => {
+    pings.push(String(message))
+    server.send('pong', rinfo.port, rinfo.address)
+  })
+
+  await new Promise((resolve) => server.bind(target.port, target.address, resolve))
+  await new Promise((resolve) => client.bind(41244, '127.0.0.1', resolve))
+
+  const reachable = new Promise((resolve) => client.once('keepalive', resolve))
+  const count = await client.startKeepalive([target], {
+    payload: 'ping',
+    interval: 100,
+    timeout: 300,
+    punchInterval: 20
+  })
+
+  t.equal(count, 1, 'schedules the target')
+  const event = await reachable
+  t.equal(event.reachable, true, 'target becomes reachable')
+  t.equal(event.port, target.port, 'reports the target port')
+  t.equal(pings[0], 'ping', 'sends the keepalive payload')
+
+  const [state] = await client.getKeepaliveState()
+  t.ok(state.reachable && state.sent >= 1 && state.received >= 1, 'reports target state')
+
+  const unreachable = new Promise((resolve) => client.once('keepalive', resolve))
+  server.close()
+
+  const timeout = await unreachable
+  t.equal(timeout.reachable, false, 'target becomes unreachable after the timeout')
+  t.ok(timeout.idle >= 300, 'reports how long the target has been idle')
+
+  t.equal(await client.stopKeepalive(), 0, 'stops all targets')
+  client.close()
+})
+
+test('udp loopback throughput', async (t) => {
+  if (process.env.SSC_ANDROID_CI) return
+
+  const address = '127.0.0.1'
+  const port = 41238
+  const count = 4096
+  const buffer = crypto.randomBytes(1024)
+  const server = dgram.createSocket('udp4')
+  const client = dgram.createSocket('udp4')
+  let received = 0
+  let start = 0
+  let end = 0
+
+  await new Promise((resolve) => {
+    // loopback can still drop datagrams under load, measure what arrives
+    let timeout = null
+    const done = () => {
+      clearTimeout(timeout)
+      resolve()
+    }
+
+    server.on('message', () => {
+      end = performance.now()
+      clearTimeout(timeout)
+      timeout = setTimeout(done, 500)
+
+      if (++received === count) {
+        done()
+      }
+    })
+
+    server.bind(port, address, () => {
+      client.connect(port, address, (err) => {
+        if (err) return t.ifError(err)
+        start = performance.now()
+        timeout = setTimeout(done, 2000)
+
+        // keep a window of sends in flight, so this measures throughput
+        // rather than one IPC round trip per packet
+        let sent = 0
+        const send = () => {
+          if (sent < count) {
+            sent++
+            client.send(buffer, send)
+          }
+        }
+
+        for (let i = 0; i < 64; ++i) {
+          send()
+        }
+      })
+    })
+  })
+
+  const elapsed = Math.max(end - start, 1)
+  const rate = received / (elapsed / 1000)
+
+  t.comment(`udp throughput ${rate.toFixed(0)} packets/s (${received}/${count} received in ${elapsed.toFixed(1)}ms)`)
+  t.ok(received > 0, 'packets received over loopback')
+
+  await Promise.all([
+    util.promisify(server.close.bind(server))(),
+    util.promisify(client.close.bind(client))()
+  ])
+})
+
 test('connect + disconnect', async (t) => {
   await new Promise((resolve) => {
     const address = '127.0.0.1'
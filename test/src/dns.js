@@ -1,6 +1,7 @@
 import { test } from 'socket:test'
 import dns from 'socket:dns'
 import os from 'socket:os'
+import ipc from 'socket:ipc'
 
 // node compat
 // import dns from 'node:dns'
@@ -138,3 +139,64 @@ test('dns.promises.lookup bad hostname', async t => {
     t.equal(err.message, `getaddrinfo EAI_AGAIN ${BAD_HOSTNAME}`, 'returns an error on unexisting hostname')
   }
 })
+
+test('dns.lookup local addresses with all', async t => {
+  const hostname = 'socket-test.local'
+
+  // pages can only set local addresses in debug builds
+  const result = await ipc.send('dns.setLocalAddresses', { hostname, addresses: '10.0.0.1,fd00::1' })
+  if (result.err) {
+    return t.comment('skipping, dns.setLocalAddresses is only available in debug builds')
+  }
+
+  const before = (await ipc.send('dns.getStats')).data
+
+  const addresses = await dns.promises.lookup(hostname, { family: 0, all: true })
+  t.deepEqual(addresses, [
+    { address: '10.0.0.1', family: 4 },
+    { address: 'fd00::1', family: 6 }
+  ], 'resolves every local address')
+
+  const info = await dns.promises.lookup(hostname, 4)
+  t.equal(info.address, '10.0.0.1', 'resolves the IPv4 address')
+  t.equal(info.family, 4, 'is IPv4 family')
+
+  await new Promise(resolve => {
+    dns.lookup(hostname, { family: 0, all: true }, (err, addresses) => {
+      if (err) return t.fail(err)
+      t.equal(addresses.length, 2, 'callback receives every address')
+      resolve()
+    })
+  })
+
+  const after = (await ipc.send('dns.getStats')).data
+  t.equal(after.hits - before.hits, 1, 'repeated lookup is answered from the cache')
+  t.ok(after.hitRatio > 0 && after.hitRatio <= 1, 'reports a hit ratio')
+
+  await ipc.send('dns.setLocalAddresses', { hostname, addresses: '' })
+
+  try {
+    await dns.promises.lookup(hostname, 4)
+    t.fail('removed local name should not resolve from the cache')
+  } catch (err) {
+    t.ok(err, 'removing a local name drops its cached answers')
+  }
+})
+
+test('dns.lookup coalesces concurrent lookups', async t => {
+  const count = 16
+
+  await ipc.send('dns.clearCache')
+  const before = (await ipc.send('dns.getStats')).data
+
+  const results = await Promise.all(Array.from({ length: count }, () => {
+    return dns.promises.lookup('localhost', 4)
+  }))
+
+  t.ok(results.every(info => info.address === results[0].address), 'all lookups agree')
+
+  const after = (await ipc.send('dns.getStats')).data
+  const shared = (after.hits - before.hits) + (after.coalesced - before.coalesced)
+  t.equal(after.misses - before.misses, 1, 'only one lookup reaches the resolver')
+  t.equal(shared, count - 1, 'other lookups are coalesced or cached')
+})
@@ -14,6 +14,8 @@ import './os.js'
 import './process.js'
 import './path.js'
 import './dgram.js'
+import './net.js'
+import './relay.js'
 import './dns.js'
 import './crypto.js'
 import './util.js'
@@ -23,3 +25,4 @@ import './application.js'
 import './copy-map.js'
 import './microtask.js'
 import './commonjs.js'
+import './modules.js'
@@ -145,3 +145,28 @@ test('ipc.send success', async (t) => {
   const { data } = response
   t.ok(typeof data === 'object', 'sendSync works')
 })
+
+test('ipc.send event loop dispatch latency', async (t) => {
+  const samples = []
+  const percentile = (p) => samples[Math.min(samples.length - 1, Math.floor(samples.length * p))]
+
+  for (let i = 0; i < 200; ++i) {
+    // let the event loop go idle every few iterations so wakeup latency is measured
+    if (i % 10 === 0) {
+      await new Promise((resolve) => setTimeout(resolve, 50))
+    }
+
+    const start = performance.now()
+    // `udp.readStop` is dispatched to the core event loop, an unknown id replies immediately
+    await ipc.send('udp.readStop', { id: '0' })
+    samples.push(performance.now() - start)
+  }
+
+  samples.sort((a, b) => a - b)
+
+  const p50 = percentile(0.5)
+  const p99 = percentile(0.99)
+
+  t.comment(`dispatch latency p50=${p50.toFixed(3)}ms p99=${p99.toFixed(3)}ms`)
+  t.ok(p50 < 32, 'p50 dispatch latency is less than EVENT_LOOP_POLL_TIMEOUT (32ms)')
+})
@@ -0,0 +1,67 @@
+import test from 'socket:test'
+import os from 'socket:os'
+
+const modules = [
+  'application',
+  'bluetooth',
+  'buffer',
+  'console',
+  'crypto',
+  'dgram',
+  'diagnostics',
+  'dns',
+  'errors',
+  'events',
+  'fs',
+  'fs/promises',
+  'gc',
+  'hooks',
+  'ipc',
+  'module',
+  'net',
+  'os',
+  'path',
+  'peer',
+  'process',
+  'stream',
+  'stream-relay',
+  'test',
+  'util',
+  'window'
+]
+
+// a specifier with a query the page has not imported before is a new
+// module record, so each import is requested from the scheme handler again.
+// The proxy body does not depend on the query and comes from the proxy
+// cache, this measures module loading rather than proxy rendering
+if (os.platform() === 'linux') {
+  test('socket: module cold start', async (t) => {
+    const query = `?cold=${Date.now()}`
+    const start = performance.now()
+    const imported = await Promise.all(modules.map((name) => import(`socket:${name}${query}`)))
+    const elapsed = performance.now() - start
+
+    t.equal(imported.length, modules.length, 'all api modules imported')
+    t.ok(imported.every((module) => module && typeof module === 'object'), 'all api modules resolved')
+    t.comment(`imported ${modules.length} modules in ${elapsed.toFixed(3)}ms`)
+  })
+
+  test('socket: module import map', async (t) => {
+    const script = document.querySelector('script[type="importmap"]')
+
+    if (!globalThis.__args.config.core_preload_modules) {
+      t.equal(script, null, 'no import map without [core] preload_modules')
+      return
+    }
+
+    t.ok(script, 'import map is installed with [core] preload_modules')
+
+    const { imports } = JSON.parse(script.textContent)
+    t.ok(modules.every((name) => imports[`socket:${name}`]), 'import map resolves every api module')
+
+    // mapped and proxied specifiers load the same module
+    const mapped = await import('socket:path')
+    const proxied = await import(`socket:path?proxied=${Date.now()}`)
+    t.equal(mapped.default, proxied.default, 'mapped module is the proxied module')
+  })
+}
@@ -0,0 +1,135 @@
+import { test } from 'socket:test'
+import process from 'socket:process'
+import Buffer from 'socket:buffer'
+import net from 'socket:net'
+import ipc from 'socket:ipc'
+
+const listen = (server, port, host = '127.0.0.1') => new Promise((resolve, reject) => {
+  server.once('error', reject)
+  server.listen(port, host, resolve)
+})
+
+const connect = (port, host = '127.0.0.1') => new Promise((resolve, reject) => {
+  const socket = net.connect(port, host)
+  socket.once('error', reject)
+  socket.once('connect', () => resolve(socket))
+})
+
+const close = (server) => new Promise((resolve) => server.close(resolve))
+
+test('net echo server and client over loopback', async (t) => {
+  if (process.env.SSC_ANDROID_CI) return
+
+  const server = net.createServer((socket) => {
+    socket.on('data', (data) => socket.write(data))
+  })
+
+  await listen(server, 41250)
+  t.equal(server.address()?.port, 41250, 'server is listening')
+
+  const socket = await connect(41250)
+  t.equal(socket.remotePort, 41250, 'client is connected')
+
+  const state = await ipc.send('tcp.getState', { id: socket.id })
+  t.equal(state.data?.connected, true, 'tcp.getState reports connected')
+
+  const echoed = new Promise((resolve) => socket.once('data', resolve))
+  socket.write(Buffer.from('hello'))
+  t.equal(Buffer.from(await echoed).toString(), 'hello', 'data is echoed')
+
+  // a zero length write has nothing to send and completes right away
+  const err = await new Promise((resolve) => socket.write(Buffer.alloc(0), resolve))
+  t.ok(!err, 'zero length write succeeds')
+
+  const after = new Promise((resolve) => socket.once('data', resolve))
+  socket.write(Buffer.from('still open'))
+  t.equal(Buffer.from(await after).toString(), 'still open', 'socket is usable after a zero length write')
+
+  socket.destroy()
+  await close(server)
+})
+
+test('net echo over ::1', async (t) => {
+  if (process.env.SSC_ANDROID_CI) return
+
+  const server = net.createServer((socket) => {
+    socket.on('data', (data) => socket.write(data))
+  })
+
+  await listen(server, 41252, '::1')
+  t.equal(server.address()?.family, 'IPv6', 'server is listening on IPv6')
+
+  const socket = await connect(41252, '::1')
+  t.equal(socket.remoteAddress, '::1', 'client is connected to ::1')
+  t.equal(socket.remoteFamily, 'IPv6', 'remote family is IPv6')
+
+  const echoed = new Promise((resolve) => socket.once('data', resolve))
+  socket.write(Buffer.from('hello ipv6'))
+  t.equal(Buffer.from(await echoed).toString(), 'hello ipv6', 'data is echoed')
+
+  socket.destroy()
+  await close(server)
+})
+
+test('net.isIP', (t) => {
+  t.equal(net.isIP('127.0.0.1'), 4, 'IPv4 address')
+  t.equal(net.isIP('::1'), 6, 'IPv6 loopback')
+  t.equal(net.isIP('::ffff:127.0.0.1'), 6, 'IPv4-mapped IPv6 address')
+  t.equal(net.isIP('fe80::1%en0'), 6, 'scoped IPv6 address')
+  t.equal(net.isIP('localhost'), 0, 'hostname is not an IP')
+})
+
+test('net loopback latency and throughput', async (t) => {
+  if (process.env.SSC_ANDROID_CI) return
+
+  let received = 0
+  let onreceived = null
+  const server = net.createServer((socket) => {
+    socket.setNoDelay(true)
+    socket.on('data', (data) => {
+      if (data.length === 64) {
+        socket.write(data)
+      } else {
+        received += data.length
+        if (onreceived && received >= onreceived.size) onreceived.resolve()
+      }
+    })
+  })
+
+  await listen(server, 41251)
+  const socket = await connect(41251)
+  socket.setNoDelay(true)
+
+  const ping = Buffer.alloc(64, 1)
+  const rounds = 256
+  let start = performance.now()
+
+  for (let i = 0; i < rounds; ++i) {
+    const pong = new Promise((resolve) => socket.once('data', resolve))
+    socket.write(ping)
+    await pong
+  }
+
+  const latency = (performance.now() - start) / rounds * 1000
+  t.ok(latency > 0, 'ping pong round trips complete')
+  t.comment(`tcp loopback latency: ${latency.toFixed(0)}us per round trip`)
+
+  const chunk = Buffer.alloc(64 * 1024 - 1, 2)
+  const size = chunk.length * 256
+  const done = new Promise((resolve) => { onreceived = { size, resolve } })
+  start = performance.now()
+
+  for (let i = 0; i < 256; ++i) {
+    if (!socket.write(chunk)) {
+      await new Promise((resolve) => socket.once('drain', resolve))
+    }
+  }
+
+  await done
+  const elapsed = (performance.now() - start) / 1000
+  t.equal(received, size, 'all bytes received')
+  t.comment(`tcp loopback throughput: ${(size / elapsed / 1024 / 1024).toFixed(1)} MiB/s`)
+
+  socket.destroy()
+  await close(server)
+})
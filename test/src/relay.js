@@ -0,0 +1,144 @@
+import { test } from 'socket:test'
+import process from 'socket:process'
+import crypto from 'socket:crypto'
+import Buffer from 'socket:buffer'
+import dgram from 'socket:dgram'
+import util from 'socket:util'
+import ipc from 'socket:ipc'
+import path from 'socket:path'
+import os from 'socket:os'
+
+const PACKET_SIZE = 1158
+const PUBLISH = 5
+
+function createPublishPacket (clusterId, message, {
+  packetId = crypto.randomBytes(32),
+  previousId = Buffer.alloc(32),
+  index = -1
+} = {}) {
+  const buffer = Buffer.alloc(PACKET_SIZE)
+  let offset = 0
+  offset = buffer.writeInt8(PUBLISH, offset)
+  offset = buffer.writeInt8(1, offset) // version
+  offset = buffer.writeUInt32BE(0, offset) // hops
+  offset = buffer.writeUInt32BE(0, offset) // clock
+  offset = buffer.writeInt32BE(index, offset)
+  packetId.copy(buffer, offset); offset += 32
+  clusterId.copy(buffer, offset); offset += 32
+  previousId.copy(buffer, offset); offset += 32
+  offset += 32 * 3 // nextId, to, usr1
+  offset = buffer.writeUInt16BE(message.length, offset)
+  Buffer.from(message).copy(buffer, offset)
+  return buffer
+}
+
+const bind = (socket, port) => new Promise((resolve) => socket.bind(port, '127.0.0.1', resolve))
+const send = (socket, buffer, port) => new Promise((resolve) => socket.send(buffer, port, '127.0.0.1', resolve))
+const sleep = (ms) => new Promise((resolve) => setTimeout(resolve, ms))
+
+test('relay forwards, deduplicates and delivers publish packets', async (t) => {
+  if (process.env.SSC_ANDROID_CI) return
+
+  const clusterId = crypto.randomBytes(32)
+  const otherClusterId = crypto.randomBytes(32)
+  const relay = dgram.createSocket('udp4')
+  const sender = dgram.createSocket('udp4')
+  const receiver = dgram.createSocket('udp4')
+  const delivered = []
+  const forwarded = []
+
+  relay.on('message', (message) => delivered.push(message))
+  receiver.on('message', (message) => forwarded.push(message))
+
+  await bind(relay, 41240)
+  await bind(sender, 41241)
+  await bind(receiver, 41242)
+
+  let result = await ipc.send('relay.start', {
+    id: relay.id,
+    clusters: clusterId.toString('hex')
+  })
+
+  t.ok(!result.err, 'relay.start')
+
+  result = await ipc.send('relay.addPeer', { id: relay.id, address: '127.0.0.1', port: 41242 })
+  t.ok(!result.err, 'relay.addPeer')
+
+  const packet = createPublishPacket(otherClusterId, 'hello')
+  await send(sender, packet, 41240)
+  await send(sender, packet, 41240)
+  await send(sender, createPublishPacket(clusterId, 'hello'), 41240)
+  await sleep(256)
+
+  t.equal(forwarded.length, 1, 'packet for another cluster is forwarded once')
+  t.equal(forwarded[0]?.readUInt32BE(2), 2, 'forwarded packet hops are taxed')
+  t.equal(delivered.length, 1, 'only the packet for a subscribed cluster is delivered')
+
+  result = await ipc.send('relay.getState', { id: relay.id })
+  t.equal(result.data?.duplicates, 1, 'duplicate packet is dropped')
+  t.equal(result.data?.cached, 2, 'publish packets are cached')
+
+  result = await ipc.send('relay.stop', { id: relay.id })
+  t.ok(!result.err, 'relay.stop')
+
+  await Promise.all([
+    util.promisify(relay.close.bind(relay))(),
+    util.promisify(sender.close.bind(sender))(),
+    util.promisify(receiver.close.bind(receiver))()
+  ])
+})
+
+test('relay packet cache insert, get, compose and snapshot', async (t) => {
+  const clusterId = crypto.randomBytes(32)
+  const headId = crypto.randomBytes(32)
+  const lastId = crypto.randomBytes(32)
+  const socket = dgram.createSocket('udp4')
+  const snapshot = path.join(os.tmpdir(), `relay-cache-${Date.now()}.bin`)
+
+  await bind(socket, 41243)
+
+  let result = await ipc.send('relay.start', { id: socket.id })
+  t.ok(!result.err, 'relay.start')
+
+  const packets = [
+    createPublishPacket(clusterId, '{"indexes":2}', { packetId: headId, index: 0 }),
+    createPublishPacket(clusterId, 'world', { packetId: lastId, previousId: headId, index: 2 }),
+    createPublishPacket(clusterId, 'hello ', { previousId: headId, index: 1 }),
+    // later publishes chained off the head and off the last fragment
+    createPublishPacket(clusterId, 'after head', { previousId: headId }),
+    createPublishPacket(clusterId, 'after last', { previousId: lastId })
+  ]
+
+  for (const packet of packets) {
+    result = await ipc.write('relay.cacheInsert', { id: socket.id }, packet)
+    t.equal(result.data?.inserted, true, 'packet inserted')
+  }
+
+  result = await ipc.write('relay.cacheInsert', { id: socket.id }, packets[0])
+  t.equal(result.data?.inserted, false, 'duplicate packet is not inserted')
+
+  const packetId = headId.toString('hex')
+  result = await ipc.send('relay.cacheHas', { id: socket.id, packetId })
+  t.equal(result.data?.has, true, 'relay.cacheHas')
+
+  result = await ipc.request('relay.cacheGet', { id: socket.id, packetId }, { responseType: 'arraybuffer' })
+  t.ok(Buffer.from(result.data).equals(packets[0]), 'relay.cacheGet returns the encoded packet')
+
+  result = await ipc.request('relay.cacheCompose', { id: socket.id, packetId }, { responseType: 'arraybuffer' })
+  t.equal(Buffer.from(result.data).toString(), 'hello world', 'relay.cacheCompose orders the chain by index')
+
+  result = await ipc.request('relay.cacheCompose', { id: socket.id, packetId: lastId.toString('hex') }, { responseType: 'arraybuffer' })
+  t.equal(Buffer.from(result.data).toString(), 'hello world', 'relay.cacheCompose from a fragment excludes following publishes')
+
+  result = await ipc.send('relay.cacheSnapshot', { id: socket.id, path: snapshot })
+  t.equal(result.data?.packets, 5, 'relay.cacheSnapshot')
+
+  await ipc.send('relay.stop', { id: socket.id })
+  await ipc.send('relay.start', { id: socket.id })
+
+  result = await ipc.send('relay.cacheRestore', { id: socket.id, path: snapshot })
+  t.equal(result.data?.packets, 5, 'relay.cacheRestore')
+
+  await ipc.send('relay.stop', { id: socket.id })
+  await util.promisify(socket.close.bind(socket))()
+})